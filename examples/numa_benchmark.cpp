@@ -0,0 +1,49 @@
+#include <iomanip>
+#include <iostream>
+#include "matrix.hpp"
+#include "util.hpp"
+#include "numa.hpp"
+#include "timer.hpp"
+
+// Compares parallel Strassen with memory placed on the nodes that use it (first touch, bound bands)
+// against memory interleaved over all nodes. On a machine with one node both should take the same time.
+int main(int argc, char **argv) {
+    // by default the smallest matrices of doubles that are large enough to be placed (numa_min_placed_bytes)
+    unsigned int size = argc > 1 ? std::stoul(argv[1]) : 2048;
+    unsigned int repetitions = argc > 2 ? std::stoul(argv[2]) : 3;
+
+    NumaTopology topology = NumaTopology::detect();
+    std::cout << "NUMA nodes: " << topology.nodes.size() << ", CPUs: " << topology.cpu_count() << std::endl;
+    for (unsigned int i = 0; i < topology.nodes.size(); ++i) {
+        std::cout << "  node " << topology.nodes[i] << ": " << topology.cpus[i].size() << " CPUs" << std::endl;
+    }
+    std::cout << "Multiplying " << size << "x" << size << " matrices, best of " << repetitions << " runs."
+              << std::endl << std::fixed << std::setprecision(4);
+
+    Matrix<double> A = random_float_matrix(size, size);
+    Matrix<double> B = random_float_matrix(size, size);
+
+    for (NumaPlacement placement : {NumaPlacement::local, NumaPlacement::interleaved}) {
+        bool large = std::size_t(size) * size * sizeof(double) >= numa_min_placed_bytes;
+        bool placed = numa_place(A, topology, placement) && numa_place(B, topology, placement);
+
+        NumaOptions options;
+        options.placement = placement;
+
+        double best = 0;
+        Timer t;
+        for (unsigned int r = 0; r < repetitions; ++r) {
+            t.start();
+            Matrix<double> C = multiply_strassen_numa(A, B, topology, options);
+            double time = t.time_elapsed();
+            best = r == 0 ? time : std::min(best, time);
+        }
+
+        std::cout << (placement == NumaPlacement::local ? "Local placement:       " : "Interleaved placement: ")
+                  << "\t" << best << "s"
+                  << (placed ? "" : large ? " (placement is not supported)" : " (matrices are too small to be placed)")
+                  << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_ALGORITHM_HPP
+#define FAST_MATRIX_MULTIPLICATION_ALGORITHM_HPP
+
+#include <algorithm>
+#include "matrix.hpp"
+#include "multiply_classic.hpp"
+#include "multiply_laderman.hpp"
+#include "multiply_rectangular.hpp"
+#include "multiply_strassen.hpp"
+#include "scheme.hpp"
+
+// exact algorithms that can be chosen at runtime,
+// used by drivers that split large products into smaller in-memory products
+enum class Algorithm {
+    classic,
+    strassen,
+    laderman,
+    // Strassen's and rectangular schemes, chosen by shape of the product on every level
+    rectangular
+};
+
+// product A B calculated with chosen algorithm
+template<class Scalar>
+Matrix<Scalar> multiply(const Matrix<Scalar> &A, const Matrix<Scalar> &B, Algorithm algorithm) {
+    switch (algorithm) {
+        case Algorithm::strassen:
+            return multiply_strassen_dynamic(A, B);
+        case Algorithm::laderman:
+            return multiply_laderman(A, B);
+        case Algorithm::rectangular:
+            return multiply_rectangular(A, B);
+        default:
+            return multiply_classic(A, B);
+    }
+}
+
+// coefficients of chosen algorithm (classic multiplication has no scheme, nullptr is returned),
+// rectangular algorithm uses Strassen's scheme when shape of the product is not known
+inline const Scheme *algorithm_scheme(Algorithm algorithm) {
+    switch (algorithm) {
+        case Algorithm::strassen:
+        case Algorithm::rectangular:
+            return &strassen_scheme();
+        case Algorithm::laderman:
+            return &laderman_scheme();
+        default:
+            return nullptr;
+    }
+}
+
+// coefficients of chosen algorithm for one level of product rows x inner x cols
+inline const Scheme *algorithm_scheme(Algorithm algorithm, unsigned int rows, unsigned int inner, unsigned int cols) {
+    if (algorithm == Algorithm::rectangular) {
+        return &rectangular_scheme_for(rows, inner, cols);
+    }
+    return algorithm_scheme(algorithm);
+}
+
+// scheme that multiply() with chosen algorithm uses on the top level of product rows x inner x cols,
+// nullptr if the product is multiplied classically
+inline const Scheme *algorithm_recursion_scheme(Algorithm algorithm, unsigned int rows, unsigned int inner,
+                                                unsigned int cols) {
+    const unsigned int smallest = std::min(rows, std::min(inner, cols));
+    switch (algorithm) {
+        case Algorithm::strassen:
+            return smallest > strassen_threshold ? &strassen_scheme() : nullptr;
+        case Algorithm::laderman:
+            return smallest > laderman_threshold ? &laderman_scheme() : nullptr;
+        case Algorithm::rectangular:
+            return rectangular_choice(rows, inner, cols);
+        default:
+            return nullptr;
+    }
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_ALGORITHM_HPP
@@ -0,0 +1,277 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_BIT_MATRIX_HPP
+#define FAST_MATRIX_MULTIPLICATION_BIT_MATRIX_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "matrix.hpp"
+#include "modular.hpp"
+#include "multiply_strassen.hpp"
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+// Boolean matrices packed 64 entries per word, and their products.
+//
+// Boolean product (OR of ANDs) is calculated with the Method of Four Russians: for every group of 8 rows
+// of B, all 256 ORs of subsets of these rows are precomputed, then every row of C needs one table lookup
+// (by 8 bits of A) and one OR of a whole row per group, instead of 8. Rows are combined word by word
+// with AVX-512 or AVX2 when available. The same algorithm with XOR gives products over Z/2.
+// For very large matrices, Boolean product can instead be calculated as an integer product modulo
+// a prime larger than the inner dimension (nonzero counts are nonzero residues) with Strassen's algorithm.
+
+class BitMatrix {
+public:
+    // number of rows in this matrix
+    unsigned int rows;
+    // number of columns in this matrix
+    unsigned int cols;
+
+    // default constructor is empty matrix
+    BitMatrix() : rows(0), cols(0), stride(0) {}
+
+    // rows x cols matrix, all entries are false
+    BitMatrix(unsigned int _rows, unsigned int _cols) : rows(_rows), cols(_cols), stride((_cols + 63) / 64),
+                                                         words(std::size_t(_rows) * ((_cols + 63) / 64), 0) {}
+
+    // n x n identity matrix
+    static BitMatrix identity(unsigned int n) {
+        BitMatrix I(n, n);
+        for (unsigned int i = 0; i < n; ++i) {
+            I.set(i, i, true);
+        }
+        return I;
+    }
+
+    // entries that are nonzero are true
+    template<class Scalar>
+    static BitMatrix from_matrix(const Matrix<Scalar> &A) {
+        BitMatrix packed(A.rows, A.cols);
+        for (unsigned int i = 0; i < A.rows; ++i) {
+            for (unsigned int j = 0; j < A.cols; ++j) {
+                // data is read directly, Matrix<bool> is stored in std::vector<bool>
+                if (A.data[std::size_t(i) * A.cols + j] != Scalar(0)) {
+                    packed.set(i, j, true);
+                }
+            }
+        }
+        return packed;
+    }
+
+    // unpacked matrix, one element per entry
+    template<class Scalar = bool>
+    Matrix<Scalar> to_matrix() const {
+        Matrix<Scalar> A = Matrix<Scalar>::zeros(rows, cols);
+        for (unsigned int i = 0; i < rows; ++i) {
+            for (unsigned int j = 0; j < cols; ++j) {
+                A.data[std::size_t(i) * cols + j] = Scalar(get(i, j) ? 1 : 0);
+            }
+        }
+        return A;
+    }
+
+    bool get(unsigned int i, unsigned int j) const {
+        assert(i < rows && j < cols);
+        return (words[std::size_t(i) * stride + j / 64] >> (j % 64)) & 1;
+    }
+
+    void set(unsigned int i, unsigned int j, bool value) {
+        assert(i < rows && j < cols);
+        std::uint64_t &word = words[std::size_t(i) * stride + j / 64];
+        std::uint64_t mask = std::uint64_t(1) << (j % 64);
+        word = value ? word | mask : word & ~mask;
+    }
+
+    // number of words in each row, bits after the last column are always zero
+    unsigned int words_per_row() const {
+        return stride;
+    }
+
+    // words of i-th row, column j is bit j % 64 of word j / 64
+    std::uint64_t *row(unsigned int i) {
+        return words.data() + std::size_t(i) * stride;
+    }
+
+    const std::uint64_t *row(unsigned int i) const {
+        return words.data() + std::size_t(i) * stride;
+    }
+
+    // number of true entries
+    std::size_t count() const {
+        std::size_t total = 0;
+        for (std::uint64_t word : words) {
+            total += __builtin_popcountll(word);
+        }
+        return total;
+    }
+
+    // entrywise OR
+    BitMatrix &operator|=(const BitMatrix &other) {
+        assert(rows == other.rows && cols == other.cols);
+        for (std::size_t i = 0; i < words.size(); ++i) {
+            words[i] |= other.words[i];
+        }
+        return *this;
+    }
+
+    bool operator==(const BitMatrix &other) const {
+        return rows == other.rows && cols == other.cols && words == other.words;
+    }
+
+    bool operator!=(const BitMatrix &other) const {
+        return !(*this == other);
+    }
+
+private:
+    // words per row
+    unsigned int stride;
+    // rows one after another
+    std::vector<std::uint64_t> words;
+};
+
+inline std::ostream &operator<<(std::ostream &os, const BitMatrix &A) {
+    os << "(" << A.rows << "x" << A.cols << ")" << std::endl;
+    for (unsigned int i = 0; i < A.rows; ++i) {
+        for (unsigned int j = 0; j < A.cols; ++j) {
+            os << A.get(i, j);
+        }
+        os << std::endl;
+    }
+    return os;
+}
+
+// group of rows of B combined by one table of Method of Four Russians
+const unsigned int four_russians_bits = 8;
+// words of a row in one table entry, 256 entries of 32 words (64kB) stay in L2 cache
+const unsigned int four_russians_block_words = 32;
+
+// dst[i] |= src[i] (or ^= if exclusive) for `count` words
+template<bool exclusive>
+void bit_words_combine(std::uint64_t *dst, const std::uint64_t *src, unsigned int count) {
+    unsigned int i = 0;
+#if defined(__AVX512F__)
+    for (; i + 8 <= count; i += 8) {
+        __m512i a = _mm512_loadu_si512(dst + i), b = _mm512_loadu_si512(src + i);
+        _mm512_storeu_si512(dst + i, exclusive ? _mm512_xor_si512(a, b) : _mm512_or_si512(a, b));
+    }
+#elif defined(__AVX2__)
+    for (; i + 4 <= count; i += 4) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                            exclusive ? _mm256_xor_si256(a, b) : _mm256_or_si256(a, b));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = exclusive ? dst[i] ^ src[i] : dst[i] | src[i];
+    }
+}
+
+// C = C | A B (or C ^ A B over Z/2 if exclusive) with Method of Four Russians
+template<bool exclusive>
+void four_russians(const BitMatrix &A, const BitMatrix &B, BitMatrix &C) {
+    assert(A.cols == B.rows && A.rows == C.rows && B.cols == C.cols);
+
+    const unsigned int stride = B.words_per_row();
+    std::vector<std::uint64_t> table(std::size_t(1 << four_russians_bits) * four_russians_block_words);
+
+    // columns of C are processed in blocks, so the table stays in cache
+    for (unsigned int w0 = 0; w0 < stride; w0 += four_russians_block_words) {
+        unsigned int block_words = std::min(four_russians_block_words, stride - w0);
+
+        for (unsigned int k0 = 0; k0 < A.cols; k0 += four_russians_bits) {
+            unsigned int bits = std::min(four_russians_bits, A.cols - k0);
+            unsigned int entries = 1u << bits;
+
+            // table[m] = combination of rows k0 + b of B for all bits b of m,
+            // every entry is previous entry (without lowest bit of m) and one row
+            std::fill(table.begin(), table.begin() + block_words, 0);
+            for (unsigned int m = 1; m < entries; ++m) {
+                std::uint64_t *entry = table.data() + std::size_t(m) * four_russians_block_words;
+                const std::uint64_t *previous = table.data() + std::size_t(m & (m - 1)) * four_russians_block_words;
+                std::copy(previous, previous + block_words, entry);
+                bit_words_combine<exclusive>(entry, B.row(k0 + __builtin_ctz(m)) + w0, block_words);
+            }
+
+            // k0 is a multiple of 8, so bits of one group are in the same word
+            for (unsigned int i = 0; i < A.rows; ++i) {
+                unsigned int m = (A.row(i)[k0 / 64] >> (k0 % 64)) & (entries - 1);
+                if (m != 0) {
+                    bit_words_combine<exclusive>(C.row(i) + w0,
+                                                 table.data() + std::size_t(m) * four_russians_block_words,
+                                                 block_words);
+                }
+            }
+        }
+    }
+}
+
+// Boolean product with Strassen's algorithm over integers modulo a prime larger than inner dimension,
+// c_ij is true if and only if number of k with a_ik and b_kj is nonzero modulo the prime
+inline BitMatrix boolean_strassen(const BitMatrix &A, const BitMatrix &B) {
+    typedef Mod<2147483647> Count;
+    assert(A.cols < 2147483647u);
+
+    Matrix<Count> product = multiply_strassen_dynamic(A.to_matrix<Count>(), B.to_matrix<Count>());
+    return BitMatrix::from_matrix(product);
+}
+
+// algorithms for Boolean products
+enum class BooleanAlgorithm {
+    // Strassen for matrices with all dimensions at least boolean_strassen_threshold, otherwise Four Russians
+    automatic,
+    four_russians,
+    strassen
+};
+
+// Strassen's algorithm needs 32 bits per entry instead of one, so it is used only for very large products
+const unsigned int boolean_strassen_threshold = 16384;
+
+// Boolean product A B, c_ij = OR_k (a_ik AND b_kj)
+inline BitMatrix multiply_boolean(const BitMatrix &A, const BitMatrix &B,
+                                  BooleanAlgorithm algorithm = BooleanAlgorithm::automatic) {
+    // check dimensions
+    assert(A.cols == B.rows);
+
+    if (algorithm == BooleanAlgorithm::strassen ||
+        (algorithm == BooleanAlgorithm::automatic &&
+         std::min(A.rows, std::min(A.cols, B.cols)) >= boolean_strassen_threshold)) {
+        return boolean_strassen(A, B);
+    }
+
+    BitMatrix C(A.rows, B.cols);
+    four_russians<false>(A, B, C);
+    return C;
+}
+
+// product A B over Z/2, c_ij = XOR_k (a_ik AND b_kj)
+inline BitMatrix multiply_gf2(const BitMatrix &A, const BitMatrix &B) {
+    // check dimensions
+    assert(A.cols == B.rows);
+
+    BitMatrix C(A.rows, B.cols);
+    four_russians<true>(A, B, C);
+    return C;
+}
+
+// transitive closure of relation (graph) A: entry (i, j) is true if j can be reached from i in one
+// or more steps (zero or more steps if reflexive), calculated with O(log n) Boolean squarings
+inline BitMatrix transitive_closure(const BitMatrix &A, bool reflexive = false) {
+    // check dimensions
+    assert(A.rows == A.cols);
+
+    // R = (I | A)^(2^t) contains all paths of length at most 2^t, squaring stops when nothing changes
+    BitMatrix R = BitMatrix::identity(A.rows);
+    R |= A;
+    for (BitMatrix squared = multiply_boolean(R, R); squared != R; squared = multiply_boolean(R, R)) {
+        R = squared;
+    }
+
+    // paths of length at least one
+    return reflexive ? R : multiply_boolean(A, R);
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_BIT_MATRIX_HPP
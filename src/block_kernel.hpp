@@ -0,0 +1,257 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_BLOCK_KERNEL_HPP
+#define FAST_MATRIX_MULTIPLICATION_BLOCK_KERNEL_HPP
+
+#include "semiring.hpp"
+#include "simd.hpp"
+
+// Kernels of classic multiplication for one block that fits in cache, C += A B (or the same over
+// a semiring), used by classic_kernel() in multiply_classic.hpp.
+// This header includes only what kernels need, so that files of the compiled library that are built
+// for other instruction sets (kernels_avx2.cpp, kernels_avx512.cpp) contain nothing else.
+
+#ifdef FAST_MATRIX_MULTIPLICATION_LIBRARY
+
+// block kernels of the compiled library for floats and doubles, chosen at runtime for instruction sets
+// of the processor (see kernels.cpp)
+void classic_block_kernel_dispatch(unsigned int rows, unsigned int cols, unsigned int inner,
+                                   const float *A, unsigned int lda, const float *B, unsigned int ldb,
+                                   float *C, unsigned int ldc);
+
+void classic_block_kernel_dispatch(unsigned int rows, unsigned int cols, unsigned int inner,
+                                   const double *A, unsigned int lda, const double *B, unsigned int ldb,
+                                   double *C, unsigned int ldc);
+
+// instruction set of the kernels in use ("avx512", "avx2" or "generic")
+const char *classic_kernel_isa();
+
+// uses kernels for given instruction set from now on, returns false (and changes nothing)
+// if they were not compiled or the processor does not support them
+bool select_classic_kernel_isa(const char *isa);
+
+#endif
+
+// block kernels depend on instruction sets they are compiled for (see simd.hpp)
+inline namespace FAST_MATRIX_MULTIPLICATION_ISA_NAMESPACE {
+
+// C += A B for one block (A is rows x inner, B is inner x cols, both are row-major with given strides)
+template<class Scalar>
+void classic_block_kernel(unsigned int rows, unsigned int cols, unsigned int inner,
+                          const Scalar *A, unsigned int lda, const Scalar *B, unsigned int ldb,
+                          Scalar *C, unsigned int ldc) {
+    for (unsigned int i = 0; i < rows; ++i) {
+        // this will be Cij
+        Scalar *iter_C = C + i * ldc;
+        for (unsigned int k = 0; k < inner; ++k) {
+            // calculate c_ij
+            const Scalar Aik = A[i * lda + k];
+            // this will be Bkj
+            const Scalar *iter_B = B + k * ldb;
+            for (unsigned int j = 0; j < cols; ++j) {
+                iter_C[j] += Aik * iter_B[j];
+            }
+        }
+    }
+}
+
+// rows of C updated at once by SIMD kernel, every row uses two vector registers,
+// so 4 x 2 accumulators, two rows of B and a broadcast element of A all stay in registers
+// (parallel kernels split rows in multiples of it also in builds without SIMD)
+const unsigned int classic_simd_rows = 4;
+
+#ifdef FAST_MATRIX_MULTIPLICATION_SIMD
+
+// C += A B for `rows` rows of A (at most classic_simd_rows) and 2 * width columns of B
+template<unsigned int rows, class Scalar>
+void classic_simd_tile(unsigned int inner, const Scalar *A, unsigned int lda, const Scalar *B, unsigned int ldb,
+                       Scalar *C, unsigned int ldc) {
+    typedef typename Simd<Scalar>::Vector Vector;
+    const unsigned int width = Simd<Scalar>::width;
+
+    Vector sums[rows][2];
+    for (unsigned int r = 0; r < rows; ++r) {
+        sums[r][0] = sums[r][1] = Simd<Scalar>::zero();
+    }
+
+    for (unsigned int k = 0; k < inner; ++k) {
+        Vector B0 = Simd<Scalar>::load(B + k * ldb), B1 = Simd<Scalar>::load(B + k * ldb + width);
+        for (unsigned int r = 0; r < rows; ++r) {
+            Vector Ark = Simd<Scalar>::broadcast(A[r * lda + k]);
+            sums[r][0] = Simd<Scalar>::multiply_add(Ark, B0, sums[r][0]);
+            sums[r][1] = Simd<Scalar>::multiply_add(Ark, B1, sums[r][1]);
+        }
+    }
+
+    for (unsigned int r = 0; r < rows; ++r) {
+        Scalar *row_C = C + r * ldc;
+        Simd<Scalar>::store(row_C, Simd<Scalar>::add(Simd<Scalar>::load(row_C), sums[r][0]));
+        Simd<Scalar>::store(row_C + width, Simd<Scalar>::add(Simd<Scalar>::load(row_C + width), sums[r][1]));
+    }
+}
+
+// block kernel with SIMD tiles, columns that do not fill a whole tile are done by the scalar kernel
+template<class Scalar>
+void classic_block_kernel_simd(unsigned int rows, unsigned int cols, unsigned int inner,
+                               const Scalar *A, unsigned int lda, const Scalar *B, unsigned int ldb,
+                               Scalar *C, unsigned int ldc) {
+    const unsigned int tile_cols = 2 * Simd<Scalar>::width;
+    const unsigned int full_cols = cols / tile_cols * tile_cols;
+
+    unsigned int i = 0;
+    for (; i + classic_simd_rows <= rows; i += classic_simd_rows) {
+        for (unsigned int j = 0; j < full_cols; j += tile_cols) {
+            classic_simd_tile<classic_simd_rows>(inner, A + i * lda, lda, B + j, ldb, C + i * ldc + j, ldc);
+        }
+    }
+    for (; i < rows; ++i) {
+        for (unsigned int j = 0; j < full_cols; j += tile_cols) {
+            classic_simd_tile<1>(inner, A + i * lda, lda, B + j, ldb, C + i * ldc + j, ldc);
+        }
+    }
+
+    // remaining columns
+    classic_block_kernel<Scalar>(rows, cols - full_cols, inner, A, lda, B + full_cols, ldb, C + full_cols, ldc);
+}
+
+#endif
+
+#if defined(FAST_MATRIX_MULTIPLICATION_LIBRARY)
+
+inline void classic_block_kernel(unsigned int rows, unsigned int cols, unsigned int inner,
+                                 const float *A, unsigned int lda, const float *B, unsigned int ldb,
+                                 float *C, unsigned int ldc) {
+    classic_block_kernel_dispatch(rows, cols, inner, A, lda, B, ldb, C, ldc);
+}
+
+inline void classic_block_kernel(unsigned int rows, unsigned int cols, unsigned int inner,
+                                 const double *A, unsigned int lda, const double *B, unsigned int ldb,
+                                 double *C, unsigned int ldc) {
+    classic_block_kernel_dispatch(rows, cols, inner, A, lda, B, ldb, C, ldc);
+}
+
+#elif defined(FAST_MATRIX_MULTIPLICATION_SIMD)
+
+inline void classic_block_kernel(unsigned int rows, unsigned int cols, unsigned int inner,
+                                 const float *A, unsigned int lda, const float *B, unsigned int ldb,
+                                 float *C, unsigned int ldc) {
+    classic_block_kernel_simd(rows, cols, inner, A, lda, B, ldb, C, ldc);
+}
+
+inline void classic_block_kernel(unsigned int rows, unsigned int cols, unsigned int inner,
+                                 const double *A, unsigned int lda, const double *B, unsigned int ldb,
+                                 double *C, unsigned int ldc) {
+    classic_block_kernel_simd(rows, cols, inner, A, lda, B, ldb, C, ldc);
+}
+
+#endif
+
+// C = C + A B over a semiring, for one block
+template<class Scalar, class Semiring>
+void classic_block_kernel(unsigned int rows, unsigned int cols, unsigned int inner,
+                          const Scalar *A, unsigned int lda, const Scalar *B, unsigned int ldb,
+                          Scalar *C, unsigned int ldc, const Semiring &semiring) {
+    for (unsigned int i = 0; i < rows; ++i) {
+        Scalar *iter_C = C + i * ldc;
+        for (unsigned int k = 0; k < inner; ++k) {
+            const Scalar Aik = A[i * lda + k];
+            const Scalar *iter_B = B + k * ldb;
+            for (unsigned int j = 0; j < cols; ++j) {
+                iter_C[j] = semiring.add(iter_C[j], semiring.multiply(Aik, iter_B[j]));
+            }
+        }
+    }
+}
+
+// ordinary arithmetic uses kernels above (with SIMD for floats and doubles)
+template<class Scalar>
+void classic_block_kernel(unsigned int rows, unsigned int cols, unsigned int inner,
+                          const Scalar *A, unsigned int lda, const Scalar *B, unsigned int ldb,
+                          Scalar *C, unsigned int ldc, const PlusTimes<Scalar> &) {
+    classic_block_kernel(rows, cols, inner, A, lda, B, ldb, C, ldc);
+}
+
+#ifdef FAST_MATRIX_MULTIPLICATION_SIMD
+
+// C = min(C, A + B) (or max if maximum) for `rows` rows of A and 2 * width columns of B,
+// same register tiling as classic_simd_tile(), with addition instead of multiplication and min instead of sum
+template<unsigned int rows, class Scalar, bool maximum>
+void tropical_simd_tile(unsigned int inner, const Scalar *A, unsigned int lda, const Scalar *B, unsigned int ldb,
+                        Scalar *C, unsigned int ldc) {
+    typedef typename Simd<Scalar>::Vector Vector;
+    const unsigned int width = Simd<Scalar>::width;
+
+    Vector sums[rows][2];
+    for (unsigned int r = 0; r < rows; ++r) {
+        sums[r][0] = Simd<Scalar>::load(C + r * ldc);
+        sums[r][1] = Simd<Scalar>::load(C + r * ldc + width);
+    }
+
+    for (unsigned int k = 0; k < inner; ++k) {
+        Vector B0 = Simd<Scalar>::load(B + k * ldb), B1 = Simd<Scalar>::load(B + k * ldb + width);
+        for (unsigned int r = 0; r < rows; ++r) {
+            Vector Ark = Simd<Scalar>::broadcast(A[r * lda + k]);
+            Vector P0 = Simd<Scalar>::add(Ark, B0), P1 = Simd<Scalar>::add(Ark, B1);
+            sums[r][0] = maximum ? Simd<Scalar>::max(sums[r][0], P0) : Simd<Scalar>::min(sums[r][0], P0);
+            sums[r][1] = maximum ? Simd<Scalar>::max(sums[r][1], P1) : Simd<Scalar>::min(sums[r][1], P1);
+        }
+    }
+
+    for (unsigned int r = 0; r < rows; ++r) {
+        Simd<Scalar>::store(C + r * ldc, sums[r][0]);
+        Simd<Scalar>::store(C + r * ldc + width, sums[r][1]);
+    }
+}
+
+// tropical block kernel with SIMD tiles, remaining columns are done by the generic semiring kernel
+template<class Scalar, bool maximum, class Semiring>
+void tropical_block_kernel(unsigned int rows, unsigned int cols, unsigned int inner,
+                           const Scalar *A, unsigned int lda, const Scalar *B, unsigned int ldb,
+                           Scalar *C, unsigned int ldc, const Semiring &semiring) {
+    const unsigned int tile_cols = 2 * Simd<Scalar>::width;
+    const unsigned int full_cols = cols / tile_cols * tile_cols;
+
+    unsigned int i = 0;
+    for (; i + classic_simd_rows <= rows; i += classic_simd_rows) {
+        for (unsigned int j = 0; j < full_cols; j += tile_cols) {
+            tropical_simd_tile<classic_simd_rows, Scalar, maximum>(inner, A + i * lda, lda, B + j, ldb,
+                                                                   C + i * ldc + j, ldc);
+        }
+    }
+    for (; i < rows; ++i) {
+        for (unsigned int j = 0; j < full_cols; j += tile_cols) {
+            tropical_simd_tile<1, Scalar, maximum>(inner, A + i * lda, lda, B + j, ldb, C + i * ldc + j, ldc);
+        }
+    }
+
+    classic_block_kernel<Scalar>(rows, cols - full_cols, inner, A, lda, B + full_cols, ldb, C + full_cols, ldc,
+                                 semiring);
+}
+
+inline void classic_block_kernel(unsigned int rows, unsigned int cols, unsigned int inner,
+                                 const float *A, unsigned int lda, const float *B, unsigned int ldb,
+                                 float *C, unsigned int ldc, const MinPlus<float> &semiring) {
+    tropical_block_kernel<float, false>(rows, cols, inner, A, lda, B, ldb, C, ldc, semiring);
+}
+
+inline void classic_block_kernel(unsigned int rows, unsigned int cols, unsigned int inner,
+                                 const double *A, unsigned int lda, const double *B, unsigned int ldb,
+                                 double *C, unsigned int ldc, const MinPlus<double> &semiring) {
+    tropical_block_kernel<double, false>(rows, cols, inner, A, lda, B, ldb, C, ldc, semiring);
+}
+
+inline void classic_block_kernel(unsigned int rows, unsigned int cols, unsigned int inner,
+                                 const float *A, unsigned int lda, const float *B, unsigned int ldb,
+                                 float *C, unsigned int ldc, const MaxPlus<float> &semiring) {
+    tropical_block_kernel<float, true>(rows, cols, inner, A, lda, B, ldb, C, ldc, semiring);
+}
+
+inline void classic_block_kernel(unsigned int rows, unsigned int cols, unsigned int inner,
+                                 const double *A, unsigned int lda, const double *B, unsigned int ldb,
+                                 double *C, unsigned int ldc, const MaxPlus<double> &semiring) {
+    tropical_block_kernel<double, true>(rows, cols, inner, A, lda, B, ldb, C, ldc, semiring);
+}
+
+#endif
+
+} // inline namespace FAST_MATRIX_MULTIPLICATION_ISA_NAMESPACE
+
+#endif //FAST_MATRIX_MULTIPLICATION_BLOCK_KERNEL_HPP
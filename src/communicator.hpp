@@ -0,0 +1,268 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_COMMUNICATOR_HPP
+#define FAST_MATRIX_MULTIPLICATION_COMMUNICATOR_HPP
+
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "matrix.hpp"
+#include "thread_pool.hpp"
+
+// Message passing between processes with ranks 0, ..., size - 1.
+//
+// Communicator is the interface used by distributed algorithms: messages are sequences of bytes sent
+// to one rank and received (in order) from one rank, every communicator counts bytes it has sent.
+// SocketCommunicator connects every pair of processes on one machine with a Unix socket,
+// run_processes() forks such processes and runs the same function in all of them (rank 0 stays in
+// the calling process). Other transports (for example MPI) only need to implement send() and receive().
+
+class Communicator {
+public:
+    virtual ~Communicator() {}
+
+    // rank of this process
+    virtual unsigned int rank() const = 0;
+
+    // number of processes
+    virtual unsigned int size() const = 0;
+
+    // sends message to process `destination`, returns when message can be reused
+    virtual void send(unsigned int destination, const std::vector<char> &message) = 0;
+
+    // next message sent by process `source` to this process (waits for it)
+    virtual std::vector<char> receive(unsigned int source) = 0;
+
+    // bytes sent by this process (with headers of messages)
+    std::uint64_t bytes_sent = 0;
+    // messages sent by this process
+    std::uint64_t messages_sent = 0;
+};
+
+// messages over Unix sockets, sockets[j] is connected to process j (-1 for this process)
+class SocketCommunicator : public Communicator {
+public:
+    SocketCommunicator(unsigned int _rank, const std::vector<int> &_sockets) : own_rank(_rank), sockets(_sockets) {}
+
+    SocketCommunicator(const SocketCommunicator &) = delete;
+
+    SocketCommunicator &operator=(const SocketCommunicator &) = delete;
+
+    ~SocketCommunicator() override {
+        for (int socket : sockets) {
+            if (socket >= 0) {
+                ::close(socket);
+            }
+        }
+    }
+
+    unsigned int rank() const override {
+        return own_rank;
+    }
+
+    unsigned int size() const override {
+        return sockets.size();
+    }
+
+    // every message is its length (8 bytes) followed by its bytes
+    void send(unsigned int destination, const std::vector<char> &message) override {
+        assert(destination < size() && destination != own_rank);
+
+        std::uint64_t length = message.size();
+        write_all(sockets[destination], reinterpret_cast<const char *>(&length), sizeof(length));
+        write_all(sockets[destination], message.data(), message.size());
+
+        bytes_sent += sizeof(length) + message.size();
+        messages_sent++;
+    }
+
+    std::vector<char> receive(unsigned int source) override {
+        assert(source < size() && source != own_rank);
+
+        std::uint64_t length;
+        read_all(sockets[source], reinterpret_cast<char *>(&length), sizeof(length));
+        std::vector<char> message(length);
+        read_all(sockets[source], message.data(), message.size());
+        return message;
+    }
+
+private:
+    unsigned int own_rank;
+    std::vector<int> sockets;
+
+    // MSG_NOSIGNAL: closed peer is reported as an error instead of SIGPIPE
+    static void write_all(int socket, const char *bytes, std::size_t length) {
+        while (length > 0) {
+            ssize_t written = ::send(socket, bytes, length, MSG_NOSIGNAL);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "cannot send message");
+            }
+            bytes += written;
+            length -= written;
+        }
+    }
+
+    static void read_all(int socket, char *bytes, std::size_t length) {
+        while (length > 0) {
+            ssize_t received = ::recv(socket, bytes, length, 0);
+            if (received < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "cannot receive message");
+            }
+            if (received == 0) {
+                throw std::runtime_error("connection closed by other process");
+            }
+            bytes += received;
+            length -= received;
+        }
+    }
+};
+
+// runs function(communicator) in `count` processes connected by Unix sockets,
+// rank 0 runs in calling process, other ranks in forked processes that exit when function returns,
+// throws if function fails in any of the processes.
+// Forked processes inherit thread pools of the caller without their worker threads (and possibly with
+// locks held by them), so they install a private pool with one worker before running the function.
+// Every process is expected to run on its own core, rank 0 keeps the default pool of the caller.
+template<class Function>
+void run_processes(unsigned int count, Function function) {
+    assert(count >= 1);
+
+    // sockets[i][j] is the end of socket between i and j owned by process i
+    std::vector<std::vector<int>> sockets(count, std::vector<int>(count, -1));
+    auto close_sockets = [&sockets](unsigned int except) {
+        for (unsigned int i = 0; i < sockets.size(); ++i) {
+            for (int &socket : sockets[i]) {
+                if (i != except && socket >= 0) {
+                    ::close(socket);
+                    socket = -1;
+                }
+            }
+        }
+    };
+
+    for (unsigned int i = 0; i < count; ++i) {
+        for (unsigned int j = i + 1; j < count; ++j) {
+            int pair[2];
+            if (::socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+                int error = errno;
+                close_sockets(count);
+                throw std::system_error(error, std::generic_category(), "cannot create socket pair");
+            }
+            sockets[i][j] = pair[0];
+            sockets[j][i] = pair[1];
+        }
+    }
+
+    std::vector<pid_t> children;
+    for (unsigned int rank = 1; rank < count; ++rank) {
+        pid_t pid = ::fork();
+        if (pid == 0) {
+            close_sockets(rank);
+            int status = 0;
+            try {
+                ThreadPool pool(1);
+                ThreadPoolScope scope(pool);
+                SocketCommunicator communicator(rank, sockets[rank]);
+                function(static_cast<Communicator &>(communicator));
+            } catch (...) {
+                status = 1;
+            }
+            // child does not return to caller (and does not run its destructors or exit handlers)
+            ::_exit(status);
+        }
+        if (pid < 0) {
+            // processes that were already started get closed sockets and fail
+            int error = errno;
+            close_sockets(count);
+            for (pid_t child : children) {
+                ::waitpid(child, nullptr, 0);
+            }
+            throw std::system_error(error, std::generic_category(), "cannot start process");
+        }
+        children.push_back(pid);
+    }
+    close_sockets(0);
+
+    std::exception_ptr error;
+    try {
+        SocketCommunicator communicator(0, sockets[0]);
+        function(static_cast<Communicator &>(communicator));
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    bool failed = false;
+    for (pid_t child : children) {
+        int status;
+        if (::waitpid(child, &status, 0) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            failed = true;
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    if (failed) {
+        throw std::runtime_error("process of distributed computation failed");
+    }
+}
+
+// appends bytes of a trivially copyable value to message
+template<class Value>
+void message_put(std::vector<char> &message, const Value &value) {
+    static_assert(std::is_trivially_copyable<Value>::value, "only plain values can be sent");
+    const char *bytes = reinterpret_cast<const char *>(&value);
+    message.insert(message.end(), bytes, bytes + sizeof(Value));
+}
+
+// reads value from message at position `offset` and moves offset after it
+template<class Value>
+Value message_get(const std::vector<char> &message, std::size_t &offset) {
+    static_assert(std::is_trivially_copyable<Value>::value, "only plain values can be sent");
+    assert(offset + sizeof(Value) <= message.size());
+    Value value;
+    std::memcpy(&value, message.data() + offset, sizeof(Value));
+    offset += sizeof(Value);
+    return value;
+}
+
+// appends dimensions and elements of a matrix to message
+template<class Scalar>
+void message_put_matrix(std::vector<char> &message, const Matrix<Scalar> &A) {
+    static_assert(std::is_trivially_copyable<Scalar>::value, "only matrices of plain values can be sent");
+    message_put(message, std::uint32_t(A.rows));
+    message_put(message, std::uint32_t(A.cols));
+    const char *bytes = reinterpret_cast<const char *>(A.data.data());
+    message.insert(message.end(), bytes, bytes + A.data.size() * sizeof(Scalar));
+}
+
+// reads matrix from message at position `offset` and moves offset after it
+template<class Scalar>
+Matrix<Scalar> message_get_matrix(const std::vector<char> &message, std::size_t &offset) {
+    unsigned int rows = message_get<std::uint32_t>(message, offset);
+    unsigned int cols = message_get<std::uint32_t>(message, offset);
+    Matrix<Scalar> A = Matrix<Scalar>::zeros(rows, cols);
+
+    std::size_t length = A.data.size() * sizeof(Scalar);
+    assert(offset + length <= message.size());
+    std::memcpy(A.data.data(), message.data() + offset, length);
+    offset += length;
+    return A;
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_COMMUNICATOR_HPP
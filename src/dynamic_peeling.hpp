@@ -2,73 +2,116 @@
 #define FAST_MATRIX_MULTIPLICATION_DYNAMIC_PEELING_HPP
 
 #include <cassert>
+#include <cstddef>
 #include "matrix.hpp"
 #include "multiply_classic.hpp"
+#include "thread_pool.hpp"
 
-// performs dynamic peeling for matrix product <n, k, m> algorithm
-// (dimensions n, k, and m mean in how many blocks we split matrices A and B)
-// this function directly adds needed products to matrix C
-template<typename Scalar>
-void dynamic_peeling(const Matrix<Scalar> &A, const Matrix<Scalar> &B, Matrix<Scalar> &C,
-                     unsigned int n, unsigned int k, unsigned int m) {
-    // check if matrix dimensions are valid
-    assert(A.rows == C.rows && A.cols == B.rows && B.cols == C.cols);
+// Dynamic peeling adds the products of rows and columns that an <n, k, m> step left out because
+// dimensions are not divisible by n, k and m. All three products are accumulated directly into C with
+// classic_kernel(), reading operands in place (no blocks are copied and no products are allocated):
+// a rank update of the included part of C by the peeled columns of A and rows of B, and panel updates
+// of the peeled rows and columns of C.
+//
+// Panels of C do not overlap the included part of C, so they can be calculated while the recursive step
+// is still accumulating its products there: dynamic_peeling_start() runs them as a task of the thread pool
+// when the pool has more than one worker and there is enough work.
 
-    // how many rows and cols were included in algorithm
-    unsigned int included_rows_A = (A.rows / n) * n,
-            included_cols_A = (A.cols / k) * k,
-            included_rows_B = (B.rows / k) * k,
-            included_cols_B = (B.cols / m) * m;
+// peeled panels with fewer multiplications than this are not worth a task
+const double peeling_async_threshold = double(1 << 22);
 
-    // for how many rows do we need to do dynamic peeling?
-    unsigned int need_peeling_rows_A = A.rows - included_rows_A,
-            need_peeling_cols_A = A.cols - included_cols_A,
-            need_peeling_rows_B = B.rows - included_rows_B,
-            need_peeling_cols_B = B.cols - included_cols_B;
+// pointer to element (row, col) of op(A), row stride of op(A) is always A.cols
+template<typename Scalar>
+const Scalar *peeling_element(const Matrix<Scalar> &A, Op op, unsigned int row, unsigned int col) {
+    return op == Op::none ? A.data.data() + std::size_t(row) * A.cols + col
+                          : A.data.data() + std::size_t(col) * A.cols + row;
+}
 
-    // add product of not included columns from A * not included rows from B
-    // we will split this in 3 blocks we can easily calculate
+// included part of C (first rows and columns divisible by n and m) += peeled columns of op(A) times
+// peeled rows of op(B)
+// A * B = C
+// | . . O |   | . . . |   | O O . |
+// | . . O | * | . . . | = | O O . |
+// | . . . |   | O O . |   | . . . |
+template<typename Scalar>
+void dynamic_peeling_update(const Matrix<Scalar> &A, const Matrix<Scalar> &B, Matrix<Scalar> &C,
+                            unsigned int n, unsigned int k, unsigned int m,
+                            Op op_A = Op::none, Op op_B = Op::none) {
+    const unsigned int inner = op_cols(A, op_A);
+    const unsigned int included_rows = (C.rows / n) * n,
+            included_inner = (inner / k) * k,
+            included_cols = (C.cols / m) * m;
 
-    // first block
-    // A * B = C
-    // | . . O |   | . . . |   | O O . |
-    // | . . O | * | . . . | = | O O . |
-    // | . . . |   | O O . |   | . . . |
-    if (need_peeling_cols_A > 0) {
-        Matrix<Scalar> A_extra = A.subblock({0, included_cols_A}, {included_rows_A, need_peeling_cols_A});
-        Matrix<Scalar> B_extra = B.subblock({included_rows_B, 0}, {need_peeling_rows_B, included_cols_B});
+    if (inner > included_inner && included_rows > 0 && included_cols > 0) {
+        classic_kernel(included_rows, included_cols, inner - included_inner,
+                       peeling_element(A, op_A, 0, included_inner), A.cols, op_A,
+                       peeling_element(B, op_B, included_inner, 0), B.cols, op_B,
+                       C.data.data(), C.cols);
+    }
+}
 
-        // calculate this product and add it to large matrix C in correct place
-        Matrix<Scalar> product = multiply_classic(A_extra, B_extra);
+// peeled columns and rows of C
+// A * B = C
+// | O O O |   | . . O |   | . . O |
+// | O O O | * | . . O | = | . . O |
+// | O O O |   | . . O |   | . . O |
+// and
+// | . . . |   | O O . |   | . . . |
+// | . . . | * | O O . | = | . . . |
+// | O O O |   | O O . |   | O O . |
+template<typename Scalar>
+void dynamic_peeling_panels(const Matrix<Scalar> &A, const Matrix<Scalar> &B, Matrix<Scalar> &C,
+                            unsigned int n, unsigned int m, Op op_A = Op::none, Op op_B = Op::none) {
+    const unsigned int inner = op_cols(A, op_A);
+    const unsigned int included_rows = (C.rows / n) * n, included_cols = (C.cols / m) * m;
 
-        C.block_add({0, 0}, product);
+    if (C.cols > included_cols) {
+        classic_kernel(C.rows, C.cols - included_cols, inner,
+                       peeling_element(A, op_A, 0, 0), A.cols, op_A,
+                       peeling_element(B, op_B, 0, included_cols), B.cols, op_B,
+                       C.data.data() + included_cols, C.cols);
     }
+    if (C.rows > included_rows && included_cols > 0) {
+        classic_kernel(C.rows - included_rows, included_cols, inner,
+                       peeling_element(A, op_A, included_rows, 0), A.cols, op_A,
+                       peeling_element(B, op_B, 0, 0), B.cols, op_B,
+                       C.data.data() + std::size_t(included_rows) * C.cols, C.cols);
+    }
+}
 
-    // second block
-    // A * B = C
-    // | O O O |   | . . O |   | . . O |
-    // | O O O | * | . . O | = | . . O |
-    // | O O O |   | . . O |   | . . O |
-    if (need_peeling_cols_B > 0) {
-        Matrix<Scalar> B_extra = B.subblock({0, included_cols_B}, {B.rows, need_peeling_cols_B});
+// performs dynamic peeling for matrix product <n, k, m> algorithm
+// (dimensions n, k, and m mean in how many blocks we split matrices A and B)
+// this function directly adds needed products to matrix C
+// (C is product op(A) op(B), all blocks below are blocks of op(A) and op(B))
+template<typename Scalar>
+void dynamic_peeling(const Matrix<Scalar> &A, const Matrix<Scalar> &B, Matrix<Scalar> &C,
+                     unsigned int n, unsigned int k, unsigned int m,
+                     Op op_A = Op::none, Op op_B = Op::none) {
+    // check if matrix dimensions are valid
+    assert(op_rows(A, op_A) == C.rows && op_cols(A, op_A) == op_rows(B, op_B) && op_cols(B, op_B) == C.cols);
 
-        // calculate product and add it to product C
-        Matrix<Scalar> product = multiply_classic(A, B_extra);
-        C.block_add({0, included_cols_B}, product);
-    }
+    dynamic_peeling_update(A, B, C, n, k, m, op_A, op_B);
+    dynamic_peeling_panels(A, B, C, n, m, op_A, op_B);
+}
 
-    // third block
-    // A * B = C
-    // | . . . |   | O O . |   | . . . |
-    // | . . . | * | O O . | = | . . . |
-    // | O O O |   | O O . |   | O O . |
-    if (need_peeling_rows_A > 0) {
-        Matrix<Scalar> A_extra = A.subblock({included_rows_A, 0}, {need_peeling_rows_A, A.cols});
-        Matrix<Scalar> B_extra = B.subblock({0, 0}, {B.rows, included_cols_B});
+// starts panel updates of dynamic peeling as a task of the group if it pays off (otherwise they are done
+// at once), the recursive step may meanwhile accumulate into included part of C; it has to call
+// dynamic_peeling_update() and wait for the group before C is used
+template<typename Scalar>
+void dynamic_peeling_start(const Matrix<Scalar> &A, const Matrix<Scalar> &B, Matrix<Scalar> &C,
+                           unsigned int n, unsigned int m, TaskGroup &group,
+                           Op op_A = Op::none, Op op_B = Op::none) {
+    // check if matrix dimensions are valid
+    assert(op_rows(A, op_A) == C.rows && op_cols(A, op_A) == op_rows(B, op_B) && op_cols(B, op_B) == C.cols);
 
-        // calculate this product and add it to large matrix C in correct place
-        Matrix<Scalar> product = multiply_classic(A_extra, B_extra);
-        C.block_add({included_rows_A, 0}, product);
+    const unsigned int included_rows = (C.rows / n) * n, included_cols = (C.cols / m) * m;
+    const double work = (double(C.rows) * C.cols - double(included_rows) * included_cols) * op_cols(A, op_A);
+    if (group.thread_pool().threads() > 1 && work >= peeling_async_threshold) {
+        group.run([&A, &B, &C, n, m, op_A, op_B]() {
+            dynamic_peeling_panels(A, B, C, n, m, op_A, op_B);
+        });
+    } else {
+        dynamic_peeling_panels(A, B, C, n, m, op_A, op_B);
     }
 }
 
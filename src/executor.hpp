@@ -0,0 +1,167 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_EXECUTOR_HPP
+#define FAST_MATRIX_MULTIPLICATION_EXECUTOR_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "thread_pool.hpp"
+
+// Fair queue of jobs run on the thread pool, shared by asynchronous multiplications.
+//
+// Work is submitted as jobs, every job is a list of independent tasks (for example products of one step
+// of Strassen's algorithm, or bands of rows of a classic product). Tasks are run on a ThreadPool by at most
+// one runner per worker of the pool, and runners take tasks from jobs in round-robin order: after a task of
+// a job is started, the job goes to the end of the queue, so a small job waits for at most one task of every
+// other job instead of for whole large jobs.
+//
+// At most `capacity` jobs can wait for their first task to be started, submit() waits for free space
+// (try_submit() returns false instead), so producers can not queue up unbounded amount of work.
+// Tasks must not throw and should not wait for other tasks of the executor.
+
+class Executor {
+public:
+    typedef std::function<void()> Task;
+
+    // at most `capacity` queued jobs, tasks run on given pool
+    explicit Executor(std::size_t _capacity = 64, ThreadPool &_pool = default_thread_pool())
+            : capacity(std::max<std::size_t>(1, _capacity)), pool(_pool) {}
+
+    Executor(const Executor &) = delete;
+
+    Executor &operator=(const Executor &) = delete;
+
+    // all submitted tasks are finished before executor is destroyed
+    ~Executor() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this]() {
+            return jobs.empty() && runners == 0;
+        });
+    }
+
+    // number of tasks that can run at once
+    unsigned int threads() const {
+        return pool.threads();
+    }
+
+    // queues job made of given tasks, waits while `capacity` jobs are queued and not started
+    void submit(std::vector<Task> tasks) {
+        std::unique_lock<std::mutex> lock(mutex);
+        space_available.wait(lock, [this]() {
+            return waiting < capacity;
+        });
+        enqueue(std::move(tasks));
+    }
+
+    // queues job made of given tasks, returns false (and does not queue it) if queue is full
+    bool try_submit(std::vector<Task> tasks) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (waiting >= capacity) {
+            return false;
+        }
+        enqueue(std::move(tasks));
+        return true;
+    }
+
+    // executor used by asynchronous functions when none is given
+    static Executor &shared() {
+        static Executor executor;
+        return executor;
+    }
+
+private:
+    struct Job {
+        std::deque<Task> tasks;
+        // some task has been started (until then job counts towards capacity)
+        bool started = false;
+    };
+
+    std::size_t capacity;
+    ThreadPool &pool;
+
+    std::mutex mutex;
+    std::condition_variable space_available, idle;
+    // jobs with tasks that were not started yet, in round-robin order
+    std::deque<std::shared_ptr<Job>> jobs;
+    // number of jobs without started tasks
+    std::size_t waiting = 0;
+    // number of runners submitted to the pool
+    unsigned int runners = 0;
+
+    // called with locked mutex
+    void enqueue(std::vector<Task> tasks) {
+        if (tasks.empty()) {
+            return;
+        }
+        std::shared_ptr<Job> job = std::make_shared<Job>();
+        job->tasks.assign(std::make_move_iterator(tasks.begin()), std::make_move_iterator(tasks.end()));
+        jobs.push_back(std::move(job));
+        waiting++;
+
+        // enough runners to run one task on every worker
+        std::size_t queued_tasks = 0;
+        for (const std::shared_ptr<Job> &queued : jobs) {
+            queued_tasks += queued->tasks.size();
+        }
+        while (runners < pool.threads() && runners < queued_tasks) {
+            runners++;
+            pool.submit([this]() {
+                run();
+            });
+        }
+    }
+
+    // runs one task and submits itself again while jobs have tasks left: a runner may be started by
+    // a thread that waits for its own tasks (TaskGroup runs any task of the pool meanwhile), and it has to
+    // return to that thread after one task instead of after all queued jobs
+    void run() {
+        Task task;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (jobs.empty()) {
+                finish_runner();
+                return;
+            }
+
+            // next task of the first job, job goes to the end of the queue if it has more tasks
+            std::shared_ptr<Job> job = std::move(jobs.front());
+            jobs.pop_front();
+            task = std::move(job->tasks.front());
+            job->tasks.pop_front();
+            if (!job->started) {
+                job->started = true;
+                waiting--;
+                space_available.notify_one();
+            }
+            if (!job->tasks.empty()) {
+                jobs.push_back(std::move(job));
+            }
+        }
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (jobs.empty()) {
+                finish_runner();
+                return;
+            }
+        }
+        pool.submit([this]() {
+            run();
+        });
+    }
+
+    // called with locked mutex
+    void finish_runner() {
+        runners--;
+        if (runners == 0) {
+            idle.notify_all();
+        }
+    }
+};
+
+#endif //FAST_MATRIX_MULTIPLICATION_EXECUTOR_HPP
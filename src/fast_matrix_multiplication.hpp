@@ -0,0 +1,71 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_FAST_MATRIX_MULTIPLICATION_HPP
+#define FAST_MATRIX_MULTIPLICATION_FAST_MATRIX_MULTIPLICATION_HPP
+
+#include <vector>
+#include "algorithm.hpp"
+#include "matrix.hpp"
+#include "matrix_power.hpp"
+#include "multiply_chain.hpp"
+#include "multiply_classic.hpp"
+#include "multiply_gram.hpp"
+#include "multiply_laderman.hpp"
+#include "multiply_rectangular.hpp"
+#include "multiply_strassen.hpp"
+#include "packed_operand.hpp"
+#include "transpose.hpp"
+
+// Main algorithms of the library in one header.
+//
+// When the compiled library (target fast_matrix_multiplication) is used, FAST_MATRIX_MULTIPLICATION_LIBRARY
+// is defined and the algorithms below are declared as explicit instantiations for ints, long longs, floats
+// and doubles: they are compiled once in the library (instantiations.cpp) instead of in every translation
+// unit that includes this header. Other types and other functions are still instantiated where they are used.
+
+#ifdef FAST_MATRIX_MULTIPLICATION_LIBRARY
+
+// instantiations.cpp defines this as empty, to instantiate everything below
+#ifndef FAST_MATRIX_MULTIPLICATION_EXTERN
+#define FAST_MATRIX_MULTIPLICATION_EXTERN extern
+#endif
+
+#define FAST_MATRIX_MULTIPLICATION_INSTANTIATE(Scalar) \
+    FAST_MATRIX_MULTIPLICATION_EXTERN template void classic_kernel<Scalar, PlusTimes<Scalar>>( \
+            unsigned int, unsigned int, unsigned int, const Scalar *, unsigned int, Op, const Scalar *, unsigned int, \
+            Op, Scalar *, unsigned int, const PlusTimes<Scalar> &); \
+    FAST_MATRIX_MULTIPLICATION_EXTERN template void classic_kernel_parallel<Scalar, PlusTimes<Scalar>>( \
+            unsigned int, unsigned int, unsigned int, const Scalar *, unsigned int, Op, const Scalar *, unsigned int, \
+            Op, Scalar *, unsigned int, const PlusTimes<Scalar> &, ThreadPool &); \
+    FAST_MATRIX_MULTIPLICATION_EXTERN template Matrix<Scalar> multiply_classic( \
+            const Matrix<Scalar> &, const Matrix<Scalar> &, Op, Op, ThreadPool &); \
+    FAST_MATRIX_MULTIPLICATION_EXTERN template Matrix<Scalar> multiply_strassen_dynamic( \
+            const Matrix<Scalar> &, const Matrix<Scalar> &, Op, Op); \
+    FAST_MATRIX_MULTIPLICATION_EXTERN template Matrix<Scalar> multiply_strassen_static( \
+            const Matrix<Scalar> &, const Matrix<Scalar> &, Op, Op); \
+    FAST_MATRIX_MULTIPLICATION_EXTERN template Matrix<Scalar> multiply_laderman( \
+            const Matrix<Scalar> &, const Matrix<Scalar> &, Op, Op); \
+    FAST_MATRIX_MULTIPLICATION_EXTERN template Matrix<Scalar> multiply_rectangular( \
+            const Matrix<Scalar> &, const Matrix<Scalar> &); \
+    FAST_MATRIX_MULTIPLICATION_EXTERN template Matrix<Scalar> multiply( \
+            const Matrix<Scalar> &, const Matrix<Scalar> &, Algorithm); \
+    FAST_MATRIX_MULTIPLICATION_EXTERN template Matrix<Scalar> multiply_gram( \
+            const Matrix<Scalar> &, Triangle, Algorithm); \
+    FAST_MATRIX_MULTIPLICATION_EXTERN template Matrix<Scalar> multiply_square(const Matrix<Scalar> &, Algorithm); \
+    FAST_MATRIX_MULTIPLICATION_EXTERN template Matrix<Scalar> matrix_power( \
+            const Matrix<Scalar> &, unsigned long long, Algorithm); \
+    FAST_MATRIX_MULTIPLICATION_EXTERN template Matrix<Scalar> multiply_chain( \
+            const std::vector<const Matrix<Scalar> *> &, Algorithm); \
+    FAST_MATRIX_MULTIPLICATION_EXTERN template PackedOperand<Scalar> pack_operand( \
+            const Matrix<Scalar> &, Algorithm, unsigned int, Op); \
+    FAST_MATRIX_MULTIPLICATION_EXTERN template Matrix<Scalar> multiply_packed( \
+            const Matrix<Scalar> &, const PackedOperand<Scalar> &);
+
+FAST_MATRIX_MULTIPLICATION_INSTANTIATE(int)
+FAST_MATRIX_MULTIPLICATION_INSTANTIATE(long long)
+FAST_MATRIX_MULTIPLICATION_INSTANTIATE(float)
+FAST_MATRIX_MULTIPLICATION_INSTANTIATE(double)
+
+#undef FAST_MATRIX_MULTIPLICATION_INSTANTIATE
+
+#endif
+
+#endif //FAST_MATRIX_MULTIPLICATION_FAST_MATRIX_MULTIPLICATION_HPP
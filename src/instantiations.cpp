@@ -0,0 +1,3 @@
+// explicit instantiations of the compiled library, declared in fast_matrix_multiplication.hpp
+#define FAST_MATRIX_MULTIPLICATION_EXTERN
+#include "fast_matrix_multiplication.hpp"
@@ -0,0 +1,131 @@
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include "multiply_classic.hpp"
+
+// Runtime choice of classic block kernels of the compiled library.
+//
+// Kernels for AVX2 and AVX-512 are compiled in their own files with flags for these instruction sets
+// (when the compiler supports them), the baseline kernels here are compiled with flags of the whole library.
+// The widest kernels the processor supports are used, unless environment variable
+// FAST_MATRIX_MULTIPLICATION_ISA names other ones or select_classic_kernel_isa() is called.
+
+typedef void (*ClassicFloatKernel)(unsigned int, unsigned int, unsigned int, const float *, unsigned int,
+                                   const float *, unsigned int, float *, unsigned int);
+typedef void (*ClassicDoubleKernel)(unsigned int, unsigned int, unsigned int, const double *, unsigned int,
+                                    const double *, unsigned int, double *, unsigned int);
+
+#ifdef FAST_MATRIX_MULTIPLICATION_AVX512_KERNELS
+void classic_block_kernel_avx512(unsigned int rows, unsigned int cols, unsigned int inner,
+                                 const float *A, unsigned int lda, const float *B, unsigned int ldb,
+                                 float *C, unsigned int ldc);
+
+void classic_block_kernel_avx512(unsigned int rows, unsigned int cols, unsigned int inner,
+                                 const double *A, unsigned int lda, const double *B, unsigned int ldb,
+                                 double *C, unsigned int ldc);
+#endif
+
+#ifdef FAST_MATRIX_MULTIPLICATION_AVX2_KERNELS
+void classic_block_kernel_avx2(unsigned int rows, unsigned int cols, unsigned int inner,
+                               const float *A, unsigned int lda, const float *B, unsigned int ldb,
+                               float *C, unsigned int ldc);
+
+void classic_block_kernel_avx2(unsigned int rows, unsigned int cols, unsigned int inner,
+                               const double *A, unsigned int lda, const double *B, unsigned int ldb,
+                               double *C, unsigned int ldc);
+#endif
+
+// kernels compiled with flags of the library (SIMD kernels if some instruction set is enabled)
+template<class Scalar>
+static void classic_block_kernel_baseline(unsigned int rows, unsigned int cols, unsigned int inner,
+                                          const Scalar *A, unsigned int lda, const Scalar *B, unsigned int ldb,
+                                          Scalar *C, unsigned int ldc) {
+#ifdef FAST_MATRIX_MULTIPLICATION_SIMD
+    classic_block_kernel_simd(rows, cols, inner, A, lda, B, ldb, C, ldc);
+#else
+    classic_block_kernel<Scalar>(rows, cols, inner, A, lda, B, ldb, C, ldc);
+#endif
+}
+
+struct ClassicKernels {
+    const char *isa;
+    ClassicFloatKernel float_kernel;
+    ClassicDoubleKernel double_kernel;
+};
+
+// all compiled kernels, widest first
+static const ClassicKernels classic_kernels[] = {
+#ifdef FAST_MATRIX_MULTIPLICATION_AVX512_KERNELS
+        {"avx512", classic_block_kernel_avx512, classic_block_kernel_avx512},
+#endif
+#ifdef FAST_MATRIX_MULTIPLICATION_AVX2_KERNELS
+        {"avx2", classic_block_kernel_avx2, classic_block_kernel_avx2},
+#endif
+        {"generic", classic_block_kernel_baseline<float>, classic_block_kernel_baseline<double>}
+};
+
+static bool classic_kernels_supported(const ClassicKernels &kernels) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    if (std::strcmp(kernels.isa, "avx512") == 0) {
+        return __builtin_cpu_supports("avx512f");
+    }
+    if (std::strcmp(kernels.isa, "avx2") == 0) {
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    }
+#endif
+    return std::strcmp(kernels.isa, "generic") == 0;
+}
+
+// supported kernels for given instruction set, nullptr if there are none
+static const ClassicKernels *classic_kernels_find(const char *isa) {
+    for (const ClassicKernels &kernels : classic_kernels) {
+        if (std::strcmp(kernels.isa, isa) == 0 && classic_kernels_supported(kernels)) {
+            return &kernels;
+        }
+    }
+    return nullptr;
+}
+
+// kernels in use, chosen at first use
+static std::atomic<const ClassicKernels *> &classic_kernels_current() {
+    static std::atomic<const ClassicKernels *> current([]() {
+        const char *requested = std::getenv("FAST_MATRIX_MULTIPLICATION_ISA");
+        if (requested != nullptr && classic_kernels_find(requested) != nullptr) {
+            return classic_kernels_find(requested);
+        }
+        for (const ClassicKernels &kernels : classic_kernels) {
+            if (classic_kernels_supported(kernels)) {
+                return &kernels;
+            }
+        }
+        return &classic_kernels[0];
+    }());
+    return current;
+}
+
+void classic_block_kernel_dispatch(unsigned int rows, unsigned int cols, unsigned int inner,
+                                   const float *A, unsigned int lda, const float *B, unsigned int ldb,
+                                   float *C, unsigned int ldc) {
+    classic_kernels_current().load(std::memory_order_relaxed)->float_kernel(rows, cols, inner, A, lda, B, ldb,
+                                                                            C, ldc);
+}
+
+void classic_block_kernel_dispatch(unsigned int rows, unsigned int cols, unsigned int inner,
+                                   const double *A, unsigned int lda, const double *B, unsigned int ldb,
+                                   double *C, unsigned int ldc) {
+    classic_kernels_current().load(std::memory_order_relaxed)->double_kernel(rows, cols, inner, A, lda, B, ldb,
+                                                                             C, ldc);
+}
+
+const char *classic_kernel_isa() {
+    return classic_kernels_current().load(std::memory_order_relaxed)->isa;
+}
+
+bool select_classic_kernel_isa(const char *isa) {
+    const ClassicKernels *kernels = classic_kernels_find(isa);
+    if (kernels == nullptr) {
+        return false;
+    }
+    classic_kernels_current().store(kernels, std::memory_order_relaxed);
+    return true;
+}
@@ -0,0 +1,16 @@
+#include "block_kernel.hpp"
+
+// classic block kernels compiled with AVX-512 (the build adds flags for this file only),
+// they are used by kernels.cpp only on processors that support them
+
+void classic_block_kernel_avx512(unsigned int rows, unsigned int cols, unsigned int inner,
+                                 const float *A, unsigned int lda, const float *B, unsigned int ldb,
+                                 float *C, unsigned int ldc) {
+    classic_block_kernel_simd(rows, cols, inner, A, lda, B, ldb, C, ldc);
+}
+
+void classic_block_kernel_avx512(unsigned int rows, unsigned int cols, unsigned int inner,
+                                 const double *A, unsigned int lda, const double *B, unsigned int ldb,
+                                 double *C, unsigned int ldc) {
+    classic_block_kernel_simd(rows, cols, inner, A, lda, B, ldb, C, ldc);
+}
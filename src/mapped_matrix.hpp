@@ -0,0 +1,286 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_MAPPED_MATRIX_HPP
+#define FAST_MATRIX_MULTIPLICATION_MAPPED_MATRIX_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "matrix.hpp"
+
+// Memory mapped file, mapping is removed when last owner is destroyed.
+class MemoryMapping {
+public:
+    // maps whole file, file is extended (with zeros) to at least `length` bytes if writable
+    MemoryMapping(const std::string &path, std::size_t length, bool writable, bool create) {
+        int flags = writable ? O_RDWR : O_RDONLY;
+        if (create) {
+            flags |= O_CREAT | O_TRUNC;
+        }
+        int fd = ::open(path.c_str(), flags, 0644);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "cannot open " + path);
+        }
+        map(fd, length, writable, path);
+    }
+
+    // maps anonymous temporary file of `length` bytes, created in directory and unlinked immediately,
+    // so it is removed even if program crashes (pages can still be written back to disk)
+    MemoryMapping(std::size_t length, const std::string &directory) {
+        std::string path = directory + "/fast_matrix_multiplication_XXXXXX";
+        std::vector<char> name(path.begin(), path.end());
+        name.push_back('\0');
+
+        int fd = ::mkstemp(name.data());
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "cannot create temporary file in " + directory);
+        }
+        ::unlink(name.data());
+        map(fd, length, true, path);
+    }
+
+    MemoryMapping(const MemoryMapping &) = delete;
+
+    MemoryMapping &operator=(const MemoryMapping &) = delete;
+
+    ~MemoryMapping() {
+        if (address != nullptr) {
+            ::munmap(address, length);
+        }
+    }
+
+    char *data() const {
+        return static_cast<char *>(address);
+    }
+
+    std::size_t size() const {
+        return length;
+    }
+
+    // hint to the kernel that bytes [offset, offset + bytes) will be needed soon, reading starts in background
+    void will_need(std::size_t offset, std::size_t bytes) const {
+        advise(offset, bytes, MADV_WILLNEED);
+    }
+
+    // hint to the kernel that bytes [offset, offset + bytes) will not be needed for a while
+    // (data is not lost, shared mapping is backed by a file)
+    void dont_need(std::size_t offset, std::size_t bytes) const {
+        advise(offset, bytes, MADV_DONTNEED);
+    }
+
+    // write changes back to file
+    void flush() const {
+        if (address != nullptr && ::msync(address, length, MS_SYNC) != 0) {
+            throw std::system_error(errno, std::generic_category(), "msync failed");
+        }
+    }
+
+private:
+    void *address = nullptr;
+    std::size_t length = 0;
+
+    void map(int fd, std::size_t _length, bool writable, const std::string &path) {
+        struct stat status;
+        if (::fstat(fd, &status) != 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "cannot stat " + path);
+        }
+
+        // read only files are mapped as they are, writable files are extended to requested size
+        length = static_cast<std::size_t>(status.st_size);
+        if (writable && length < _length) {
+            if (::ftruncate(fd, static_cast<off_t>(_length)) != 0) {
+                int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), "cannot resize " + path);
+            }
+            length = _length;
+        }
+        if (length < _length) {
+            ::close(fd);
+            throw std::system_error(EINVAL, std::generic_category(), path + " is too small");
+        }
+
+        if (length > 0) {
+            int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+            address = ::mmap(nullptr, length, protection, MAP_SHARED, fd, 0);
+            if (address == MAP_FAILED) {
+                address = nullptr;
+                int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), "cannot map " + path);
+            }
+        }
+        // mapping stays valid after file descriptor is closed
+        ::close(fd);
+    }
+
+    void advise(std::size_t offset, std::size_t bytes, int advice) const {
+        if (address == nullptr || bytes == 0) {
+            return;
+        }
+        // madvise needs page aligned address
+        std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        std::size_t begin = offset / page * page;
+        std::size_t end = std::min(length, offset + bytes);
+        ::madvise(data() + begin, end - begin, advice);
+    }
+};
+
+// File backed matrix, stored row by row in a memory mapped file.
+// Only parts that are accessed are loaded into memory (by the kernel, page by page), so matrix
+// can be much larger than RAM. Blocks are views: they share the mapping with the parent matrix.
+// Note that sizes of mapped matrices may overflow unsigned int when multiplied, all offsets use size_t.
+template<class Scalar>
+class MappedMatrix {
+public:
+    // number of rows in this matrix
+    unsigned int rows;
+    // number of columns in this matrix
+    unsigned int cols;
+
+    // default constructor is empty matrix
+    MappedMatrix() : rows(0), cols(0), stride(0), offset(0) {}
+
+    // creates new file (or truncates existing one) for rows x cols matrix filled with zeros
+    static MappedMatrix<Scalar> create(const std::string &path, unsigned int rows, unsigned int cols) {
+        auto mapping = std::make_shared<MemoryMapping>(path, bytes(rows, cols), true, true);
+        return MappedMatrix<Scalar>(mapping, rows, cols, cols, 0);
+    }
+
+    // maps existing file with rows x cols matrix, data starts `offset` bytes after the beginning of file
+    static MappedMatrix<Scalar> open(const std::string &path, unsigned int rows, unsigned int cols,
+                                     bool writable = false, std::size_t offset = 0) {
+        auto mapping = std::make_shared<MemoryMapping>(path, offset + bytes(rows, cols), writable, false);
+        assert(offset % alignof(Scalar) == 0);
+        return MappedMatrix<Scalar>(mapping, rows, cols, cols, offset);
+    }
+
+    // rows x cols matrix of zeros in an unnamed temporary file in given directory
+    static MappedMatrix<Scalar> temporary(unsigned int rows, unsigned int cols,
+                                          const std::string &directory = "/tmp") {
+        auto mapping = std::make_shared<MemoryMapping>(bytes(rows, cols), directory);
+        return MappedMatrix<Scalar>(mapping, rows, cols, cols, 0);
+    }
+
+    // writes matrix A to a new file
+    static MappedMatrix<Scalar> from_matrix(const std::string &path, const Matrix<Scalar> &A) {
+        MappedMatrix<Scalar> mapped = create(path, A.rows, A.cols);
+        mapped.store({0, 0}, A);
+        return mapped;
+    }
+
+    // view of a block, no data is copied
+    MappedMatrix<Scalar> block(std::pair<unsigned int, unsigned int> top_left,
+                               std::pair<unsigned int, unsigned int> block_size) const {
+        assert(top_left.first + block_size.first <= rows && top_left.second + block_size.second <= cols);
+        return MappedMatrix<Scalar>(mapping, block_size.first, block_size.second, stride,
+                                    offset + element_offset(top_left.first, top_left.second) * sizeof(Scalar));
+    }
+
+    // copy block into memory
+    Matrix<Scalar> load(std::pair<unsigned int, unsigned int> top_left,
+                        std::pair<unsigned int, unsigned int> block_size) const {
+        assert(top_left.first + block_size.first <= rows && top_left.second + block_size.second <= cols);
+
+        Matrix<Scalar> block(std::vector<Scalar>(std::size_t(block_size.first) * block_size.second),
+                             block_size.first, block_size.second);
+        for (unsigned int i = 0; i < block_size.first; ++i) {
+            const Scalar *row = data() + element_offset(top_left.first + i, top_left.second);
+            std::copy(row, row + block_size.second, block.data.begin() + std::size_t(i) * block_size.second);
+        }
+        return block;
+    }
+
+    // copy whole matrix into memory
+    Matrix<Scalar> to_matrix() const {
+        return load({0, 0}, {rows, cols});
+    }
+
+    // overwrite block starting at top_left with given matrix
+    void store(std::pair<unsigned int, unsigned int> top_left, const Matrix<Scalar> &block) {
+        assert(top_left.first + block.rows <= rows && top_left.second + block.cols <= cols);
+
+        for (unsigned int i = 0; i < block.rows; ++i) {
+            auto row = block.data.begin() + std::size_t(i) * block.cols;
+            std::copy(row, row + block.cols, data() + element_offset(top_left.first + i, top_left.second));
+        }
+    }
+
+    // add block starting at top_left, multiplied by coefficient (coefficients of fast algorithms are small integers)
+    void block_add(std::pair<unsigned int, unsigned int> top_left, const Matrix<Scalar> &block, int coefficient = 1) {
+        assert(top_left.first + block.rows <= rows && top_left.second + block.cols <= cols);
+
+        const Scalar factor = Scalar(coefficient);
+        for (unsigned int i = 0; i < block.rows; ++i) {
+            Scalar *row = data() + element_offset(top_left.first + i, top_left.second);
+            const Scalar *block_row = block.data.data() + std::size_t(i) * block.cols;
+            if (coefficient == 1) {
+                for (unsigned int j = 0; j < block.cols; ++j) {
+                    row[j] += block_row[j];
+                }
+            } else if (coefficient == -1) {
+                for (unsigned int j = 0; j < block.cols; ++j) {
+                    row[j] -= block_row[j];
+                }
+            } else {
+                for (unsigned int j = 0; j < block.cols; ++j) {
+                    row[j] += factor * block_row[j];
+                }
+            }
+        }
+    }
+
+    // ask the kernel to start reading rows [first_row, first_row + count) in background
+    void prefetch_rows(unsigned int first_row, unsigned int count) const {
+        if (count == 0) {
+            return;
+        }
+        mapping->will_need(offset + element_offset(first_row, 0) * sizeof(Scalar),
+                           (std::size_t(count - 1) * stride + cols) * sizeof(Scalar));
+    }
+
+    // write changes back to file
+    void flush() const {
+        if (mapping) {
+            mapping->flush();
+        }
+    }
+
+private:
+    // shared by all views of the same file
+    std::shared_ptr<MemoryMapping> mapping;
+    // distance between rows (in elements), larger than cols for block views
+    std::size_t stride;
+    // byte offset of element (0, 0) in the file
+    std::size_t offset;
+
+    MappedMatrix(std::shared_ptr<MemoryMapping> _mapping, unsigned int _rows, unsigned int _cols,
+                 std::size_t _stride, std::size_t _offset) : rows(_rows), cols(_cols), mapping(std::move(_mapping)),
+                                                             stride(_stride), offset(_offset) {}
+
+    static std::size_t bytes(unsigned int rows, unsigned int cols) {
+        return std::size_t(rows) * cols * sizeof(Scalar);
+    }
+
+    std::size_t element_offset(unsigned int i, unsigned int j) const {
+        return std::size_t(i) * stride + j;
+    }
+
+    Scalar *data() const {
+        return reinterpret_cast<Scalar *>(mapping->data() + offset);
+    }
+};
+
+#endif //FAST_MATRIX_MULTIPLICATION_MAPPED_MATRIX_HPP
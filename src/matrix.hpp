@@ -8,6 +8,7 @@
 #include<algorithm>
 #include<iterator>
 #include <tuple>
+#include "transpose.hpp"
 
 template<class Scalar>
 class Matrix {
@@ -67,13 +68,9 @@ public:
     }
 
     // return transposed  matrix
-    Matrix<Scalar> transposed() {
+    Matrix<Scalar> transposed() const {
         std::vector<Scalar> new_data(rows * cols);
-        for (unsigned int i = 0; i < rows; ++i) {
-            for (unsigned int j = 0; j < cols; ++j) {
-                new_data[j * rows + i] = data[i * cols + j];
-            }
-        }
+        transpose_blocked(data.data(), cols, rows, cols, new_data.data(), rows);
         return Matrix<Scalar>(new_data, cols, rows);
     }
 
@@ -110,6 +107,32 @@ public:
         return block;
     }
 
+    // block sub-matrix of op(current matrix), top_left and block_size are given in coordinates of op(this)
+    // for transposed matrix, block is transposed while it is copied, so this costs no extra pass over data
+    Matrix<Scalar> subblock(std::pair<unsigned int, unsigned int> top_left,
+                            std::pair<unsigned int, unsigned int> block_size, Op op) const {
+        if (op == Op::none) {
+            return subblock(top_left, block_size);
+        }
+
+        // unpack
+        unsigned int start_row, start_col;
+        unsigned int block_rows, block_cols;
+
+        std::tie(start_row, start_col) = top_left;
+        std::tie(block_rows, block_cols) = block_size;
+
+        // check dimensions (rows of op(this) are columns of this)
+        assert(start_row + block_rows <= cols);
+        assert(start_col + block_cols <= rows);
+
+        // block[i][j] = this[start_col + j][start_row + i]
+        Matrix<Scalar> block(std::vector<Scalar>(block_rows * block_cols), block_rows, block_cols);
+        transpose_blocked(data.data() + start_col * cols + start_row, cols, block_cols, block_rows,
+                          block.data.data(), block_cols);
+        return block;
+    }
+
     // add block starting from top_left to this matrix
     Matrix<Scalar> &block_add(std::pair<unsigned int, unsigned int> top_left, const Matrix<Scalar> &block) {
         unsigned int start_row = top_left.first;
@@ -155,6 +178,24 @@ public:
         return *this;
     }
 
+    // add op(block) starting from top_left to this matrix
+    Matrix<Scalar> &block_add(std::pair<unsigned int, unsigned int> top_left, const Matrix<Scalar> &block, Op op) {
+        if (op == Op::none) {
+            return block_add(top_left, block);
+        }
+        transposed_block_update<false>(top_left, block);
+        return *this;
+    }
+
+    // subtract op(block) starting from top_left from this matrix
+    Matrix<Scalar> &block_subtract(std::pair<unsigned int, unsigned int> top_left, const Matrix<Scalar> &block, Op op) {
+        if (op == Op::none) {
+            return block_subtract(top_left, block);
+        }
+        transposed_block_update<true>(top_left, block);
+        return *this;
+    }
+
     // add other matrix to this matrix
     // does not create new matrix, changes current one
     Matrix<Scalar> &operator+=(const Matrix<Scalar> &other) {
@@ -217,8 +258,56 @@ public:
     bool operator!=(const Matrix<Scalar> &other) const {
         return !(*this == other);
     }
+
+    // check if all elements are zero (stops at the first nonzero element)
+    bool is_zero() const {
+        for (unsigned int i = 0; i < rows * cols; ++i) {
+            if (data[i] != Scalar(0)) return false;
+        }
+        return true;
+    }
+
+private:
+    // this[top_left + (j, i)] += block[i][j] (or -= if subtract is set)
+    // walks both matrices tile by tile (same as transpose_blocked), so strided writes stay in cache
+    template<bool subtract>
+    void transposed_block_update(std::pair<unsigned int, unsigned int> top_left, const Matrix<Scalar> &block) {
+        unsigned int start_row = top_left.first;
+        unsigned int start_col = top_left.second;
+
+        // check if dimensions are correct
+        assert(start_row + block.cols <= rows && start_col + block.rows <= cols);
+
+        for (unsigned int i0 = 0; i0 < block.rows; i0 += transpose_block_size) {
+            unsigned int i1 = std::min(block.rows, i0 + transpose_block_size);
+            for (unsigned int j0 = 0; j0 < block.cols; j0 += transpose_block_size) {
+                unsigned int j1 = std::min(block.cols, j0 + transpose_block_size);
+                for (unsigned int i = i0; i < i1; ++i) {
+                    for (unsigned int j = j0; j < j1; ++j) {
+                        if (subtract) {
+                            data[(start_row + j) * cols + start_col + i] -= block.data[i * block.cols + j];
+                        } else {
+                            data[(start_row + j) * cols + start_col + i] += block.data[i * block.cols + j];
+                        }
+                    }
+                }
+            }
+        }
+    }
 };
 
+// number of rows of op(A)
+template<class Scalar>
+unsigned int op_rows(const Matrix<Scalar> &A, Op op) {
+    return op == Op::none ? A.rows : A.cols;
+}
+
+// number of columns of op(A)
+template<class Scalar>
+unsigned int op_cols(const Matrix<Scalar> &A, Op op) {
+    return op == Op::none ? A.cols : A.rows;
+}
+
 // Adds two matrices, creates new matrix object, leaves original matrices unchanged
 template<class Scalar>
 Matrix<Scalar> operator+(const Matrix<Scalar> &A, const Matrix<Scalar> &B) {
@@ -0,0 +1,428 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_MATRIX_IO_HPP
+#define FAST_MATRIX_MULTIPLICATION_MATRIX_IO_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapped_matrix.hpp"
+#include "matrix.hpp"
+
+// Binary matrix file format:
+//  - 64 byte header (MatrixFileHeader below, stored in native byte order)
+//  - padding up to data_offset (multiple of alignment, so mapped data is aligned for SIMD loads)
+//  - rows * cols elements, row by row (or column by column for column-major files)
+// Files can be mapped with map_matrix without parsing or copying anything,
+// results can be written row band by row band with MatrixWriter without holding them in memory.
+
+// type of stored elements
+enum class DType : std::uint8_t {
+    int8 = 1,
+    uint8 = 2,
+    int16 = 3,
+    int32 = 4,
+    int64 = 5,
+    float32 = 6,
+    float64 = 7
+};
+
+// order in which elements are stored
+enum class Layout : std::uint8_t {
+    row_major = 0,
+    column_major = 1
+};
+
+// element type of Scalar, only plain numeric types can be stored
+template<class Scalar>
+struct dtype_of;
+
+template<>
+struct dtype_of<std::int8_t> {
+    static const DType value = DType::int8;
+};
+
+template<>
+struct dtype_of<std::uint8_t> {
+    static const DType value = DType::uint8;
+};
+
+template<>
+struct dtype_of<std::int16_t> {
+    static const DType value = DType::int16;
+};
+
+template<>
+struct dtype_of<std::int32_t> {
+    static const DType value = DType::int32;
+};
+
+template<>
+struct dtype_of<std::int64_t> {
+    static const DType value = DType::int64;
+};
+
+// placeholder for specialisations that are not needed on this platform
+struct DTypeUnused;
+
+// long long is another type than std::int64_t where that is long (LP64 Linux), it is stored as int64 too
+template<>
+struct dtype_of<std::conditional<std::is_same<long long, std::int64_t>::value, DTypeUnused, long long>::type> {
+    static const DType value = DType::int64;
+};
+
+template<>
+struct dtype_of<float> {
+    static const DType value = DType::float32;
+};
+
+template<>
+struct dtype_of<double> {
+    static const DType value = DType::float64;
+};
+
+struct MatrixFileHeader {
+    // "FMMX"
+    char magic[4];
+    std::uint16_t version;
+    DType dtype;
+    Layout layout;
+    std::uint32_t element_size;
+    // data_offset is a multiple of alignment
+    std::uint32_t alignment;
+    std::uint64_t rows;
+    std::uint64_t cols;
+    // where elements start, counted from the beginning of file
+    std::uint64_t data_offset;
+    // matrix_checksum of all element bytes
+    std::uint64_t checksum;
+    std::uint64_t reserved[2];
+};
+
+static_assert(sizeof(MatrixFileHeader) == 64, "matrix file header has to be 64 bytes");
+
+const std::uint16_t matrix_file_version = 1;
+
+// default alignment of data (cache line, also enough for AVX-512 loads)
+const std::uint32_t matrix_file_alignment = 64;
+
+// FNV-1a hash, applied to 8 byte words instead of single bytes (so it runs at memory speed)
+// call repeatedly to hash data in pieces, pieces (except the last one) should have lengths divisible by 8
+inline std::uint64_t matrix_checksum(const void *data, std::size_t bytes,
+                                     std::uint64_t hash = 14695981039346656037ull) {
+    const std::uint64_t prime = 1099511628211ull;
+    const unsigned char *iter = static_cast<const unsigned char *>(data);
+
+    std::size_t words = bytes / 8;
+    for (std::size_t i = 0; i < words; ++i) {
+        std::uint64_t word;
+        std::memcpy(&word, iter + 8 * i, 8);
+        hash = (hash ^ word) * prime;
+    }
+    for (std::size_t i = 8 * words; i < bytes; ++i) {
+        hash = (hash ^ iter[i]) * prime;
+    }
+    return hash;
+}
+
+// reads and checks header of a matrix file
+inline MatrixFileHeader read_matrix_header(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "cannot open " + path);
+    }
+
+    MatrixFileHeader header;
+    ssize_t count = ::read(fd, &header, sizeof(header));
+    ::close(fd);
+
+    if (count != static_cast<ssize_t>(sizeof(header)) || std::memcmp(header.magic, "FMMX", 4) != 0) {
+        throw std::runtime_error(path + " is not a matrix file");
+    }
+    if (header.version != matrix_file_version) {
+        throw std::runtime_error(path + " has unsupported version");
+    }
+    return header;
+}
+
+// checks that file stores elements of type Scalar, that its dimensions fit into unsigned int and
+// that the file is long enough for all elements (so mapping it can not fault on access)
+template<class Scalar>
+void check_matrix_header(const MatrixFileHeader &header, const std::string &path) {
+    if (header.dtype != dtype_of<Scalar>::value || header.element_size != sizeof(Scalar)) {
+        throw std::runtime_error(path + " stores elements of different type");
+    }
+
+    const std::uint64_t max_dimension = std::numeric_limits<unsigned int>::max();
+    if (header.rows > max_dimension || header.cols > max_dimension) {
+        throw std::runtime_error(path + " has too large dimensions");
+    }
+    if (header.alignment == 0 || header.alignment % alignof(Scalar) != 0 ||
+        header.data_offset < sizeof(MatrixFileHeader) || header.data_offset % header.alignment != 0) {
+        throw std::runtime_error(path + " has invalid data offset");
+    }
+
+    struct stat status;
+    if (::stat(path.c_str(), &status) != 0) {
+        throw std::system_error(errno, std::generic_category(), "cannot open " + path);
+    }
+    // rows * cols * element_size can not overflow, rows and cols fit into 32 bits
+    const std::uint64_t file_size = status.st_size, data_size = header.rows * header.cols;
+    if (file_size < header.data_offset || (file_size - header.data_offset) / sizeof(Scalar) < data_size) {
+        throw std::runtime_error(path + " is too short");
+    }
+}
+
+// Writes matrix file row by row, rows can be written in any number of calls,
+// only a small buffer is kept in memory. Header (with checksum) is written when writer is closed.
+template<class Scalar>
+class MatrixWriter {
+public:
+    MatrixWriter(const std::string &_path, unsigned int _rows, unsigned int _cols,
+                 Layout _layout = Layout::row_major, std::uint32_t alignment = matrix_file_alignment,
+                 std::size_t buffer_size = std::size_t(1) << 20)
+            : path(_path), rows(_rows), cols(_cols), layout(_layout) {
+        assert(alignment >= alignof(Scalar) && alignment % alignof(Scalar) == 0);
+
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "cannot open " + path);
+        }
+
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "FMMX", 4);
+        header.version = matrix_file_version;
+        header.dtype = dtype_of<Scalar>::value;
+        header.layout = layout;
+        header.element_size = sizeof(Scalar);
+        header.alignment = alignment;
+        header.rows = rows;
+        header.cols = cols;
+        header.data_offset = (sizeof(MatrixFileHeader) + alignment - 1) / alignment * alignment;
+
+        // header is written at the end, for now leave space for it and padding
+        buffer.reserve(std::max<std::size_t>(buffer_size, header.data_offset));
+        buffer.assign(header.data_offset, 0);
+        hash = matrix_checksum(nullptr, 0);
+    }
+
+    MatrixWriter(const MatrixWriter &) = delete;
+
+    MatrixWriter &operator=(const MatrixWriter &) = delete;
+
+    ~MatrixWriter() {
+        if (fd >= 0) {
+            // errors can not be reported from destructor, call close() to see them
+            try {
+                close();
+            } catch (...) {
+            }
+        }
+    }
+
+    // write next `count` rows (or columns, for column-major files) stored one after another
+    void write(const Scalar *data, unsigned int count) {
+        assert(written + count <= (layout == Layout::row_major ? rows : cols));
+
+        const char *bytes = reinterpret_cast<const char *>(data);
+        std::size_t length = std::size_t(count) * (layout == Layout::row_major ? cols : rows) * sizeof(Scalar);
+        append(bytes, length);
+        written += count;
+    }
+
+    // write next rows given as a matrix (block of rows of the result, or block of rows of its
+    // transpose for column-major files)
+    void write(const Matrix<Scalar> &block) {
+        assert(block.cols == (layout == Layout::row_major ? cols : rows));
+        write(block.data.data(), block.rows);
+    }
+
+    // flush buffer and write header, file is complete after this call
+    void close() {
+        if (fd < 0) {
+            return;
+        }
+        if (written != (layout == Layout::row_major ? rows : cols)) {
+            ::close(fd);
+            fd = -1;
+            throw std::runtime_error(path + ": not all rows were written");
+        }
+
+        flush();
+        // last bytes that do not form a whole word
+        header.checksum = matrix_checksum(unhashed.data(), unhashed.size(), hash);
+        if (::pwrite(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+            int error = errno;
+            ::close(fd);
+            fd = -1;
+            throw std::system_error(error, std::generic_category(), "cannot write " + path);
+        }
+        ::close(fd);
+        fd = -1;
+    }
+
+private:
+    std::string path;
+    unsigned int rows, cols;
+    Layout layout;
+    int fd;
+    MatrixFileHeader header;
+    std::vector<char> buffer;
+    std::uint64_t hash;
+    // number of rows already written
+    unsigned int written = 0;
+    // data bytes not yet included in hash (hash is computed in multiples of 8 bytes)
+    std::vector<char> unhashed;
+
+    void append(const char *bytes, std::size_t length) {
+        update_hash(bytes, length);
+        while (length > 0) {
+            std::size_t chunk = std::min(length, buffer.capacity() - buffer.size());
+            buffer.insert(buffer.end(), bytes, bytes + chunk);
+            bytes += chunk;
+            length -= chunk;
+            if (buffer.size() == buffer.capacity()) {
+                flush();
+            }
+        }
+    }
+
+    void update_hash(const char *bytes, std::size_t length) {
+        // complete word that was started by previous write
+        while (!unhashed.empty() && length > 0) {
+            unhashed.push_back(*bytes++);
+            length--;
+            if (unhashed.size() == 8) {
+                hash = matrix_checksum(unhashed.data(), 8, hash);
+                unhashed.clear();
+            }
+        }
+        // bytes left after the loop above can only follow a completed word (else length is 0 here
+        // and the unfinished word has to stay)
+        std::size_t whole = length / 8 * 8;
+        hash = matrix_checksum(bytes, whole, hash);
+        unhashed.insert(unhashed.end(), bytes + whole, bytes + length);
+    }
+
+    void flush() {
+        const char *iter = buffer.data();
+        std::size_t left = buffer.size();
+        while (left > 0) {
+            ssize_t count = ::write(fd, iter, left);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                int error = errno;
+                ::close(fd);
+                fd = -1;
+                throw std::system_error(error, std::generic_category(), "cannot write " + path);
+            }
+            iter += count;
+            left -= count;
+        }
+        buffer.clear();
+    }
+};
+
+// saves matrix A to a file
+template<class Scalar>
+void save_matrix(const std::string &path, const Matrix<Scalar> &A, Layout layout = Layout::row_major) {
+    MatrixWriter<Scalar> writer(path, A.rows, A.cols, layout);
+    if (layout == Layout::row_major) {
+        writer.write(A);
+    } else {
+        writer.write(A.transposed());
+    }
+    writer.close();
+}
+
+// maps matrix file into memory, nothing is read until data is accessed.
+// Column-major file is mapped as its transpose (use Op::transpose to multiply with it).
+// Checksum is verified only if asked, because this reads the whole file.
+template<class Scalar>
+MappedMatrix<Scalar> map_matrix(const std::string &path, bool verify_checksum = false, bool writable = false) {
+    MatrixFileHeader header = read_matrix_header(path);
+    check_matrix_header<Scalar>(header, path);
+
+    unsigned int rows = header.rows, cols = header.cols;
+    if (header.layout == Layout::column_major) {
+        std::swap(rows, cols);
+    }
+    MappedMatrix<Scalar> A = MappedMatrix<Scalar>::open(path, rows, cols, writable, header.data_offset);
+
+    if (verify_checksum) {
+        // hash band of rows by band of rows, rows are contiguous in file
+        std::uint64_t hash = matrix_checksum(nullptr, 0);
+        const unsigned int band = std::max<std::size_t>(1, (std::size_t(1) << 24) / (std::size_t(cols) * sizeof(Scalar) + 1));
+        std::vector<char> tail;
+        for (unsigned int r0 = 0; r0 < rows; r0 += band) {
+            Matrix<Scalar> rows_block = A.load({r0, 0}, {std::min(band, rows - r0), cols});
+            const char *bytes = reinterpret_cast<const char *>(rows_block.data.data());
+            std::size_t length = rows_block.data.size() * sizeof(Scalar);
+            tail.insert(tail.end(), bytes, bytes + length);
+            std::size_t whole = tail.size() / 8 * 8;
+            hash = matrix_checksum(tail.data(), whole, hash);
+            tail.erase(tail.begin(), tail.begin() + whole);
+        }
+        hash = matrix_checksum(tail.data(), tail.size(), hash);
+        if (hash != header.checksum) {
+            throw std::runtime_error(path + ": checksum does not match");
+        }
+    }
+    return A;
+}
+
+// reads matrix file into memory, checksum is always verified
+template<class Scalar>
+Matrix<Scalar> load_matrix(const std::string &path) {
+    MatrixFileHeader header = read_matrix_header(path);
+    check_matrix_header<Scalar>(header, path);
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "cannot open " + path);
+    }
+
+    std::vector<Scalar> data(std::size_t(header.rows) * header.cols);
+    char *iter = reinterpret_cast<char *>(data.data());
+    std::size_t left = data.size() * sizeof(Scalar);
+    off_t position = header.data_offset;
+    while (left > 0) {
+        ssize_t count = ::pread(fd, iter, left, position);
+        if (count <= 0) {
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            ::close(fd);
+            throw std::runtime_error(path + " is too short");
+        }
+        iter += count;
+        position += count;
+        left -= count;
+    }
+    ::close(fd);
+
+    if (matrix_checksum(data.data(), data.size() * sizeof(Scalar)) != header.checksum) {
+        throw std::runtime_error(path + ": checksum does not match");
+    }
+
+    if (header.layout == Layout::column_major) {
+        // data is transpose of the matrix
+        return Matrix<Scalar>(data, header.cols, header.rows).transposed();
+    }
+    return Matrix<Scalar>(data, header.rows, header.cols);
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_MATRIX_IO_HPP
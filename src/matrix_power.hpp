@@ -0,0 +1,257 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_MATRIX_POWER_HPP
+#define FAST_MATRIX_MULTIPLICATION_MATRIX_POWER_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <deque>
+#include <utility>
+#include <vector>
+#include "algorithm.hpp"
+#include "dynamic_peeling.hpp"
+#include "matrix.hpp"
+#include "multiply_classic.hpp"
+#include "scheme.hpp"
+#include "thread_pool.hpp"
+
+// Powers A^k of square matrices by binary exponentiation (one squaring for every bit of k and one product
+// for every bit that is set), with the fast algorithms.
+//
+// Squares have both operands equal, so every level of a squaring splits A into blocks only once,
+// and every linear combination of blocks is calculated once, even if the scheme uses it on both sides
+// or in several products. Products whose both combinations are the same (P1 = (A11 + A22)^2 of Strassen's
+// algorithm, P6 = A11^2 of Laderman's) are squares again.
+//
+// matrix_power() keeps the power and the next power in two matrices that are swapped after every step,
+// and every level of recursion keeps its blocks, combinations and product in a PowerWorkspace. All steps
+// multiply matrices of the same size, so after the first squaring and the first product with A the buffers
+// are large enough and later steps write into existing memory (leaves read operands in place and products
+// are accumulated directly into the result).
+
+// buffers of one level of recursion of power_step()
+template<class Scalar>
+struct PowerLevel {
+    // blocks of the left and the right operand (squares use only blocks of the left one)
+    std::vector<Matrix<Scalar>> A_blocks, B_blocks;
+    // combinations of blocks calculated on this level, the first sums.size() of them are valid,
+    // sums tells of which blocks and with which coefficients
+    std::vector<Matrix<Scalar>> combinations;
+    std::vector<std::pair<const std::vector<Matrix<Scalar>> *, const std::vector<int> *>> sums;
+    // product of the current pair of combinations
+    Matrix<Scalar> P;
+};
+
+// memory of power steps that is kept between them, one PowerLevel for every level of recursion
+// (deque, so levels do not move while deeper ones are added)
+template<class Scalar>
+struct PowerWorkspace {
+    std::deque<PowerLevel<Scalar>> levels;
+};
+
+// matrix becomes rows x cols zero matrix, its memory is reused if it is large enough
+template<class Scalar>
+void power_zeros(Matrix<Scalar> &M, unsigned int rows, unsigned int cols) {
+    M.rows = rows;
+    M.cols = cols;
+    M.data.assign(std::size_t(rows) * cols, Scalar(0));
+}
+
+// splits A into rows x cols grid of blocks of given size, copied into existing matrices of blocks
+template<class Scalar>
+void power_blocks(const Matrix<Scalar> &A, unsigned int rows, unsigned int cols, unsigned int block_rows,
+                  unsigned int block_cols, std::vector<Matrix<Scalar>> &blocks) {
+    blocks.resize(rows * cols);
+    for (unsigned int b = 0; b < rows * cols; ++b) {
+        Matrix<Scalar> &block = blocks[b];
+        block.rows = block_rows;
+        block.cols = block_cols;
+        block.data.resize(std::size_t(block_rows) * block_cols);
+        for (unsigned int i = 0; i < block_rows; ++i) {
+            const Scalar *row = A.data.data() + std::size_t(b / cols * block_rows + i) * A.cols + b % cols * block_cols;
+            std::copy(row, row + block_cols, block.data.data() + std::size_t(i) * block_cols);
+        }
+    }
+}
+
+// sum = sum coefficients[i] * blocks[i], written into existing matrix
+template<class Scalar>
+void power_combination(const std::vector<int> &coefficients, const std::vector<Matrix<Scalar>> &blocks,
+                       Matrix<Scalar> &sum) {
+    assert(coefficients.size() == blocks.size());
+
+    power_zeros(sum, blocks[0].rows, blocks[0].cols);
+    for (unsigned int i = 0; i < coefficients.size(); ++i) {
+        if (coefficients[i] == 1) {
+            sum += blocks[i];
+        } else if (coefficients[i] == -1) {
+            sum -= blocks[i];
+        } else if (coefficients[i] != 0) {
+            const Scalar coefficient(coefficients[i]);
+            for (std::size_t e = 0; e < sum.data.size(); ++e) {
+                sum.data[e] += coefficient * blocks[i].data[e];
+            }
+        }
+    }
+}
+
+// C_l += coefficients[l] * P for all blocks of C (as scheme_accumulate(), without temporaries)
+template<class Scalar>
+void power_accumulate(const std::vector<int> &coefficients, const Matrix<Scalar> &P, Matrix<Scalar> &C,
+                      unsigned int n) {
+    for (unsigned int l = 0; l < coefficients.size(); ++l) {
+        if (coefficients[l] == 0) {
+            continue;
+        }
+        const Scalar coefficient(coefficients[l]);
+        for (unsigned int i = 0; i < P.rows; ++i) {
+            Scalar *row_C = C.data.data() + std::size_t(l / n * P.rows + i) * C.cols + l % n * P.cols;
+            const Scalar *row_P = P.data.data() + std::size_t(i) * P.cols;
+            if (coefficients[l] == 1) {
+                for (unsigned int j = 0; j < P.cols; ++j) {
+                    row_C[j] += row_P[j];
+                }
+            } else if (coefficients[l] == -1) {
+                for (unsigned int j = 0; j < P.cols; ++j) {
+                    row_C[j] -= row_P[j];
+                }
+            } else {
+                for (unsigned int j = 0; j < P.cols; ++j) {
+                    row_C[j] += coefficient * row_P[j];
+                }
+            }
+        }
+    }
+}
+
+// result = A B (or A A if B is nullptr) calculated with chosen algorithm, written into memory of result,
+// level `depth` of recursion and deeper ones use buffers of the workspace
+template<class Scalar>
+void power_step(const Matrix<Scalar> &A, const Matrix<Scalar> *B, Algorithm algorithm, Matrix<Scalar> &result,
+                PowerWorkspace<Scalar> &workspace, std::size_t depth = 0) {
+    const Matrix<Scalar> &right = B != nullptr ? *B : A;
+    // check dimensions (result can not be an operand)
+    assert(A.cols == right.rows);
+    assert(&result != &A && &result != &right);
+
+    power_zeros(result, A.rows, right.cols);
+
+    const Scheme *scheme = algorithm_recursion_scheme(algorithm, A.rows, A.cols, right.cols);
+    if (scheme == nullptr) {
+        // bands of rows are multiplied by threads of the pool, operands are read in place
+        const unsigned int band = classic_parallel_rows(A.rows, right.cols, A.cols);
+        parallel_for(0, A.rows, band, [&](unsigned int first, unsigned int last) {
+            classic_kernel(last - first, right.cols, A.cols, A.data.data() + std::size_t(first) * A.cols, A.cols,
+                           Op::none, right.data.data(), right.cols, Op::none,
+                           result.data.data() + std::size_t(first) * result.cols, result.cols);
+        });
+        return;
+    }
+
+    if (workspace.levels.size() <= depth) {
+        workspace.levels.emplace_back();
+    }
+    PowerLevel<Scalar> &level = workspace.levels[depth];
+
+    // squares with a square scheme split A only once
+    const bool square = B == nullptr && scheme->m == scheme->k && scheme->k == scheme->n;
+    const unsigned int block_rows = A.rows / scheme->m, block_inner = A.cols / scheme->k,
+            block_cols = right.cols / scheme->n;
+    power_blocks(A, scheme->m, scheme->k, block_rows, block_inner, level.A_blocks);
+    if (!square) {
+        power_blocks(right, scheme->k, scheme->n, block_inner, block_cols, level.B_blocks);
+    }
+    const std::vector<Matrix<Scalar>> &B_blocks = square ? level.A_blocks : level.B_blocks;
+
+    // combinations calculated on this level (references into `combinations` must stay valid)
+    level.sums.clear();
+    level.combinations.reserve(2 * scheme->rank());
+    auto combination = [&level](const std::vector<int> &coefficients,
+                                const std::vector<Matrix<Scalar>> &blocks) -> const Matrix<Scalar> & {
+        for (std::size_t i = 0; i < level.sums.size(); ++i) {
+            if (level.sums[i].first == &blocks && *level.sums[i].second == coefficients) {
+                return level.combinations[i];
+            }
+        }
+        if (level.combinations.size() == level.sums.size()) {
+            level.combinations.emplace_back();
+        }
+        Matrix<Scalar> &sum = level.combinations[level.sums.size()];
+        level.sums.emplace_back(&blocks, &coefficients);
+        power_combination(coefficients, blocks, sum);
+        return sum;
+    };
+
+    // rows and columns left out by the scheme are calculated meanwhile
+    TaskGroup peeling;
+    dynamic_peeling_start(A, right, result, scheme->m, scheme->n, peeling);
+
+    for (const SchemeProduct &product : scheme->products) {
+        const Matrix<Scalar> &left = combination(product.a, level.A_blocks);
+        if (square && product.a == product.b) {
+            power_step(left, static_cast<const Matrix<Scalar> *>(nullptr), algorithm, level.P, workspace,
+                       depth + 1);
+        } else {
+            power_step(left, &combination(product.b, B_blocks), algorithm, level.P, workspace, depth + 1);
+        }
+        power_accumulate(product.c, level.P, result, scheme->n);
+    }
+
+    dynamic_peeling_update(A, right, result, scheme->m, scheme->k, scheme->n);
+    peeling.wait();
+}
+
+// C = A A calculated with chosen algorithm, in memory of C and of the workspace
+template<class Scalar>
+void multiply_square(const Matrix<Scalar> &A, Algorithm algorithm, Matrix<Scalar> &C,
+                     PowerWorkspace<Scalar> &workspace) {
+    // check dimensions
+    assert(A.rows == A.cols);
+
+    power_step(A, static_cast<const Matrix<Scalar> *>(nullptr), algorithm, C, workspace);
+}
+
+// A A calculated with chosen algorithm
+template<class Scalar>
+Matrix<Scalar> multiply_square(const Matrix<Scalar> &A, Algorithm algorithm = Algorithm::strassen) {
+    Matrix<Scalar> C;
+    PowerWorkspace<Scalar> workspace;
+    multiply_square(A, algorithm, C, workspace);
+    return C;
+}
+
+// A^exponent calculated with chosen algorithm (identity matrix for exponent 0)
+template<class Scalar>
+Matrix<Scalar> matrix_power(const Matrix<Scalar> &A, unsigned long long exponent,
+                            Algorithm algorithm = Algorithm::strassen) {
+    // check dimensions
+    assert(A.rows == A.cols);
+
+    if (exponent == 0) {
+        Matrix<Scalar> identity = Matrix<Scalar>::zeros(A.rows, A.cols);
+        for (unsigned int i = 0; i < A.rows; ++i) {
+            identity.data[std::size_t(i) * A.cols + i] = Scalar(1);
+        }
+        return identity;
+    }
+
+    // bits of exponent from the highest one: square, then multiply by A if the bit is set
+    unsigned int bit = 0;
+    while (bit + 1 < 64 && (exponent >> (bit + 1)) != 0) {
+        bit++;
+    }
+
+    // power calculated so far and the next one
+    Matrix<Scalar> power = A, next;
+    PowerWorkspace<Scalar> workspace;
+    while (bit-- > 0) {
+        multiply_square(power, algorithm, next, workspace);
+        std::swap(power, next);
+        if ((exponent >> bit) & 1) {
+            power_step(power, &A, algorithm, next, workspace);
+            std::swap(power, next);
+        }
+    }
+    return power;
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_MATRIX_POWER_HPP
@@ -0,0 +1,341 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_MODULAR_HPP
+#define FAST_MATRIX_MULTIPLICATION_MODULAR_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+#include "multiply_classic.hpp"
+#include "transpose.hpp"
+#include "wide_integer.hpp"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Arithmetic modulo a prime p, so matrices over Z/pZ can be multiplied with all algorithms in this library.
+// Over a finite field additions and subtractions of fast algorithms cost nothing in accuracy,
+// so Strassen and Laderman give exactly the same result as classic multiplication.
+//
+// Classic kernel is specialized for Mod<p>: products are summed in a double width integer
+// and reduced only when the sum could overflow (delayed reduction), so most terms cost one multiplication
+// and one addition. For odd p < 2^31 and AVX2, four products are computed per instruction and sums are
+// reduced with vectorized Montgomery reduction.
+
+// residue modulo p, for 32-bit and 64-bit moduli (p < 2^63, so a sum of two residues does not overflow)
+// p should be prime for division, other operations work for any modulus
+template<std::uint64_t p>
+class Mod {
+    static_assert(p > 1 && p < (std::uint64_t(1) << 63), "modulus has to be between 2 and 2^63");
+
+public:
+    // residues are stored in 32 bits if possible, products of two residues fit in Wide
+    typedef typename std::conditional<(p <= 0xffffffffu), std::uint32_t, std::uint64_t>::type Word;
+    typedef typename std::conditional<(p <= 0xffffffffu), std::uint64_t, wide_uint128>::type Wide;
+
+    static constexpr std::uint64_t modulus = p;
+
+    // representative from 0 to p - 1
+    Word value;
+
+    Mod() : value(0) {}
+
+    // any integer (also negative) is reduced modulo p
+    template<class Integer, class = typename std::enable_if<std::is_integral<Integer>::value>::type>
+    Mod(Integer x) {
+        if (x < 0) {
+            // -x may not be representable, so 1 is added first
+            Word remainder = Word((std::uint64_t(-(x + 1)) + 1) % p);
+            value = remainder == 0 ? 0 : Word(p - remainder);
+        } else {
+            value = Word(std::uint64_t(x) % p);
+        }
+    }
+
+    // residue from value that is already reduced (no check is performed)
+    static Mod from_reduced(Word x) {
+        Mod result;
+        result.value = x;
+        return result;
+    }
+
+    // residue of a double width value
+    static Mod reduce(Wide x) {
+        return from_reduced(Word(x % p));
+    }
+
+    Mod &operator+=(const Mod &other) {
+        // sum is calculated in 64 bits, p may be close to 2^32
+        std::uint64_t sum = std::uint64_t(value) + other.value;
+        value = Word(sum >= p ? sum - p : sum);
+        return *this;
+    }
+
+    Mod &operator-=(const Mod &other) {
+        value = value >= other.value ? value - other.value : Word(value + (p - other.value));
+        return *this;
+    }
+
+    Mod &operator*=(const Mod &other) {
+        value = Word(Wide(value) * other.value % p);
+        return *this;
+    }
+
+    Mod &operator/=(const Mod &other) {
+        return *this *= other.inverse();
+    }
+
+    Mod operator-() const {
+        return from_reduced(value == 0 ? 0 : Word(p - value));
+    }
+
+    // this^exponent, by repeated squaring
+    Mod pow(std::uint64_t exponent) const {
+        Mod result = 1, base = *this;
+        while (exponent > 0) {
+            if (exponent & 1) {
+                result *= base;
+            }
+            base *= base;
+            exponent >>= 1;
+        }
+        return result;
+    }
+
+    // multiplicative inverse by Fermat's little theorem (p has to be prime and value nonzero)
+    Mod inverse() const {
+        return pow(p - 2);
+    }
+
+    bool operator==(const Mod &other) const {
+        return value == other.value;
+    }
+
+    bool operator!=(const Mod &other) const {
+        return value != other.value;
+    }
+};
+
+template<std::uint64_t p>
+constexpr std::uint64_t Mod<p>::modulus;
+
+template<std::uint64_t p>
+Mod<p> operator+(Mod<p> a, const Mod<p> &b) {
+    return a += b;
+}
+
+template<std::uint64_t p>
+Mod<p> operator-(Mod<p> a, const Mod<p> &b) {
+    return a -= b;
+}
+
+template<std::uint64_t p>
+Mod<p> operator*(Mod<p> a, const Mod<p> &b) {
+    return a *= b;
+}
+
+template<std::uint64_t p>
+Mod<p> operator/(Mod<p> a, const Mod<p> &b) {
+    return a /= b;
+}
+
+template<std::uint64_t p>
+std::ostream &operator<<(std::ostream &os, const Mod<p> &a) {
+    return os << std::uint64_t(a.value);
+}
+
+// number of products of two residues that can be added to a residue without overflowing Wide
+template<std::uint64_t p>
+unsigned int modular_delayed_terms() {
+    typedef typename Mod<p>::Wide Wide;
+    const Wide largest = Wide(p - 1) * (p - 1);
+    // numeric_limits is not specialized for 128-bit integers in strict standard mode
+    const Wide terms = (~Wide(0) - (p - 1)) / largest;
+    return static_cast<unsigned int>(std::min<Wide>(terms, std::numeric_limits<unsigned int>::max()));
+}
+
+// C += A B over Z/pZ with delayed reduction, all matrices are row-major with given row strides
+template<std::uint64_t p>
+void modular_kernel_delayed(unsigned int rows, unsigned int cols, unsigned int inner,
+                            const Mod<p> *A, unsigned int lda, const Mod<p> *B, unsigned int ldb,
+                            Mod<p> *C, unsigned int ldc) {
+    typedef typename Mod<p>::Wide Wide;
+    const unsigned int delayed_terms = modular_delayed_terms<p>();
+    std::vector<Wide> sums(std::min(classic_block_cols, cols));
+
+    for (unsigned int k0 = 0; k0 < inner; k0 += classic_block_inner) {
+        unsigned int block_inner = std::min(classic_block_inner, inner - k0);
+
+        for (unsigned int j0 = 0; j0 < cols; j0 += classic_block_cols) {
+            unsigned int block_cols = std::min(classic_block_cols, cols - j0);
+
+            for (unsigned int i = 0; i < rows; ++i) {
+                std::fill(sums.begin(), sums.begin() + block_cols, Wide(0));
+                unsigned int terms = 0;
+
+                for (unsigned int k = k0; k < k0 + block_inner; ++k) {
+                    // sums would overflow with next product, reduce them
+                    if (terms == delayed_terms) {
+                        for (unsigned int j = 0; j < block_cols; ++j) {
+                            sums[j] %= p;
+                        }
+                        terms = 0;
+                    }
+
+                    const Wide Aik = A[i * lda + k].value;
+                    const Mod<p> *iter_B = B + k * ldb + j0;
+                    for (unsigned int j = 0; j < block_cols; ++j) {
+                        sums[j] += Aik * iter_B[j].value;
+                    }
+                    terms++;
+                }
+
+                Mod<p> *iter_C = C + i * ldc + j0;
+                for (unsigned int j = 0; j < block_cols; ++j) {
+                    iter_C[j] += Mod<p>::reduce(sums[j]);
+                }
+            }
+        }
+    }
+}
+
+#ifdef __AVX2__
+
+// columns of B processed at once by AVX2 kernel (four registers of 64-bit lanes)
+const unsigned int modular_panel_cols = 16;
+
+// -p^(-1) mod 2^32 for odd p, by Newton iteration (every step doubles the number of correct bits)
+constexpr std::uint32_t montgomery_negative_inverse(std::uint32_t p) {
+    std::uint32_t inverse = p;
+    for (int i = 0; i < 4; ++i) {
+        inverse *= 2 - p * inverse;
+    }
+    return 0u - inverse;
+}
+
+// T R^(-1) mod p for every 64-bit lane, where R = 2^32 and T < p R (Montgomery reduction)
+inline __m256i montgomery_reduce(__m256i T, __m256i modulus, __m256i negative_inverse) {
+    // m = T (-p^(-1)) mod R, then T + m p is divisible by R and smaller than 2 p R
+    __m256i m = _mm256_mul_epu32(T, negative_inverse);
+    __m256i t = _mm256_srli_epi64(_mm256_add_epi64(T, _mm256_mul_epu32(m, modulus)), 32);
+    // t < 2 p, subtract p once if needed
+    __m256i too_large = _mm256_cmpgt_epi64(t, _mm256_sub_epi64(modulus, _mm256_set1_epi64x(1)));
+    return _mm256_sub_epi64(t, _mm256_and_si256(too_large, modulus));
+}
+
+// a + b mod p for every 64-bit lane, both a and b are smaller than p
+inline __m256i modular_add(__m256i a, __m256i b, __m256i modulus) {
+    __m256i sum = _mm256_add_epi64(a, b);
+    __m256i too_large = _mm256_cmpgt_epi64(sum, _mm256_sub_epi64(modulus, _mm256_set1_epi64x(1)));
+    return _mm256_sub_epi64(sum, _mm256_and_si256(too_large, modulus));
+}
+
+// C += A B over Z/pZ for odd p < 2^31
+// B is packed in panels of modular_panel_cols columns and multiplied by R = 2^32 (Montgomery form).
+// Products a (b R) are summed in 64-bit lanes with _mm256_mul_epu32, as long as the sum stays below p R,
+// then Montgomery reduction of the sum gives (sum a b) mod p directly, which is added to reduced accumulator.
+template<std::uint64_t p>
+void modular_kernel_avx2(unsigned int rows, unsigned int cols, unsigned int inner,
+                         const Mod<p> *A, unsigned int lda, const Mod<p> *B, unsigned int ldb,
+                         Mod<p> *C, unsigned int ldc) {
+    const std::uint64_t largest = (p - 1) * (p - 1);
+    const unsigned int delayed_terms = static_cast<unsigned int>(
+            std::min<std::uint64_t>(((p << 32) - 1) / largest, classic_block_inner));
+    const unsigned int panels = (cols + modular_panel_cols - 1) / modular_panel_cols;
+
+    const __m256i modulus = _mm256_set1_epi64x(static_cast<long long>(p));
+    const __m256i negative_inverse = _mm256_set1_epi64x(montgomery_negative_inverse(std::uint32_t(p)));
+    std::vector<std::uint32_t> packed;
+
+    for (unsigned int k0 = 0; k0 < inner; k0 += classic_block_inner) {
+        unsigned int block_inner = std::min(classic_block_inner, inner - k0);
+
+        // pack rows k0 ... k0 + block_inner of B in Montgomery form, missing columns are zeros
+        packed.assign(std::size_t(panels) * block_inner * modular_panel_cols, 0);
+        for (unsigned int k = 0; k < block_inner; ++k) {
+            const Mod<p> *row_B = B + (k0 + k) * ldb;
+            for (unsigned int j = 0; j < cols; ++j) {
+                unsigned int panel = j / modular_panel_cols;
+                packed[(std::size_t(panel) * block_inner + k) * modular_panel_cols + j % modular_panel_cols] =
+                        std::uint32_t((std::uint64_t(row_B[j].value) << 32) % p);
+            }
+        }
+
+        for (unsigned int panel = 0; panel < panels; ++panel) {
+            const std::uint32_t *panel_B = packed.data() + std::size_t(panel) * block_inner * modular_panel_cols;
+            unsigned int panel_cols = std::min(modular_panel_cols, cols - panel * modular_panel_cols);
+
+            for (unsigned int i = 0; i < rows; ++i) {
+                const Mod<p> *row_A = A + i * lda + k0;
+                __m256i result[4] = {_mm256_setzero_si256(), _mm256_setzero_si256(),
+                                     _mm256_setzero_si256(), _mm256_setzero_si256()};
+
+                for (unsigned int c0 = 0; c0 < block_inner; c0 += delayed_terms) {
+                    unsigned int c_end = std::min(block_inner, c0 + delayed_terms);
+                    __m256i sums[4] = {_mm256_setzero_si256(), _mm256_setzero_si256(),
+                                       _mm256_setzero_si256(), _mm256_setzero_si256()};
+
+                    for (unsigned int k = c0; k < c_end; ++k) {
+                        __m256i a = _mm256_set1_epi64x(row_A[k].value);
+                        const std::uint32_t *row_B = panel_B + k * modular_panel_cols;
+                        for (unsigned int v = 0; v < 4; ++v) {
+                            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row_B + 4 * v));
+                            sums[v] = _mm256_add_epi64(sums[v], _mm256_mul_epu32(a, _mm256_cvtepu32_epi64(b)));
+                        }
+                    }
+
+                    for (unsigned int v = 0; v < 4; ++v) {
+                        result[v] = modular_add(result[v], montgomery_reduce(sums[v], modulus, negative_inverse),
+                                                modulus);
+                    }
+                }
+
+                std::uint64_t reduced[modular_panel_cols];
+                for (unsigned int v = 0; v < 4; ++v) {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(reduced + 4 * v), result[v]);
+                }
+                Mod<p> *row_C = C + i * ldc + panel * modular_panel_cols;
+                for (unsigned int j = 0; j < panel_cols; ++j) {
+                    row_C[j] += Mod<p>::from_reduced(typename Mod<p>::Word(reduced[j]));
+                }
+            }
+        }
+    }
+}
+
+#endif
+
+// classic kernel for matrices over Z/pZ, found by argument dependent lookup from multiply_classic()
+// and therefore used by all algorithms (also as the base case of Strassen and Laderman)
+template<std::uint64_t p>
+void classic_kernel(unsigned int rows, unsigned int cols, unsigned int inner,
+                    const Mod<p> *A, unsigned int lda, Op op_A,
+                    const Mod<p> *B, unsigned int ldb, Op op_B,
+                    Mod<p> *C, unsigned int ldc) {
+    // transposed operands are packed once, modular kernels read row-major operands
+    std::vector<Mod<p>> packed_A, packed_B;
+    if (op_A == Op::transpose) {
+        packed_A.resize(std::size_t(rows) * inner);
+        transpose_blocked(A, lda, inner, rows, packed_A.data(), inner);
+        A = packed_A.data();
+        lda = inner;
+    }
+    if (op_B == Op::transpose) {
+        packed_B.resize(std::size_t(inner) * cols);
+        transpose_blocked(B, ldb, cols, inner, packed_B.data(), cols);
+        B = packed_B.data();
+        ldb = cols;
+    }
+
+#ifdef __AVX2__
+    if (p % 2 == 1 && p < (std::uint64_t(1) << 31)) {
+        modular_kernel_avx2(rows, cols, inner, A, lda, B, ldb, C, ldc);
+        return;
+    }
+#endif
+    modular_kernel_delayed(rows, cols, inner, A, lda, B, ldb, C, ldc);
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_MODULAR_HPP
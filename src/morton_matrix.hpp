@@ -0,0 +1,268 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_MORTON_MATRIX_HPP
+#define FAST_MATRIX_MULTIPLICATION_MORTON_MATRIX_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+#include "algorithm.hpp"
+#include "matrix.hpp"
+#include "multiply_classic.hpp"
+#include "multiply_laderman.hpp"
+#include "multiply_strassen.hpp"
+#include "scheme.hpp"
+
+// Recursive block layout (Morton / Z-order for split 2) for recursive algorithms.
+//
+// Matrix is split into split x split blocks, every block again into split x split blocks, and so on
+// for `levels` levels. Blocks are stored one after another, row by row, and the same holds inside
+// every block, down to leaf tiles, which are stored row-major. So every block at every level of recursion
+// is one contiguous range of memory: blocks of a scheme with <split, split, split> blocks (Strassen for 2,
+// Laderman for 3) need no copies, and sums of blocks are plain loops over contiguous arrays.
+//
+// Tiles have ceil(rows / split^levels) rows and ceil(cols / split^levels) columns, entries outside
+// the matrix are zeros (less than split^levels rows and columns of padding).
+
+template<class Scalar>
+class MortonMatrix {
+public:
+    // number of rows and columns of the matrix (without padding)
+    unsigned int rows, cols;
+    // every level splits blocks into split x split blocks
+    unsigned int split;
+    // number of levels of blocks above tiles
+    unsigned int levels;
+    // dimensions of leaf tiles
+    unsigned int tile_rows, tile_cols;
+
+    // tiles in recursive order, every tile is row-major
+    std::vector<Scalar> data;
+
+    // zero matrix in recursive layout
+    MortonMatrix(unsigned int _rows, unsigned int _cols, unsigned int _split, unsigned int _levels)
+            : rows(_rows), cols(_cols), split(_split), levels(_levels) {
+        assert(split >= 2);
+        const unsigned int tiles = tiles_per_side();
+        tile_rows = (rows + tiles - 1) / tiles;
+        tile_cols = (cols + tiles - 1) / tiles;
+        data.assign(std::size_t(tiles) * tiles * tile_size(), Scalar(0));
+    }
+
+    // copy of row-major matrix, rows of tiles are copied at once
+    static MortonMatrix from_matrix(const Matrix<Scalar> &A, unsigned int split, unsigned int levels) {
+        MortonMatrix morton(A.rows, A.cols, split, levels);
+        morton.for_each_tile([&](unsigned int i, unsigned int j, unsigned int height, unsigned int width,
+                                 std::size_t offset) {
+            Scalar *tile = morton.data.data() + offset;
+            for (unsigned int r = 0; r < height; ++r) {
+                const Scalar *source = A.data.data() + std::size_t(i + r) * A.cols + j;
+                std::copy(source, source + width, tile + std::size_t(r) * morton.tile_cols);
+            }
+        });
+        return morton;
+    }
+
+    // row-major copy (padding is left out)
+    Matrix<Scalar> to_matrix() const {
+        Matrix<Scalar> A = Matrix<Scalar>::zeros(rows, cols);
+        for_each_tile([&](unsigned int i, unsigned int j, unsigned int height, unsigned int width,
+                          std::size_t offset) {
+            for (unsigned int r = 0; r < height; ++r) {
+                const Scalar *source = data.data() + offset + std::size_t(r) * tile_cols;
+                std::copy(source, source + width, A.data.begin() + std::size_t(i + r) * cols + j);
+            }
+        });
+        return A;
+    }
+
+    // number of tiles in every row and column (split^levels)
+    unsigned int tiles_per_side() const {
+        unsigned int tiles = 1;
+        for (unsigned int l = 0; l < levels; ++l) {
+            tiles *= split;
+        }
+        return tiles;
+    }
+
+    // number of elements of one tile
+    std::size_t tile_size() const {
+        return std::size_t(tile_rows) * tile_cols;
+    }
+
+    // position of tile (ti, tj) among all tiles: digits of ti and tj in base split are interleaved,
+    // the top level is the most significant digit
+    std::size_t tile_index(unsigned int ti, unsigned int tj) const {
+        std::size_t index = 0, weight = 1;
+        for (unsigned int l = 0; l < levels; ++l) {
+            index += (ti % split * split + tj % split) * weight;
+            weight *= split * split;
+            ti /= split;
+            tj /= split;
+        }
+        return index;
+    }
+
+private:
+    // calls function(first row, first column, rows and columns inside matrix, offset of tile in data)
+    // for every tile that is not only padding
+    template<class Function>
+    void for_each_tile(Function function) const {
+        if (tile_rows == 0 || tile_cols == 0) {
+            return;
+        }
+        for (unsigned int ti = 0; ti * tile_rows < rows; ++ti) {
+            for (unsigned int tj = 0; tj * tile_cols < cols; ++tj) {
+                unsigned int i = ti * tile_rows, j = tj * tile_cols;
+                function(i, j, std::min(tile_rows, rows - i), std::min(tile_cols, cols - j),
+                         tile_index(ti, tj) * tile_size());
+            }
+        }
+    }
+};
+
+// number of levels for product rows x inner x cols with <split, split, split> scheme,
+// recursion stops at the same size as in-memory algorithms
+inline unsigned int morton_levels(unsigned int rows, unsigned int inner, unsigned int cols, unsigned int split,
+                                  unsigned int threshold) {
+    unsigned int levels = 0;
+    unsigned int min_size = std::min(rows, std::min(inner, cols));
+    while (min_size > threshold) {
+        levels++;
+        min_size /= split;
+    }
+    return levels;
+}
+
+// sum of coefficients[i] * (i-th of consecutive blocks of `size` elements), a single block with
+// coefficient 1 is used in place, otherwise the sum is written to `sum`
+template<class Scalar>
+const Scalar *morton_combination(const std::vector<int> &coefficients, const Scalar *blocks, std::size_t size,
+                                 std::vector<Scalar> &sum) {
+    unsigned int used = 0, last = 0;
+    for (unsigned int i = 0; i < coefficients.size(); ++i) {
+        if (coefficients[i] != 0) {
+            used++;
+            last = i;
+        }
+    }
+    if (used == 1 && coefficients[last] == 1) {
+        return blocks + last * size;
+    }
+
+    sum.assign(size, Scalar(0));
+    for (unsigned int i = 0; i < coefficients.size(); ++i) {
+        const Scalar *block = blocks + i * size;
+        if (coefficients[i] == 1) {
+            for (std::size_t e = 0; e < size; ++e) {
+                sum[e] += block[e];
+            }
+        } else if (coefficients[i] == -1) {
+            for (std::size_t e = 0; e < size; ++e) {
+                sum[e] -= block[e];
+            }
+        } else if (coefficients[i] != 0) {
+            const Scalar coefficient = Scalar(coefficients[i]);
+            for (std::size_t e = 0; e < size; ++e) {
+                sum[e] += coefficient * block[e];
+            }
+        }
+    }
+    return sum.data();
+}
+
+// C += A B for blocks in recursive layout with `level` levels of blocks above tiles,
+// tiles of A are tile_rows x tile_inner and tiles of B are tile_inner x tile_cols
+template<class Scalar>
+void morton_multiply_blocks(const Scheme &scheme, const Scalar *A, const Scalar *B, Scalar *C, unsigned int level,
+                            unsigned int tile_rows, unsigned int tile_inner, unsigned int tile_cols) {
+    if (level == 0) {
+        classic_kernel(tile_rows, tile_cols, tile_inner, A, tile_inner, Op::none, B, tile_cols, Op::none,
+                       C, tile_cols);
+        return;
+    }
+
+    // number of tiles in one block of next level
+    std::size_t tiles = 1;
+    for (unsigned int l = 1; l < level; ++l) {
+        tiles *= scheme.n * scheme.n;
+    }
+    const std::size_t A_size = tiles * tile_rows * tile_inner, B_size = tiles * tile_inner * tile_cols,
+            C_size = tiles * tile_rows * tile_cols;
+
+    std::vector<Scalar> left_sum, right_sum, P;
+    for (const SchemeProduct &product : scheme.products) {
+        const Scalar *left = morton_combination(product.a, A, A_size, left_sum);
+        const Scalar *right = morton_combination(product.b, B, B_size, right_sum);
+
+        // product that is only added to one block is accumulated there directly
+        unsigned int used = 0, last = 0;
+        for (unsigned int l = 0; l < product.c.size(); ++l) {
+            if (product.c[l] != 0) {
+                used++;
+                last = l;
+            }
+        }
+        if (used == 1 && product.c[last] == 1) {
+            morton_multiply_blocks(scheme, left, right, C + last * C_size, level - 1, tile_rows, tile_inner,
+                                   tile_cols);
+            continue;
+        }
+
+        P.assign(C_size, Scalar(0));
+        morton_multiply_blocks(scheme, left, right, P.data(), level - 1, tile_rows, tile_inner, tile_cols);
+        for (unsigned int l = 0; l < product.c.size(); ++l) {
+            Scalar *block = C + l * C_size;
+            if (product.c[l] == 1) {
+                for (std::size_t e = 0; e < C_size; ++e) {
+                    block[e] += P[e];
+                }
+            } else if (product.c[l] == -1) {
+                for (std::size_t e = 0; e < C_size; ++e) {
+                    block[e] -= P[e];
+                }
+            } else if (product.c[l] != 0) {
+                const Scalar coefficient = Scalar(product.c[l]);
+                for (std::size_t e = 0; e < C_size; ++e) {
+                    block[e] += coefficient * P[e];
+                }
+            }
+        }
+    }
+}
+
+// product A B of matrices in recursive layout with given <split, split, split> scheme,
+// both matrices need the same split and levels
+template<class Scalar>
+MortonMatrix<Scalar> multiply_morton(const MortonMatrix<Scalar> &A, const MortonMatrix<Scalar> &B,
+                                     const Scheme &scheme) {
+    // check dimensions and layouts
+    assert(A.cols == B.rows && A.split == B.split && A.levels == B.levels && A.tile_cols == B.tile_rows);
+    assert(scheme.m == A.split && scheme.k == A.split && scheme.n == A.split);
+
+    MortonMatrix<Scalar> C(A.rows, B.cols, A.split, A.levels);
+    morton_multiply_blocks(scheme, A.data.data(), B.data.data(), C.data.data(), A.levels,
+                           A.tile_rows, A.tile_cols, B.tile_cols);
+    return C;
+}
+
+// product A B of row-major matrices: operands are converted to recursive layout,
+// multiplied with chosen algorithm and the product is converted back
+template<class Scalar>
+Matrix<Scalar> multiply_morton(const Matrix<Scalar> &A, const Matrix<Scalar> &B,
+                               Algorithm algorithm = Algorithm::strassen) {
+    // check dimensions
+    assert(A.cols == B.rows);
+
+    const Scheme *scheme = algorithm_scheme(algorithm);
+    if (scheme == nullptr) {
+        return multiply_classic(A, B);
+    }
+
+    const unsigned int split = scheme->n;
+    const unsigned int threshold = algorithm == Algorithm::laderman ? laderman_threshold : strassen_threshold;
+    const unsigned int levels = morton_levels(A.rows, A.cols, B.cols, split, threshold);
+
+    return multiply_morton(MortonMatrix<Scalar>::from_matrix(A, split, levels),
+                           MortonMatrix<Scalar>::from_matrix(B, split, levels), *scheme).to_matrix();
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_MORTON_MATRIX_HPP
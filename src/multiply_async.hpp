@@ -0,0 +1,220 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_MULTIPLY_ASYNC_HPP
+#define FAST_MATRIX_MULTIPLICATION_MULTIPLY_ASYNC_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "algorithm.hpp"
+#include "dynamic_peeling.hpp"
+#include "executor.hpp"
+#include "matrix.hpp"
+#include "multiply_classic.hpp"
+#include "scheme.hpp"
+
+// Asynchronous products: multiply_async() submits a product to an Executor and returns immediately,
+// the product is delivered through a future or passed to a callback.
+//
+// Every product is one job of the executor, split into tasks so that concurrent products share workers
+// fairly: products of fast algorithms are split into products of the top level of recursion (each is then
+// multiplied with the chosen algorithm), the task that finishes last adds them together and peels remaining
+// rows and columns; classic products are split into bands of rows of C. Products too small for one level
+// of recursion are a single task. Operands are moved into the job, so caller does not need to keep them.
+
+// classic products are split into bands of about this many multiplications
+const double async_band_work = double(1 << 24);
+
+// called with the product, or with an empty matrix and the exception thrown while calculating it
+template<class Scalar>
+using MultiplyCallback = std::function<void(Matrix<Scalar>, std::exception_ptr)>;
+
+// state of one asynchronous product shared by its tasks
+template<class Scalar>
+struct AsyncProduct {
+    Matrix<Scalar> A, B, C;
+    Algorithm algorithm;
+    const Scheme *scheme = nullptr;
+    // blocks of operands and products of top level of recursion
+    std::vector<Matrix<Scalar>> A_blocks, B_blocks, products;
+    // tasks that have not finished yet
+    std::atomic<unsigned int> remaining;
+    // first exception thrown by a task
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    MultiplyCallback<Scalar> done;
+
+    void fail() {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error) {
+            error = std::current_exception();
+        }
+    }
+
+    // called at the end of every task, the last task finishes the product and calls the callback
+    void finish_task() {
+        if (--remaining > 0) {
+            return;
+        }
+        if (!error && scheme != nullptr) {
+            try {
+                combine();
+            } catch (...) {
+                fail();
+            }
+        }
+        A_blocks.clear();
+        B_blocks.clear();
+        products.clear();
+        if (error) {
+            done(Matrix<Scalar>(), error);
+        } else {
+            done(std::move(C), nullptr);
+        }
+    }
+
+    // C = sum of products of top level and peeled rows and columns
+    void combine() {
+        const unsigned int block_rows = A.rows / scheme->m, block_cols = B.cols / scheme->n;
+        Matrix<Scalar> C_blocks = Matrix<Scalar>::zeros(scheme->m * block_rows, scheme->n * block_cols);
+        for (unsigned int r = 0; r < scheme->rank(); ++r) {
+            scheme_accumulate(scheme->products[r].c, products[r], C_blocks, block_rows, block_cols, scheme->n);
+        }
+        C = Matrix<Scalar>::zeros(A.rows, B.cols);
+        C.block_add({0, 0}, C_blocks);
+        dynamic_peeling(A, B, C, scheme->m, scheme->k, scheme->n);
+    }
+};
+
+// tasks of a product of a fast algorithm: r-th task multiplies r-th product of top level of recursion
+template<class Scalar>
+std::vector<Executor::Task> async_scheme_tasks(const std::shared_ptr<AsyncProduct<Scalar>> &state) {
+    const Scheme &scheme = *state->scheme;
+    const unsigned int block_rows = state->A.rows / scheme.m, block_inner = state->A.cols / scheme.k,
+            block_cols = state->B.cols / scheme.n;
+    for (unsigned int i = 0; i < scheme.m; ++i) {
+        for (unsigned int j = 0; j < scheme.k; ++j) {
+            state->A_blocks.push_back(state->A.subblock({i * block_rows, j * block_inner}, {block_rows, block_inner}));
+        }
+    }
+    for (unsigned int i = 0; i < scheme.k; ++i) {
+        for (unsigned int j = 0; j < scheme.n; ++j) {
+            state->B_blocks.push_back(state->B.subblock({i * block_inner, j * block_cols}, {block_inner, block_cols}));
+        }
+    }
+    state->products.resize(scheme.rank());
+    state->remaining = scheme.rank();
+
+    std::vector<Executor::Task> tasks;
+    for (unsigned int r = 0; r < scheme.rank(); ++r) {
+        tasks.push_back([state, r]() {
+            try {
+                const SchemeProduct &product = state->scheme->products[r];
+                state->products[r] = multiply(scheme_combination(product.a, state->A_blocks),
+                                              scheme_combination(product.b, state->B_blocks), state->algorithm);
+            } catch (...) {
+                state->fail();
+            }
+            state->finish_task();
+        });
+    }
+    return tasks;
+}
+
+// tasks of a classic product (or of a product too small for recursion): bands of rows of C
+template<class Scalar>
+std::vector<Executor::Task> async_band_tasks(const std::shared_ptr<AsyncProduct<Scalar>> &state) {
+    const unsigned int rows = state->A.rows, inner = state->A.cols, cols = state->B.cols;
+    state->C = Matrix<Scalar>::zeros(rows, cols);
+
+    // fast algorithms multiply small products at once, classic products are split into bands
+    unsigned int band = rows;
+    if (state->algorithm == Algorithm::classic) {
+        double row_work = std::max(1.0, double(inner) * cols);
+        band = std::max(1u, static_cast<unsigned int>(std::min<double>(rows, async_band_work / row_work)));
+    }
+    const unsigned int count = rows == 0 ? 1 : (rows + band - 1) / band;
+    state->remaining = count;
+
+    std::vector<Executor::Task> tasks;
+    for (unsigned int t = 0; t < count; ++t) {
+        tasks.push_back([state, t, band]() {
+            try {
+                const unsigned int first = t * band, height = std::min(band, state->A.rows - first);
+                if (state->algorithm == Algorithm::classic) {
+                    classic_kernel(height, state->B.cols, state->A.cols,
+                                   state->A.data.data() + std::size_t(first) * state->A.cols, state->A.cols,
+                                   Op::none, state->B.data.data(), state->B.cols, Op::none,
+                                   state->C.data.data() + std::size_t(first) * state->C.cols, state->C.cols);
+                } else {
+                    state->C = multiply(state->A, state->B, state->algorithm);
+                }
+            } catch (...) {
+                state->fail();
+            }
+            state->finish_task();
+        });
+    }
+    return tasks;
+}
+
+// tasks of product A B with chosen algorithm, done(product, nullptr) is called when product is finished
+template<class Scalar>
+std::vector<Executor::Task> async_multiply_tasks(Matrix<Scalar> A, Matrix<Scalar> B, Algorithm algorithm,
+                                                 MultiplyCallback<Scalar> done) {
+    // check dimensions
+    assert(A.cols == B.rows);
+
+    std::shared_ptr<AsyncProduct<Scalar>> state = std::make_shared<AsyncProduct<Scalar>>();
+    state->A = std::move(A);
+    state->B = std::move(B);
+    state->algorithm = algorithm;
+    state->done = std::move(done);
+
+    // top level of recursion is split only where the algorithm itself would recurse
+    const unsigned int rows = state->A.rows, inner = state->A.cols, cols = state->B.cols;
+    const unsigned int threshold = algorithm == Algorithm::laderman ? laderman_threshold : strassen_threshold;
+    if (std::min(rows, std::min(inner, cols)) > threshold) {
+        state->scheme = algorithm_scheme(algorithm, rows, inner, cols);
+    }
+    return state->scheme != nullptr ? async_scheme_tasks(state) : async_band_tasks(state);
+}
+
+// submits product A B to executor (waits while its queue is full), done(product, error) is called
+// on a worker thread when product is finished; error is nullptr on success, done must not throw
+template<class Scalar>
+void multiply_async(Executor &executor, Matrix<Scalar> A, Matrix<Scalar> B, Algorithm algorithm,
+                    MultiplyCallback<Scalar> done) {
+    executor.submit(async_multiply_tasks(std::move(A), std::move(B), algorithm, std::move(done)));
+}
+
+// submits product A B to executor (waits while its queue is full) and returns future of the product
+template<class Scalar>
+std::future<Matrix<Scalar>> multiply_async(Executor &executor, Matrix<Scalar> A, Matrix<Scalar> B,
+                                           Algorithm algorithm = Algorithm::strassen) {
+    std::shared_ptr<std::promise<Matrix<Scalar>>> promise = std::make_shared<std::promise<Matrix<Scalar>>>();
+    std::future<Matrix<Scalar>> future = promise->get_future();
+    multiply_async<Scalar>(executor, std::move(A), std::move(B), algorithm,
+                           [promise](Matrix<Scalar> C, std::exception_ptr error) {
+                               if (error) {
+                                   promise->set_exception(error);
+                               } else {
+                                   promise->set_value(std::move(C));
+                               }
+                           });
+    return future;
+}
+
+// same as above, with the shared executor
+template<class Scalar>
+std::future<Matrix<Scalar>> multiply_async(Matrix<Scalar> A, Matrix<Scalar> B,
+                                           Algorithm algorithm = Algorithm::strassen) {
+    return multiply_async(Executor::shared(), std::move(A), std::move(B), algorithm);
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_MULTIPLY_ASYNC_HPP
@@ -10,36 +10,45 @@ const unsigned int bini_threshold = 200;
 
 // Exact multiplication, problem is that multiplication of polynomials is not O(1) anymore.
 template<typename Scalar>
-Matrix<Scalar> multiply_bini_exact(const Matrix<Scalar> &A, const Matrix<Scalar> &B) {
+Matrix<Scalar> multiply_bini_exact(const Matrix<Scalar> &A, const Matrix<Scalar> &B,
+                                   Op op_A = Op::none, Op op_B = Op::none) {
     // convert to polynomials
     Matrix<Polynomial<Scalar>> poly_A(A);
     Matrix<Polynomial<Scalar>> poly_B(B);
 
-    Matrix<Polynomial<Scalar>> poly_C = multiply_bini(poly_A, poly_B, Polynomial<Scalar>::epsilon());
+    Matrix<Polynomial<Scalar>> poly_C = multiply_bini(poly_A, poly_B, Polynomial<Scalar>::epsilon(), op_A, op_B);
 
     // convert back from polynomials
     return polynomial_to_scalar(poly_C);
 }
 
-// actual Bini's algorithm
+// actual Bini's algorithm, calculates op(A) op(B)
+// transposed operands are transposed while subblocks are copied, so they cost no extra pass
 template<typename Poly>
-Matrix<Poly> multiply_bini(const Matrix<Poly> &A, const Matrix<Poly> &B, const Poly &epsilon) {
+Matrix<Poly> multiply_bini(const Matrix<Poly> &A, const Matrix<Poly> &B, const Poly &epsilon,
+                           Op op_A = Op::none, Op op_B = Op::none) {
+    // dimensions of op(A) and op(B)
+    unsigned int rows_A = op_rows(A, op_A),
+            cols_A = op_cols(A, op_A),
+            rows_B = op_rows(B, op_B),
+            cols_B = op_cols(B, op_B);
+
     // check dimensions
-    assert(A.cols == B.rows);
+    assert(cols_A == rows_B);
 
     // if matrices are too small for Bini's algorithm we have nothing to do but multiply it classicaly
-    if (A.rows < 2 || A.cols < 2 || B.cols < 3) {
-        return multiply_classic(A, B);
-    } else if (A.rows <= bini_threshold || A.cols <= bini_threshold || B.cols <= bini_threshold) {
-        return multiply_classic(A, B);
+    if (rows_A < 2 || cols_A < 2 || cols_B < 3) {
+        return multiply_classic(A, B, op_A, op_B);
+    } else if (rows_A <= bini_threshold || cols_A <= bini_threshold || cols_B <= bini_threshold) {
+        return multiply_classic(A, B, op_A, op_B);
     }
 
     // create subblocks
     // last line and up to 2 last columns may not be included, this is handled by dynamic peeling
-    unsigned int block_rows_A = A.rows / 2,
-            block_cols_A = A.cols / 2,
-            block_rows_B = B.rows / 2,
-            block_cols_B = B.cols / 3;
+    unsigned int block_rows_A = rows_A / 2,
+            block_cols_A = cols_A / 2,
+            block_rows_B = rows_B / 2,
+            block_cols_B = cols_B / 3;
 
     std::pair<unsigned int, unsigned int>
             block_A = {block_rows_A, block_cols_A},
@@ -47,22 +56,22 @@ Matrix<Poly> multiply_bini(const Matrix<Poly> &A, const Matrix<Poly> &B, const P
 
     // | A11 A12 | | B11 B12 B13 |
     // | A21 A22 | | B21 B22 B23 |
-    Matrix<Poly> A11 = A.subblock({0, 0}, block_A),
-            A12 = A.subblock({0, block_cols_A}, block_A),
-            A21 = A.subblock({block_rows_A, 0}, block_A),
-            A22 = A.subblock({block_rows_A, block_cols_A}, block_A);
-
-    Matrix<Poly> B11 = B.subblock({0, 0}, block_B),
-            B12 = B.subblock({0, block_cols_B}, block_B),
-            B13 = B.subblock({0, 2 * block_cols_B}, block_B),
-            B21 = B.subblock({block_rows_B, 0}, block_B),
-            B22 = B.subblock({block_rows_B, block_cols_B}, block_B),
-            B23 = B.subblock({block_rows_B, 2 * block_cols_B}, block_B);
+    Matrix<Poly> A11 = A.subblock({0, 0}, block_A, op_A),
+            A12 = A.subblock({0, block_cols_A}, block_A, op_A),
+            A21 = A.subblock({block_rows_A, 0}, block_A, op_A),
+            A22 = A.subblock({block_rows_A, block_cols_A}, block_A, op_A);
+
+    Matrix<Poly> B11 = B.subblock({0, 0}, block_B, op_B),
+            B12 = B.subblock({0, block_cols_B}, block_B, op_B),
+            B13 = B.subblock({0, 2 * block_cols_B}, block_B, op_B),
+            B21 = B.subblock({block_rows_B, 0}, block_B, op_B),
+            B22 = B.subblock({block_rows_B, block_cols_B}, block_B, op_B),
+            B23 = B.subblock({block_rows_B, 2 * block_cols_B}, block_B, op_B);
 
     // create new empty matrix for product
     // | C11 C12 C13 |
     // | C21 C22 C23 |
-    Matrix<Poly> C = Matrix<Poly>::zeros(A.rows, B.cols);
+    Matrix<Poly> C = Matrix<Poly>::zeros(rows_A, cols_B);
 
     // dimensions of a block in a product
     unsigned int block_rows_C = block_rows_A, block_cols_C = block_cols_B;
@@ -106,51 +115,43 @@ Matrix<Poly> multiply_bini(const Matrix<Poly> &A, const Matrix<Poly> &B, const P
     // | ... C13 |
     // | C22 C23 |
     // how to get to formulas for P1, ... P5: transpose upper matrix and rename indices.
+    // Products below are products of transposed blocks, for example P1 = (B13^T + e B12^T) A21^T.
+    // Sums of blocks are the same transposed or not, so blocks are never transposed, transposition flags
+    // are passed to the recursive call instead. Each product P is then added to C as P^T.
 
-    // transpose all blocks (we won't need B11 and B21, we do not need to transpose them).
-    A11 = A11.transposed();
-    A12 = A12.transposed();
-    A21 = A21.transposed();
-    A22 = A22.transposed();
-    B12 = B12.transposed();
-    B22 = B22.transposed();
-    B13 = B13.transposed();
-    B23 = B23.transposed();
-
-    // P1 = (B13 + e B12) A21
-    // After multiplying, transposed back
-    P = multiply_bini(B13 + epsilon * B12, A21, epsilon).transposed();
+    // P1 = (B13 + e B12)^T A21^T
+    P = multiply_bini(B13 + epsilon * B12, A21, epsilon, Op::transpose, Op::transpose);
     // Add e P1 to C23 and P1 to C22
-    C.block_add({block_rows_C, 2 * block_cols_C}, epsilon * P);
-    C.block_add({block_rows_C, block_cols_C}, P);
+    C.block_add({block_rows_C, 2 * block_cols_C}, epsilon * P, Op::transpose);
+    C.block_add({block_rows_C, block_cols_C}, P, Op::transpose);
 
-    // P2 = B23 (A22 + e A12)
-    P = multiply_bini(B23, A22 + epsilon * A12, epsilon).transposed();
+    // P2 = B23^T (A22 + e A12)^T
+    P = multiply_bini(B23, A22 + epsilon * A12, epsilon, Op::transpose, Op::transpose);
     // Add e P2 to C23 and P2 to C13
-    C.block_add({block_rows_C, 2 * block_cols_C}, epsilon * P);
-    C.block_add({0, 2 * block_cols_C}, P);
+    C.block_add({block_rows_C, 2 * block_cols_C}, epsilon * P, Op::transpose);
+    C.block_add({0, 2 * block_cols_C}, P, Op::transpose);
 
-    // P3 = B13 (A22 + A21 + e A11)
-    P = multiply_bini(B13, A22 + A21 + epsilon * A11, epsilon).transposed();
+    // P3 = B13^T (A22 + A21 + e A11)^T
+    P = multiply_bini(B13, A22 + A21 + epsilon * A11, epsilon, Op::transpose, Op::transpose);
     // Subtract P3 from C22
-    C.block_subtract({block_rows_C, block_cols_C}, P);
+    C.block_subtract({block_rows_C, block_cols_C}, P, Op::transpose);
 
-    // P4 = (B23 + B13 + e B22) A22
-    P = multiply_bini(B23 + B13 + epsilon * B22, A22, epsilon).transposed();
+    // P4 = (B23 + B13 + e B22)^T A22^T
+    P = multiply_bini(B23 + B13 + epsilon * B22, A22, epsilon, Op::transpose, Op::transpose);
     // Subtract P4 from C13
-    C.block_subtract({0, 2 * block_cols_C}, P);
+    C.block_subtract({0, 2 * block_cols_C}, P, Op::transpose);
 
-    // P5 = (B13 + e B22) (A22 + e A11)
-    P = multiply_bini(B13 + epsilon * B22, A22 + epsilon * A11, epsilon).transposed();
+    // P5 = (B13 + e B22)^T (A22 + e A11)^T
+    P = multiply_bini(B13 + epsilon * B22, A22 + epsilon * A11, epsilon, Op::transpose, Op::transpose);
     // Add P5 to C13 and C22
-    C.block_add({0, 2 * block_cols_C}, P);
-    C.block_add({block_rows_C, block_cols_C}, P);
+    C.block_add({0, 2 * block_cols_C}, P, Op::transpose);
+    C.block_add({block_rows_C, block_cols_C}, P, Op::transpose);
 
     // using bini's algorithm now we got epsilon * C, now we have to divide by epsilon.
     C /= epsilon;
 
     // dynamic peeling for not included rows and cols
-    dynamic_peeling(A, B, C, 2, 2, 3);
+    dynamic_peeling(A, B, C, 2, 2, 3, op_A, op_B);
 
     return C;
 }
@@ -0,0 +1,243 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_MULTIPLY_CHAIN_HPP
+#define FAST_MATRIX_MULTIPLICATION_MULTIPLY_CHAIN_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "algorithm.hpp"
+#include "matrix.hpp"
+#include "multiply_classic.hpp"
+#include "scheme.hpp"
+#include "thread_pool.hpp"
+
+// Products of chains of matrices M_0 M_1 ... M_(n - 1) of different shapes. The order of products is chosen
+// by dynamic programming over all parenthesizations, with costs of products as the library calculates them:
+// a classic product costs rows * inner * cols multiply-adds, a product of a fast algorithm costs its
+// recursive products plus additions of blocks, copies of blocks and dynamic peeling of every level.
+//
+// Intermediate products are freed as soon as they are used, and their memory is reused for later classic
+// products. Sub-chains that do not depend on each other are multiplied in parallel on the thread pool.
+
+// additions of blocks read and write whole matrices, while classic kernel keeps its operands in cache,
+// so one addition of elements costs about as much as this many multiply-adds
+const double chain_addition_cost = 2.0;
+
+// sub-chains with at least this cost are multiplied as separate tasks
+const double chain_parallel_threshold = double(1 << 24);
+
+// cost of product rows x inner x cols with chosen algorithm (in multiply-adds of classic kernel)
+inline double chain_product_cost(Algorithm algorithm, unsigned int rows, unsigned int inner, unsigned int cols) {
+    const Scheme *scheme = algorithm_recursion_scheme(algorithm, rows, inner, cols);
+    if (scheme == nullptr) {
+        return double(rows) * inner * cols;
+    }
+
+    const unsigned int block_rows = rows / scheme->m, block_inner = inner / scheme->k, block_cols = cols / scheme->n;
+    const double included_rows = double(block_rows) * scheme->m, included_inner = double(block_inner) * scheme->k,
+            included_cols = double(block_cols) * scheme->n;
+
+    // all products of a scheme have blocks of the same size
+    double cost = scheme->rank() * chain_product_cost(algorithm, block_rows, block_inner, block_cols);
+
+    // combinations of blocks of A and B, and products added to blocks of C
+    double additions = 0;
+    for (const SchemeProduct &product : scheme->products) {
+        for (int a : product.a) {
+            additions += a != 0 ? double(block_rows) * block_inner : 0;
+        }
+        for (int b : product.b) {
+            additions += b != 0 ? double(block_inner) * block_cols : 0;
+        }
+        for (int c : product.c) {
+            additions += c != 0 ? double(block_rows) * block_cols : 0;
+        }
+    }
+    // copies of blocks of operands and of the product
+    additions += included_rows * included_inner + included_inner * included_cols + 2 * double(rows) * cols;
+    cost += chain_addition_cost * additions;
+
+    // dynamic peeling
+    cost += (double(rows) * cols - included_rows * included_cols) * inner +
+            included_rows * included_cols * (inner - included_inner);
+    return cost;
+}
+
+// order of products of a chain: product of matrices first ... last is split into products
+// first ... split(first, last) and split(first, last) + 1 ... last
+struct ChainOrder {
+    // number of matrices
+    unsigned int count;
+    // split points, row major count x count table (only first < last is used)
+    std::vector<unsigned int> splits;
+    // total cost of all products
+    double cost;
+
+    unsigned int split(unsigned int first, unsigned int last) const {
+        return splits[first * count + last];
+    }
+};
+
+// cheapest order of products of chain with M_i of size dimensions[i] x dimensions[i + 1]
+inline ChainOrder chain_order(const std::vector<unsigned int> &dimensions, Algorithm algorithm = Algorithm::strassen) {
+    assert(dimensions.size() >= 2);
+
+    const unsigned int count = dimensions.size() - 1;
+    std::vector<double> costs(count * count, 0);
+    ChainOrder order = {count, std::vector<unsigned int>(count * count, 0), 0};
+
+    // sub-chains by increasing length
+    for (unsigned int length = 2; length <= count; ++length) {
+        for (unsigned int first = 0; first + length <= count; ++first) {
+            const unsigned int last = first + length - 1;
+            double best = std::numeric_limits<double>::infinity();
+            for (unsigned int split = first; split < last; ++split) {
+                double cost = costs[first * count + split] + costs[(split + 1) * count + last] +
+                              chain_product_cost(algorithm, dimensions[first], dimensions[split + 1],
+                                                 dimensions[last + 1]);
+                if (cost < best) {
+                    best = cost;
+                    order.splits[first * count + last] = split;
+                }
+            }
+            costs[first * count + last] = best;
+        }
+    }
+    order.cost = costs[count - 1];
+    return order;
+}
+
+// evaluation of a chain in given order, shared by tasks of sub-chains
+template<class Scalar>
+class ChainEvaluation {
+public:
+    ChainEvaluation(const std::vector<const Matrix<Scalar> *> &_matrices, const ChainOrder &_order,
+                    Algorithm _algorithm) : matrices(_matrices), order(_order), algorithm(_algorithm) {
+        // cost of every sub-chain, to decide which of them run as separate tasks
+        const unsigned int count = matrices.size();
+        costs.assign(count * count, 0);
+        for (unsigned int length = 2; length <= count; ++length) {
+            for (unsigned int first = 0; first + length <= count; ++first) {
+                const unsigned int last = first + length - 1, split = order.split(first, last);
+                costs[first * count + last] = costs[first * count + split] + costs[(split + 1) * count + last] +
+                                              chain_product_cost(algorithm, matrices[first]->rows,
+                                                                 matrices[split]->cols, matrices[last]->cols);
+            }
+        }
+    }
+
+    // product of matrices first ... last (first < last)
+    Matrix<Scalar> evaluate(unsigned int first, unsigned int last) {
+        const unsigned int split = order.split(first, last);
+        Matrix<Scalar> left, right;
+
+        // sub-chains of single matrices are used directly, two sub-chains that both need real work
+        // are multiplied at the same time
+        TaskGroup group;
+        const bool parallel = group.thread_pool().threads() > 1 && first < split && split + 1 < last &&
+                              cost(first, split) >= chain_parallel_threshold &&
+                              cost(split + 1, last) >= chain_parallel_threshold;
+        if (parallel) {
+            group.run([this, &left, first, split]() {
+                left = evaluate(first, split);
+            });
+        } else if (first < split) {
+            left = evaluate(first, split);
+        }
+        if (split + 1 < last) {
+            right = evaluate(split + 1, last);
+        }
+        group.wait();
+
+        Matrix<Scalar> C = product(first < split ? left : *matrices[first], split + 1 < last ? right : *matrices[last]);
+        release(std::move(left));
+        release(std::move(right));
+        return C;
+    }
+
+private:
+    const std::vector<const Matrix<Scalar> *> &matrices;
+    const ChainOrder &order;
+    Algorithm algorithm;
+    std::vector<double> costs;
+
+    // memory of freed intermediate products
+    std::mutex buffers_mutex;
+    std::vector<std::vector<Scalar>> buffers;
+
+    double cost(unsigned int first, unsigned int last) const {
+        return costs[first * matrices.size() + last];
+    }
+
+    void release(Matrix<Scalar> &&M) {
+        if (M.data.capacity() > 0) {
+            std::lock_guard<std::mutex> lock(buffers_mutex);
+            buffers.push_back(std::move(M.data));
+        }
+    }
+
+    // zero matrix rows x cols, in memory of a freed product if some is large enough
+    Matrix<Scalar> zeros(unsigned int rows, unsigned int cols) {
+        const std::size_t size = std::size_t(rows) * cols;
+        Matrix<Scalar> M;
+        {
+            std::lock_guard<std::mutex> lock(buffers_mutex);
+            for (std::size_t i = 0; i < buffers.size(); ++i) {
+                if (buffers[i].capacity() >= size) {
+                    M.data = std::move(buffers[i]);
+                    buffers.erase(buffers.begin() + i);
+                    break;
+                }
+            }
+        }
+        M.data.assign(size, Scalar(0));
+        M.rows = rows;
+        M.cols = cols;
+        return M;
+    }
+
+    Matrix<Scalar> product(const Matrix<Scalar> &A, const Matrix<Scalar> &B) {
+        if (algorithm_recursion_scheme(algorithm, A.rows, A.cols, B.cols) != nullptr) {
+            return multiply(A, B, algorithm);
+        }
+        Matrix<Scalar> C = zeros(A.rows, B.cols);
+        classic_kernel_parallel(C.rows, C.cols, A.cols, A.data.data(), A.cols, Op::none, B.data.data(), B.cols,
+                                Op::none, C.data.data(), C.cols);
+        return C;
+    }
+};
+
+// product of chain of matrices, products are done in the cheapest order for chosen algorithm
+template<class Scalar>
+Matrix<Scalar> multiply_chain(const std::vector<const Matrix<Scalar> *> &matrices,
+                              Algorithm algorithm = Algorithm::strassen) {
+    assert(!matrices.empty());
+
+    // check dimensions
+    std::vector<unsigned int> dimensions = {matrices[0]->rows};
+    for (unsigned int i = 0; i < matrices.size(); ++i) {
+        assert(i == 0 || matrices[i - 1]->cols == matrices[i]->rows);
+        dimensions.push_back(matrices[i]->cols);
+    }
+
+    if (matrices.size() == 1) {
+        return *matrices[0];
+    }
+    ChainOrder order = chain_order(dimensions, algorithm);
+    ChainEvaluation<Scalar> evaluation(matrices, order, algorithm);
+    return evaluation.evaluate(0, matrices.size() - 1);
+}
+
+// same as above, for a list of matrices
+template<class Scalar>
+Matrix<Scalar> multiply_chain(const std::vector<Matrix<Scalar>> &matrices, Algorithm algorithm = Algorithm::strassen) {
+    std::vector<const Matrix<Scalar> *> pointers;
+    for (const Matrix<Scalar> &M : matrices) {
+        pointers.push_back(&M);
+    }
+    return multiply_chain(pointers, algorithm);
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_MULTIPLY_CHAIN_HPP
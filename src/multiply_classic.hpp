@@ -1,31 +1,248 @@
 #ifndef FAST_MATRIX_MULTIPLICATION_MULTIPLY_CLASSIC_HPP
 #define FAST_MATRIX_MULTIPLICATION_MULTIPLY_CLASSIC_HPP
 
+#include <algorithm>
 #include <cassert>
 #include <vector>
+#include "block_kernel.hpp"
 #include "matrix.hpp"
+#include "semiring.hpp"
+#include "thread_pool.hpp"
+#include "transpose.hpp"
 
+// classic kernel works on blocks of op(B) with this many rows and columns,
+// transposed operands are packed one block at a time, so packing buffers stay small
+const unsigned int classic_block_inner = 128;
+const unsigned int classic_block_cols = 512;
+
+// C += op(A) op(B), where op(A) is rows x inner and op(B) is inner x cols
+// (sum and products are those of given semiring, ordinary arithmetic by default)
+// all matrices are given as pointers to row-major data and their row strides.
+// Operands that are not transposed are read in place, transposed operands are first packed
+// (with blocked transpose) into row-major buffers, so inner loop always reads contiguous memory.
+template<class Scalar, class Semiring = PlusTimes<Scalar>>
+void classic_kernel(unsigned int rows, unsigned int cols, unsigned int inner,
+                    const Scalar *A, unsigned int lda, Op op_A,
+                    const Scalar *B, unsigned int ldb, Op op_B,
+                    Scalar *C, unsigned int ldc, const Semiring &semiring = Semiring()) {
+    std::vector<Scalar> packed_A, packed_B;
+
+    for (unsigned int k0 = 0; k0 < inner; k0 += classic_block_inner) {
+        unsigned int block_inner = std::min(classic_block_inner, inner - k0);
+
+        // columns k0 ... k0 + block_inner of op(A)
+        const Scalar *block_A = A + k0;
+        unsigned int block_lda = lda;
+        if (op_A == Op::transpose) {
+            // op(A)[i][k] = A[k][i], rows k0 ... k0 + block_inner of A are transposed into buffer
+            packed_A.resize(rows * block_inner);
+            transpose_blocked(A + k0 * lda, lda, block_inner, rows, packed_A.data(), block_inner);
+            block_A = packed_A.data();
+            block_lda = block_inner;
+        }
+
+        for (unsigned int j0 = 0; j0 < cols; j0 += classic_block_cols) {
+            unsigned int block_cols = std::min(classic_block_cols, cols - j0);
+
+            // rows k0 ... k0 + block_inner and columns j0 ... j0 + block_cols of op(B)
+            const Scalar *block_B = B + k0 * ldb + j0;
+            unsigned int block_ldb = ldb;
+            if (op_B == Op::transpose) {
+                // op(B)[k][j] = B[j][k]
+                packed_B.resize(block_inner * block_cols);
+                transpose_blocked(B + j0 * ldb + k0, ldb, block_cols, block_inner, packed_B.data(), block_cols);
+                block_B = packed_B.data();
+                block_ldb = block_cols;
+            }
+
+            classic_block_kernel(rows, block_cols, block_inner, block_A, block_lda, block_B, block_ldb,
+                                 C + j0, ldc, semiring);
+        }
+    }
+}
+
+// products with fewer multiplications than this are not split between threads
+const double classic_parallel_threshold = double(1 << 21);
+
+// parallel kernel aims at this many tiles of C per thread, so threads that finish early can take more
+const unsigned int classic_parallel_tiles = 4;
+
+// tiles of C are at least this many rows high and columns wide (whole SIMD tiles)
+const unsigned int classic_tile_rows = 16;
+const unsigned int classic_tile_cols = 64;
+
+// rounds value up to a multiple of step
+inline unsigned int classic_round_up(unsigned int value, unsigned int step) {
+    return (value + step - 1) / step * step;
+}
+
+// rows per task when a product rows x inner times inner x cols is split only by rows between threads of pool
+// (all rows, if the product is too small to be split)
+inline unsigned int classic_parallel_rows(unsigned int rows, unsigned int cols, unsigned int inner,
+                                          ThreadPool &pool = default_thread_pool()) {
+    const unsigned int tasks = pool.threads() * classic_parallel_tiles;
+    if (pool.threads() == 1 || double(rows) * cols * inner < classic_parallel_threshold) {
+        return std::max(1u, rows);
+    }
+    return std::max(classic_tile_rows, classic_round_up((rows + tasks - 1) / tasks, classic_simd_rows));
+}
+
+// kernel for one tile of the parallel kernel, ordinary products call classic_kernel() without a semiring,
+// so kernels for special scalars found by argument dependent lookup (modular.hpp) are used also here
 template<class Scalar>
-Matrix<Scalar> multiply_classic(const Matrix<Scalar> &A, const Matrix<Scalar> &B) {
-    // check dimensions
-    assert(A.cols == B.rows);
+void classic_tile_kernel(unsigned int rows, unsigned int cols, unsigned int inner,
+                         const Scalar *A, unsigned int lda, Op op_A, const Scalar *B, unsigned int ldb, Op op_B,
+                         Scalar *C, unsigned int ldc, const PlusTimes<Scalar> &) {
+    classic_kernel(rows, cols, inner, A, lda, op_A, B, ldb, op_B, C, ldc);
+}
 
-    // create new matrix
-    Matrix<Scalar> C = Matrix<Scalar>::zeros(A.rows, B.cols);
-
-    for (unsigned int i = 0; i < A.rows; ++i) {
-        for (unsigned int k = 0; k < A.cols; ++k) {
-            // calculate c_ij
-            auto Aik = A[{i, k}];
-            // this will be Bkj, but using iterators improves multiplication speed by a factor of 2
-            auto iter_B = B.data.begin() + k * B.cols;
-            // this will be Cij
-            auto iter_C = C.data.begin() + i * C.cols;
-            for (unsigned int j = 0; j < B.cols; ++j) {
-                *(iter_C + j) += Aik * (*(iter_B + j));
+template<class Scalar, class Semiring>
+void classic_tile_kernel(unsigned int rows, unsigned int cols, unsigned int inner,
+                         const Scalar *A, unsigned int lda, Op op_A, const Scalar *B, unsigned int ldb, Op op_B,
+                         Scalar *C, unsigned int ldc, const Semiring &semiring) {
+    classic_kernel(rows, cols, inner, A, lda, op_A, B, ldb, op_B, C, ldc, semiring);
+}
+
+// same as classic_kernel(), with work split between threads of the pool.
+// C is split into 2D tiles (ranges of rows and columns), and when there are fewer tiles than threads
+// (C is small and the inner dimension is long), the inner dimension is split into slices too: products
+// of later slices are summed into separate buffers that are added to C at the end.
+// Every column tile of op(B) is packed once into a contiguous panel shared by all tasks of these columns,
+// transposed op(A) is packed by every task for its own rows (inside classic_kernel()).
+// Small products and pools with one thread run classic_kernel() directly.
+template<class Scalar, class Semiring = PlusTimes<Scalar>>
+void classic_kernel_parallel(unsigned int rows, unsigned int cols, unsigned int inner,
+                             const Scalar *A, unsigned int lda, Op op_A,
+                             const Scalar *B, unsigned int ldb, Op op_B,
+                             Scalar *C, unsigned int ldc, const Semiring &semiring = Semiring(),
+                             ThreadPool &pool = default_thread_pool()) {
+    const unsigned int threads = pool.threads();
+    if (threads == 1 || double(rows) * cols * inner < classic_parallel_threshold) {
+        classic_tile_kernel(rows, cols, inner, A, lda, op_A, B, ldb, op_B, C, ldc, semiring);
+        return;
+    }
+
+    // columns: tiles of at most classic_block_cols, narrower while there are too few tiles for all threads
+    const unsigned int target = threads * classic_parallel_tiles;
+    const unsigned int max_row_tiles = (rows + classic_tile_rows - 1) / classic_tile_rows;
+    unsigned int tile_cols = std::min(classic_block_cols, classic_round_up(cols, classic_tile_cols));
+    while (tile_cols > classic_tile_cols && max_row_tiles * ((cols + tile_cols - 1) / tile_cols) < target) {
+        tile_cols = classic_round_up(tile_cols / 2, classic_tile_cols);
+    }
+    const unsigned int col_tiles = (cols + tile_cols - 1) / tile_cols;
+
+    // rows: as many tiles as needed for the target (but not lower than classic_tile_rows)
+    const unsigned int wanted_row_tiles = std::max(1u, std::min(max_row_tiles, (target + col_tiles - 1) / col_tiles));
+    const unsigned int tile_rows = classic_round_up((rows + wanted_row_tiles - 1) / wanted_row_tiles,
+                                                    classic_simd_rows);
+    const unsigned int row_tiles = (rows + tile_rows - 1) / tile_rows, tiles = row_tiles * col_tiles;
+
+    // inner dimension: slices of whole blocks, only when tiles of C can not keep all threads busy
+    unsigned int slices = 1;
+    if (tiles < threads) {
+        const unsigned int blocks = (inner + classic_block_inner - 1) / classic_block_inner;
+        slices = std::max(1u, std::min(blocks, (threads + tiles - 1) / tiles));
+    }
+    const unsigned int slice_inner = classic_round_up((inner + slices - 1) / slices, classic_block_inner);
+    slices = (inner + slice_inner - 1) / slice_inner;
+
+    // column tiles of op(B), each of them inner x width and row-major
+    // (op(B) that fits in a single tile is read in place)
+    const bool pack_B = op_B == Op::transpose || col_tiles > 1;
+    std::vector<std::vector<Scalar>> panels(pack_B ? col_tiles : 0);
+    parallel_for(0, pack_B ? col_tiles : 0, 1, [&](unsigned int first, unsigned int last) {
+        for (unsigned int t = first; t < last; ++t) {
+            const unsigned int j0 = t * tile_cols, width = std::min(tile_cols, cols - j0);
+            panels[t].resize(std::size_t(inner) * width);
+            if (op_B == Op::transpose) {
+                // op(B)[k][j] = B[j][k]
+                transpose_blocked(B + std::size_t(j0) * ldb, ldb, width, inner, panels[t].data(), width);
+            } else {
+                for (unsigned int k = 0; k < inner; ++k) {
+                    const Scalar *row = B + std::size_t(k) * ldb + j0;
+                    std::copy(row, row + width, panels[t].data() + std::size_t(k) * width);
+                }
             }
         }
+    }, pool);
+
+    // products of slices after the first one
+    std::vector<std::vector<Scalar>> partial(slices - 1,
+                                             std::vector<Scalar>(std::size_t(rows) * cols, semiring.zero()));
+
+    parallel_for(0, tiles * slices, 1, [&](unsigned int first, unsigned int last) {
+        for (unsigned int task = first; task < last; ++task) {
+            const unsigned int slice = task / tiles, tile = task % tiles;
+            const unsigned int i0 = tile / col_tiles * tile_rows, j0 = tile % col_tiles * tile_cols;
+            const unsigned int height = std::min(tile_rows, rows - i0), width = std::min(tile_cols, cols - j0);
+            const unsigned int k0 = slice * slice_inner, slice_size = std::min(slice_inner, inner - k0);
+
+            // rows i0 ... i0 + height and columns k0 ... k0 + slice_size of op(A)
+            const Scalar *block_A = op_A == Op::transpose ? A + std::size_t(k0) * lda + i0
+                                                          : A + std::size_t(i0) * lda + k0;
+            // rows k0 ... k0 + slice_size of the column tile of op(B)
+            const Scalar *block_B = pack_B ? panels[j0 / tile_cols].data() + std::size_t(k0) * width
+                                           : B + std::size_t(k0) * ldb;
+            const unsigned int block_ldb = pack_B ? width : ldb;
+
+            if (slice == 0) {
+                classic_tile_kernel(height, width, slice_size, block_A, lda, op_A, block_B, block_ldb, Op::none,
+                                    C + std::size_t(i0) * ldc + j0, ldc, semiring);
+            } else {
+                classic_tile_kernel(height, width, slice_size, block_A, lda, op_A, block_B, block_ldb, Op::none,
+                                    partial[slice - 1].data() + std::size_t(i0) * cols + j0, cols, semiring);
+            }
+        }
+    }, pool);
+
+    // slices are added to C
+    if (slices > 1) {
+        parallel_for(0, rows, classic_tile_rows, [&](unsigned int first, unsigned int last) {
+            for (unsigned int i = first; i < last; ++i) {
+                Scalar *row_C = C + std::size_t(i) * ldc;
+                for (const std::vector<Scalar> &sums : partial) {
+                    const Scalar *row = sums.data() + std::size_t(i) * cols;
+                    for (unsigned int j = 0; j < cols; ++j) {
+                        row_C[j] = semiring.add(row_C[j], row[j]);
+                    }
+                }
+            }
+        }, pool);
     }
+}
+
+// product op(A) op(B), transposition flags are handled inside the kernel,
+// so there is no need to call transposed() before multiplication (work is split between threads of pool)
+template<class Scalar>
+Matrix<Scalar> multiply_classic(const Matrix<Scalar> &A, const Matrix<Scalar> &B,
+                                Op op_A = Op::none, Op op_B = Op::none, ThreadPool &pool = default_thread_pool()) {
+    // check dimensions
+    assert(op_cols(A, op_A) == op_rows(B, op_B));
+
+    // create new matrix
+    Matrix<Scalar> C = Matrix<Scalar>::zeros(op_rows(A, op_A), op_cols(B, op_B));
+
+    classic_kernel_parallel(C.rows, C.cols, op_cols(A, op_A),
+                            A.data.data(), A.cols, op_A,
+                            B.data.data(), B.cols, op_B,
+                            C.data.data(), C.cols, PlusTimes<Scalar>(), pool);
+    return C;
+}
+
+// product op(A) op(B) over a semiring, for example multiply_classic(A, B, MinPlus<double>())
+template<class Scalar, class Semiring>
+Matrix<Scalar> multiply_classic(const Matrix<Scalar> &A, const Matrix<Scalar> &B, const Semiring &semiring,
+                                Op op_A = Op::none, Op op_B = Op::none, ThreadPool &pool = default_thread_pool()) {
+    // check dimensions
+    assert(op_cols(A, op_A) == op_rows(B, op_B));
+
+    // empty sums are zeros of the semiring
+    Matrix<Scalar> C(op_rows(A, op_A), op_cols(B, op_B), semiring.zero());
+
+    classic_kernel_parallel(C.rows, C.cols, op_cols(A, op_A),
+                            A.data.data(), A.cols, op_A,
+                            B.data.data(), B.cols, op_B,
+                            C.data.data(), C.cols, semiring, pool);
     return C;
 }
 
@@ -0,0 +1,391 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_MULTIPLY_COROUTINE_HPP
+#define FAST_MATRIX_MULTIPLICATION_MULTIPLY_COROUTINE_HPP
+
+// Coroutine backend for recursive fast algorithms, available only when compiled as C++20
+// (CMake option FAST_MATRIX_MULTIPLICATION_COROUTINES), the C++14 build keeps only the serial algorithms.
+//
+// Every level of recursion is a coroutine: it prepares sums of blocks, co_awaits all its sub-products at
+// once and then adds them to C. Sub-products are scheduled on the work-stealing ThreadPool shared with
+// the rest of the library: a worker runs the newest coroutines of its own deque and steals the oldest
+// ones from other workers when it has nothing to do, so no threads are created during multiplication.
+// Only the top `parallel_levels` levels are coroutines, below them the serial algorithm is called,
+// so at most rank^parallel_levels sub-products (and their operands) are alive at once.
+
+#if __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+
+#define FAST_MATRIX_MULTIPLICATION_HAS_COROUTINES 1
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "algorithm.hpp"
+#include "dynamic_peeling.hpp"
+#include "matrix.hpp"
+#include "scheme.hpp"
+#include "thread_pool.hpp"
+
+// runs coroutines that are ready on workers of a ThreadPool (the default pool unless other one is given)
+class CoroutineScheduler {
+public:
+    CoroutineScheduler() = default;
+
+    explicit CoroutineScheduler(ThreadPool &_pool) : pool(&_pool) {}
+
+    CoroutineScheduler(const CoroutineScheduler &) = delete;
+
+    CoroutineScheduler &operator=(const CoroutineScheduler &) = delete;
+
+    ThreadPool &thread_pool() const {
+        return pool != nullptr ? *pool : default_thread_pool();
+    }
+
+    unsigned int threads() const {
+        return thread_pool().threads();
+    }
+
+    // makes coroutine ready to run: on a worker it goes to the worker's own deque,
+    // from other threads to the shared queue of the pool
+    void schedule(std::coroutine_handle<> coroutine) {
+        thread_pool().submit([coroutine]() {
+            coroutine.resume();
+        });
+    }
+
+    // waits until ready() returns true, running tasks of the pool meanwhile (so a worker that waits
+    // does not block the coroutines it waits for)
+    template<class Ready>
+    void wait(Ready ready) const {
+        ThreadPool &workers = thread_pool();
+        while (!ready()) {
+            if (!workers.run_one()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // scheduler on the default pool, used when none is given
+    static CoroutineScheduler &shared() {
+        static CoroutineScheduler scheduler;
+        return scheduler;
+    }
+
+private:
+    // nullptr for the default pool
+    ThreadPool *pool = nullptr;
+};
+
+// lazily started coroutine with result of type T: it runs when it is co_awaited (on the awaiting thread)
+// and resumes the awaiting coroutine when it is finished
+template<class T>
+class CoroutineTask {
+public:
+    struct promise_type {
+        std::optional<T> value;
+        std::exception_ptr error;
+        std::coroutine_handle<> continuation;
+
+        CoroutineTask get_return_object() {
+            return CoroutineTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept {
+                return false;
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> coroutine) noexcept {
+                std::coroutine_handle<> continuation = coroutine.promise().continuation;
+                return continuation ? continuation : std::noop_coroutine();
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        FinalAwaiter final_suspend() noexcept {
+            return {};
+        }
+
+        void return_value(T result) {
+            value = std::move(result);
+        }
+
+        void unhandled_exception() {
+            error = std::current_exception();
+        }
+    };
+
+    explicit CoroutineTask(std::coroutine_handle<promise_type> _coroutine) : coroutine(_coroutine) {}
+
+    CoroutineTask(CoroutineTask &&other) noexcept : coroutine(std::exchange(other.coroutine, nullptr)) {}
+
+    CoroutineTask &operator=(CoroutineTask &&other) noexcept {
+        std::swap(coroutine, other.coroutine);
+        return *this;
+    }
+
+    ~CoroutineTask() {
+        if (coroutine) {
+            coroutine.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        coroutine.promise().continuation = awaiting;
+        return coroutine;
+    }
+
+    T await_resume() {
+        return result();
+    }
+
+    // awaiting it runs the task and leaves its result in the task (to be taken by result())
+    struct Completion {
+        CoroutineTask &task;
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+            return task.await_suspend(awaiting);
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    Completion completion() {
+        return {*this};
+    }
+
+    // result of finished task (exception of the task is rethrown)
+    T result() {
+        if (coroutine.promise().error) {
+            std::rethrow_exception(coroutine.promise().error);
+        }
+        return std::move(*coroutine.promise().value);
+    }
+
+private:
+    std::coroutine_handle<promise_type> coroutine;
+};
+
+// coroutine that runs one task of coroutine_when_all(), last finished one resumes the awaiting coroutine
+struct CoroutineBranch {
+    struct promise_type {
+        std::atomic<unsigned int> *remaining = nullptr;
+        std::coroutine_handle<> parent;
+
+        CoroutineBranch get_return_object() {
+            return CoroutineBranch{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept {
+                return false;
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> coroutine) noexcept {
+                // frame may be destroyed by the parent as soon as counter is decremented
+                std::coroutine_handle<> parent = coroutine.promise().parent;
+                return --*coroutine.promise().remaining == 0 ? parent : std::noop_coroutine();
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        FinalAwaiter final_suspend() noexcept {
+            return {};
+        }
+
+        void return_void() {}
+
+        // exceptions are stored by the awaited task itself
+        void unhandled_exception() {}
+    };
+
+    std::coroutine_handle<promise_type> coroutine;
+};
+
+template<class T>
+CoroutineBranch coroutine_branch(CoroutineTask<T> &task) {
+    co_await task.completion();
+}
+
+// awaiting it runs all tasks in parallel on the scheduler and returns their results
+template<class T>
+class CoroutineWhenAll {
+public:
+    CoroutineWhenAll(CoroutineScheduler &_scheduler, std::vector<CoroutineTask<T>> _tasks)
+            : scheduler(_scheduler), tasks(std::move(_tasks)) {}
+
+    CoroutineWhenAll(const CoroutineWhenAll &) = delete;
+
+    ~CoroutineWhenAll() {
+        for (CoroutineBranch &branch : branches) {
+            branch.coroutine.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept {
+        return tasks.empty();
+    }
+
+    // one more than number of tasks, so that parent is not resumed before all tasks are scheduled
+    bool await_suspend(std::coroutine_handle<> parent) {
+        remaining = tasks.size() + 1;
+        for (CoroutineTask<T> &task : tasks) {
+            branches.push_back(coroutine_branch(task));
+            branches.back().coroutine.promise().remaining = &remaining;
+            branches.back().coroutine.promise().parent = parent;
+        }
+        for (CoroutineBranch &branch : branches) {
+            scheduler.schedule(branch.coroutine);
+        }
+        return --remaining > 0;
+    }
+
+    std::vector<T> await_resume() {
+        std::vector<T> results;
+        for (CoroutineTask<T> &task : tasks) {
+            results.push_back(task.result());
+        }
+        return results;
+    }
+
+private:
+    CoroutineScheduler &scheduler;
+    std::vector<CoroutineTask<T>> tasks;
+    std::vector<CoroutineBranch> branches;
+    std::atomic<unsigned int> remaining{0};
+};
+
+// results of all tasks, calculated in parallel (co_await coroutine_when_all(scheduler, tasks))
+template<class T>
+CoroutineWhenAll<T> coroutine_when_all(CoroutineScheduler &scheduler, std::vector<CoroutineTask<T>> tasks) {
+    return CoroutineWhenAll<T>(scheduler, std::move(tasks));
+}
+
+// product A B with chosen algorithm, top `parallel_levels` levels of recursion run their sub-products
+// in parallel on the scheduler
+template<class Scalar>
+CoroutineTask<Matrix<Scalar>> coroutine_multiply(CoroutineScheduler &scheduler, Matrix<Scalar> A, Matrix<Scalar> B,
+                                                 Algorithm algorithm, unsigned int parallel_levels) {
+    // check dimensions
+    assert(A.cols == B.rows);
+
+    const unsigned int threshold = algorithm == Algorithm::laderman ? laderman_threshold : strassen_threshold;
+    const Scheme *scheme = nullptr;
+    if (parallel_levels > 0 && std::min(A.rows, std::min(A.cols, B.cols)) > threshold) {
+        scheme = algorithm_scheme(algorithm, A.rows, A.cols, B.cols);
+    }
+    if (scheme == nullptr) {
+        co_return multiply(A, B, algorithm);
+    }
+
+    const unsigned int block_rows = A.rows / scheme->m, block_inner = A.cols / scheme->k,
+            block_cols = B.cols / scheme->n;
+
+    std::vector<Matrix<Scalar>> A_blocks, B_blocks;
+    for (unsigned int i = 0; i < scheme->m; ++i) {
+        for (unsigned int j = 0; j < scheme->k; ++j) {
+            A_blocks.push_back(A.subblock({i * block_rows, j * block_inner}, {block_rows, block_inner}));
+        }
+    }
+    for (unsigned int i = 0; i < scheme->k; ++i) {
+        for (unsigned int j = 0; j < scheme->n; ++j) {
+            B_blocks.push_back(B.subblock({i * block_inner, j * block_cols}, {block_inner, block_cols}));
+        }
+    }
+
+    std::vector<CoroutineTask<Matrix<Scalar>>> tasks;
+    for (const SchemeProduct &product : scheme->products) {
+        tasks.push_back(coroutine_multiply(scheduler, scheme_combination(product.a, A_blocks),
+                                           scheme_combination(product.b, B_blocks), algorithm,
+                                           parallel_levels - 1));
+    }
+    A_blocks.clear();
+    B_blocks.clear();
+    std::vector<Matrix<Scalar>> products = co_await coroutine_when_all(scheduler, std::move(tasks));
+
+    Matrix<Scalar> C_blocks = Matrix<Scalar>::zeros(scheme->m * block_rows, scheme->n * block_cols);
+    for (unsigned int r = 0; r < scheme->rank(); ++r) {
+        scheme_accumulate(scheme->products[r].c, products[r], C_blocks, block_rows, block_cols, scheme->n);
+    }
+    Matrix<Scalar> C = Matrix<Scalar>::zeros(A.rows, B.cols);
+    C.block_add({0, 0}, C_blocks);
+
+    // rows and columns left out by the scheme
+    dynamic_peeling(A, B, C, scheme->m, scheme->k, scheme->n);
+    co_return C;
+}
+
+// coroutine that runs task and passes its result (or exception) to a promise
+template<class T>
+CoroutineBranch coroutine_fulfil(CoroutineTask<T> task, std::promise<T> &result) {
+    try {
+        result.set_value(co_await task);
+    } catch (...) {
+        result.set_exception(std::current_exception());
+    }
+}
+
+// number of parallel levels that give every worker a few sub-products
+inline unsigned int coroutine_parallel_levels(const CoroutineScheduler &scheduler, Algorithm algorithm) {
+    const Scheme *scheme = algorithm_scheme(algorithm);
+    if (scheme == nullptr) {
+        return 0;
+    }
+    unsigned int levels = 1, tasks = scheme->rank();
+    while (tasks < 4 * scheduler.threads() && levels < 4) {
+        levels++;
+        tasks *= scheme->rank();
+    }
+    return levels;
+}
+
+// product A B calculated on the scheduler, calling thread waits for it
+template<class Scalar>
+Matrix<Scalar> multiply_coroutine(const Matrix<Scalar> &A, const Matrix<Scalar> &B,
+                                  Algorithm algorithm = Algorithm::strassen,
+                                  CoroutineScheduler &scheduler = CoroutineScheduler::shared()) {
+    std::promise<Matrix<Scalar>> result;
+    std::future<Matrix<Scalar>> future = result.get_future();
+
+    // coroutine that fulfils the promise is destroyed only after it has finished
+    std::atomic<unsigned int> remaining{1};
+    CoroutineBranch branch = coroutine_fulfil(
+            coroutine_multiply(scheduler, A, B, algorithm, coroutine_parallel_levels(scheduler, algorithm)), result);
+    branch.coroutine.promise().remaining = &remaining;
+    branch.coroutine.promise().parent = std::noop_coroutine();
+    scheduler.schedule(branch.coroutine);
+
+    scheduler.wait([&future, &remaining]() {
+        return remaining == 0 && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    });
+    branch.coroutine.destroy();
+    return future.get();
+}
+
+#endif
+
+#endif //FAST_MATRIX_MULTIPLICATION_MULTIPLY_COROUTINE_HPP
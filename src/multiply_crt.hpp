@@ -0,0 +1,230 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_MULTIPLY_CRT_HPP
+#define FAST_MATRIX_MULTIPLICATION_MULTIPLY_CRT_HPP
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "algorithm.hpp"
+#include "matrix.hpp"
+#include "modular.hpp"
+#include "thread_pool.hpp"
+#include "wide_integer.hpp"
+
+// Exact products of integer matrices whose results do not fit in machine words (multi-modular method).
+//
+// Inputs are reduced modulo several primes p_1, ..., p_k just below 2^31 and k independent products
+// over Z/p_iZ are calculated in parallel (each with a fast algorithm, all operations stay in machine words).
+// Every entry of the product is then reconstructed from its k residues with the Chinese Remainder Theorem
+// (Garner's algorithm). If the product of the primes is larger than twice the largest possible entry,
+// reconstructed value is exact. Number of primes is chosen from magnitudes of inputs, so small entries
+// need only a few products.
+
+// primes used for multi-modular products, all are odd and smaller than 2^31 (vectorized modular kernel)
+constexpr std::uint32_t crt_primes[] = {2147483647, 2147483629, 2147483587, 2147483579,
+                                        2147483563, 2147483549, 2147483543, 2147483497};
+const unsigned int crt_max_primes = sizeof(crt_primes) / sizeof(crt_primes[0]);
+
+// number of bits (without sign) of supported result types
+template<class Result>
+struct CrtResultBits;
+
+template<>
+struct CrtResultBits<std::int64_t> {
+    static const unsigned int value = 63;
+};
+
+template<>
+struct CrtResultBits<wide_int128> {
+    static const unsigned int value = 127;
+};
+
+template<>
+struct CrtResultBits<Int256> {
+    static const unsigned int value = 255;
+};
+
+// absolute value of the largest entry (as unsigned, so that minimal int64 also fits)
+template<class Integer>
+std::uint64_t crt_max_abs(const Matrix<Integer> &A) {
+    std::uint64_t max_abs = 0;
+    for (const Integer &value : A.data) {
+        std::uint64_t magnitude = value < 0 ? std::uint64_t(-(value + 1)) + 1 : std::uint64_t(value);
+        max_abs = std::max(max_abs, magnitude);
+    }
+    return max_abs;
+}
+
+// log2 of the largest possible absolute value of an entry of a product with given inner dimension
+inline double crt_bound_bits(unsigned int inner, std::uint64_t max_a, std::uint64_t max_b) {
+    if (inner == 0 || max_a == 0 || max_b == 0) {
+        return 0;
+    }
+    return std::log2(double(inner)) + std::log2(double(max_a)) + std::log2(double(max_b));
+}
+
+// number of primes whose product is larger than twice the largest possible entry
+// (residues determine values from -M/2 to M/2, where M is the product of primes)
+inline unsigned int crt_prime_count(unsigned int inner, std::uint64_t max_a, std::uint64_t max_b) {
+    // small margin for rounding of logarithms
+    double needed = crt_bound_bits(inner, max_a, max_b) + 1.01;
+    double bits = 0;
+    for (unsigned int count = 1; count <= crt_max_primes; ++count) {
+        bits += std::log2(double(crt_primes[count - 1]));
+        if (bits > needed) {
+            return count;
+        }
+    }
+    throw std::overflow_error("entries of product are too large for multi-modular multiplication");
+}
+
+// residues of product A B modulo index-th prime
+template<unsigned int index, class Integer>
+std::vector<std::uint32_t> crt_residues(const Matrix<Integer> &A, const Matrix<Integer> &B, Algorithm algorithm) {
+    typedef Mod<crt_primes[index]> Residue;
+
+    Matrix<Residue> product = multiply(Matrix<Residue>(A), Matrix<Residue>(B), algorithm);
+
+    std::vector<std::uint32_t> residues(product.data.size());
+    for (std::size_t i = 0; i < residues.size(); ++i) {
+        residues[i] = product.data[i].value;
+    }
+    return residues;
+}
+
+// function that calculates residues modulo index-th prime (moduli are template parameters of Mod)
+template<class Integer>
+std::vector<std::uint32_t> (*crt_residue_function(unsigned int index))(const Matrix<Integer> &,
+                                                                       const Matrix<Integer> &, Algorithm) {
+    switch (index) {
+        case 0:
+            return &crt_residues<0, Integer>;
+        case 1:
+            return &crt_residues<1, Integer>;
+        case 2:
+            return &crt_residues<2, Integer>;
+        case 3:
+            return &crt_residues<3, Integer>;
+        case 4:
+            return &crt_residues<4, Integer>;
+        case 5:
+            return &crt_residues<5, Integer>;
+        case 6:
+            return &crt_residues<6, Integer>;
+        default:
+            return &crt_residues<7, Integer>;
+    }
+}
+
+// Garner's algorithm for the first `count` primes, reconstructs signed integers from their residues
+class CrtReconstruction {
+public:
+    explicit CrtReconstruction(unsigned int _count) : count(_count), inverses(_count * _count) {
+        assert(count >= 1 && count <= crt_max_primes);
+
+        // inverses[j * count + i] = p_j^(-1) mod p_i, for j < i
+        for (unsigned int i = 0; i < count; ++i) {
+            for (unsigned int j = 0; j < i; ++j) {
+                inverses[j * count + i] = power(crt_primes[j] % crt_primes[i], crt_primes[i] - 2, crt_primes[i]);
+            }
+        }
+
+        modulus = Int256(1);
+        for (unsigned int i = 0; i < count; ++i) {
+            modulus.multiply_add(crt_primes[i], 0);
+        }
+    }
+
+    // integer from -M/2 to M/2 with given residues (residues[i * stride] modulo i-th prime)
+    Int256 reconstruct(const std::uint32_t *residues, std::size_t stride) const {
+        // mixed radix digits: x = v_0 + v_1 p_0 + v_2 p_0 p_1 + ...
+        std::uint64_t digits[crt_max_primes];
+        for (unsigned int i = 0; i < count; ++i) {
+            const std::uint64_t p = crt_primes[i];
+            std::uint64_t x = residues[i * stride];
+            for (unsigned int j = 0; j < i; ++j) {
+                x = (x + p - digits[j] % p) % p * inverses[j * count + i] % p;
+            }
+            digits[i] = x;
+        }
+
+        // Horner's scheme from the most significant digit
+        Int256 value(digits[count - 1]);
+        for (int i = int(count) - 2; i >= 0; --i) {
+            value.multiply_add(crt_primes[i], digits[i]);
+        }
+
+        // values larger than M/2 represent negative numbers
+        if (value + value > modulus) {
+            value -= modulus;
+        }
+        return value;
+    }
+
+private:
+    unsigned int count;
+    std::vector<std::uint64_t> inverses;
+    // product of used primes
+    Int256 modulus;
+
+    static std::uint64_t power(std::uint64_t base, std::uint64_t exponent, std::uint64_t p) {
+        std::uint64_t result = 1;
+        while (exponent > 0) {
+            if (exponent & 1) {
+                result = result * base % p;
+            }
+            base = base * base % p;
+            exponent >>= 1;
+        }
+        return result;
+    }
+};
+
+// exact product A B of integer matrices (entries up to 64 bits), result is int64_t, wide_int128 or Int256
+// products modulo primes are calculated in parallel with chosen algorithm,
+// throws std::overflow_error if entries of the product may not fit in Result
+template<class Result = wide_int128, class Integer>
+Matrix<Result> multiply_crt(const Matrix<Integer> &A, const Matrix<Integer> &B,
+                            Algorithm algorithm = Algorithm::strassen) {
+    static_assert(std::is_integral<Integer>::value && sizeof(Integer) <= 8, "inputs have to be machine integers");
+
+    // check dimensions
+    assert(A.cols == B.rows);
+
+    const double bound_bits = crt_bound_bits(A.cols, crt_max_abs(A), crt_max_abs(B));
+    if (bound_bits >= CrtResultBits<Result>::value) {
+        throw std::overflow_error("entries of product may not fit in result type");
+    }
+    const unsigned int count = crt_prime_count(A.cols, crt_max_abs(A), crt_max_abs(B));
+
+    // one independent product per prime, as tasks of the thread pool
+    std::vector<std::vector<std::uint32_t>> products(count);
+    TaskGroup group;
+    for (unsigned int i = 0; i < count; ++i) {
+        group.run([&products, &A, &B, algorithm, i]() {
+            products[i] = crt_residue_function<Integer>(i)(A, B, algorithm);
+        });
+    }
+    group.wait();
+
+    // residues of one entry are next to each other
+    const std::size_t size = std::size_t(A.rows) * B.cols;
+    std::vector<std::uint32_t> residues(size * count);
+    for (unsigned int i = 0; i < count; ++i) {
+        for (std::size_t e = 0; e < size; ++e) {
+            residues[e * count + i] = products[i][e];
+        }
+        products[i].clear();
+    }
+
+    const CrtReconstruction reconstruction(count);
+    Matrix<Result> C = Matrix<Result>::zeros(A.rows, B.cols);
+    for (std::size_t e = 0; e < size; ++e) {
+        C.data[e] = static_cast<Result>(reconstruction.reconstruct(residues.data() + e * count, 1));
+    }
+    return C;
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_MULTIPLY_CRT_HPP
@@ -0,0 +1,256 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_MULTIPLY_DISTRIBUTED_HPP
+#define FAST_MATRIX_MULTIPLICATION_MULTIPLY_DISTRIBUTED_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "communicator.hpp"
+#include "dynamic_peeling.hpp"
+#include "matrix.hpp"
+#include "multiply_strassen.hpp"
+#include "scheme.hpp"
+
+// Strassen's algorithm on several processes, in the style of CAPS (Communication-Avoiding Parallel Strassen,
+// Ballard, Demmel, Holtz, Lipshitz, Schwartz).
+//
+// Processes form a group, its first process (leader) holds the operands. A BFS step splits the group into
+// 7 subgroups: leader sends the two sums of blocks of each Strassen product to the leader of one subgroup,
+// subgroups multiply in parallel (recursively, with the same steps) and send products back, leader adds them
+// to blocks of C and peels odd rows and columns. A DFS step keeps the whole group together and multiplies
+// the 7 sums one after another with all processes, which needs less memory per process. When a group has
+// only one process, the rest is the ordinary multiply_strassen_dynamic().
+//
+// Every BFS level sends 3 blocks (two operands, one product) of a quarter of the size per subgroup,
+// so with P = 7^l processes total volume is O(n^2 (7/4)^l) = O(P n^2 / P^(2 / log2(7))) words, which is
+// the CAPS bandwidth bound summed over all processes. Operands start at rank 0 (and result ends there),
+// so rank 0 additionally sends and receives O(n^2) words. Bytes sent by every process are reported.
+
+struct DistributedOptions {
+    // number of processes (rank 0 is the calling process)
+    unsigned int processes = 7;
+    // number of DFS steps done before BFS steps (each needs about 7/4 less memory per process than BFS)
+    unsigned int dfs_steps = 0;
+};
+
+// communication volume of a distributed product
+struct CommunicationStats {
+    // bytes and messages sent by each process (with headers of messages)
+    std::vector<std::uint64_t> bytes_sent, messages_sent;
+
+    std::uint64_t total_bytes() const {
+        std::uint64_t total = 0;
+        for (std::uint64_t bytes : bytes_sent) {
+            total += bytes;
+        }
+        return total;
+    }
+
+    // bandwidth cost is the largest volume sent by one process
+    std::uint64_t max_bytes() const {
+        return bytes_sent.empty() ? 0 : *std::max_element(bytes_sent.begin(), bytes_sent.end());
+    }
+};
+
+// processes first, ..., first + count - 1, the first one is the leader
+typedef std::pair<unsigned int, unsigned int> DistributedGroup;
+
+// first message byte of tasks and of the message that stops waiting processes
+const char distributed_task = 1;
+const char distributed_stop = 0;
+
+// subgroups of a BFS step: at most 7 groups of (almost) the same size, leader of the group leads subgroup 0
+inline std::vector<DistributedGroup> distributed_subgroups(DistributedGroup group) {
+    const unsigned int count = std::min(7u, group.second);
+    std::vector<DistributedGroup> subgroups;
+    unsigned int first = group.first;
+    for (unsigned int g = 0; g < count; ++g) {
+        unsigned int size = group.second / count + (g < group.second % count ? 1 : 0);
+        subgroups.push_back({first, size});
+        first += size;
+    }
+    return subgroups;
+}
+
+// leaders that receive tasks from leader of given group (at all its levels of BFS steps)
+inline std::vector<unsigned int> distributed_followers(DistributedGroup group) {
+    std::vector<unsigned int> followers;
+    while (group.second > 1) {
+        std::vector<DistributedGroup> subgroups = distributed_subgroups(group);
+        for (unsigned int g = 1; g < subgroups.size(); ++g) {
+            followers.push_back(subgroups[g].first);
+        }
+        group = subgroups[0];
+    }
+    return followers;
+}
+
+// process that sends tasks to given rank, and the group this rank leads
+inline std::pair<unsigned int, DistributedGroup> distributed_parent(unsigned int rank, unsigned int processes) {
+    assert(rank > 0 && rank < processes);
+    DistributedGroup group = {0, processes};
+    while (true) {
+        for (const DistributedGroup &subgroup : distributed_subgroups(group)) {
+            if (rank >= subgroup.first && rank < subgroup.first + subgroup.second) {
+                if (subgroup.first == rank) {
+                    return {group.first, subgroup};
+                }
+                group = subgroup;
+                break;
+            }
+        }
+    }
+}
+
+// product A B calculated by given group, called by its leader
+template<class Scalar>
+Matrix<Scalar> distributed_strassen(Communicator &communicator, DistributedGroup group,
+                                    const Matrix<Scalar> &A, const Matrix<Scalar> &B, unsigned int dfs_steps) {
+    if (group.second == 1 || std::min(A.rows, std::min(A.cols, B.cols)) <= strassen_threshold) {
+        return multiply_strassen_dynamic(A, B);
+    }
+
+    const Scheme &scheme = strassen_scheme();
+    const unsigned int block_rows = A.rows / 2, block_inner = A.cols / 2, block_cols = B.cols / 2;
+
+    std::vector<Matrix<Scalar>> A_blocks, B_blocks;
+    for (unsigned int i = 0; i < 2; ++i) {
+        for (unsigned int j = 0; j < 2; ++j) {
+            A_blocks.push_back(A.subblock({i * block_rows, j * block_inner}, {block_rows, block_inner}));
+            B_blocks.push_back(B.subblock({i * block_inner, j * block_cols}, {block_inner, block_cols}));
+        }
+    }
+
+    Matrix<Scalar> C_blocks = Matrix<Scalar>::zeros(2 * block_rows, 2 * block_cols);
+
+    if (dfs_steps > 0) {
+        // DFS step: whole group multiplies one product after another
+        for (const SchemeProduct &product : scheme.products) {
+            Matrix<Scalar> P = distributed_strassen(communicator, group, scheme_combination(product.a, A_blocks),
+                                                    scheme_combination(product.b, B_blocks), dfs_steps - 1);
+            scheme_accumulate(product.c, P, C_blocks, block_rows, block_cols, scheme.n);
+        }
+    } else {
+        // BFS step: product r is multiplied by subgroup r % (number of subgroups),
+        // every subgroup gets its next task only after it has returned the previous one,
+        // so no process ever waits on a full socket of a process that waits for it
+        std::vector<DistributedGroup> subgroups = distributed_subgroups(group);
+        auto send_task = [&](unsigned int r) {
+            const SchemeProduct &product = scheme.products[r];
+            std::vector<char> message(1, distributed_task);
+            message_put_matrix(message, scheme_combination(product.a, A_blocks));
+            message_put_matrix(message, scheme_combination(product.b, B_blocks));
+            communicator.send(subgroups[r % subgroups.size()].first, message);
+        };
+
+        for (unsigned int g = 1; g < subgroups.size() && g < scheme.rank(); ++g) {
+            send_task(g);
+        }
+        for (unsigned int r = 0; r < scheme.rank(); r += subgroups.size()) {
+            Matrix<Scalar> P = distributed_strassen(communicator, subgroups[0],
+                                                    scheme_combination(scheme.products[r].a, A_blocks),
+                                                    scheme_combination(scheme.products[r].b, B_blocks), 0);
+            scheme_accumulate(scheme.products[r].c, P, C_blocks, block_rows, block_cols, scheme.n);
+        }
+        for (unsigned int g = 1; g < subgroups.size(); ++g) {
+            for (unsigned int r = g; r < scheme.rank(); r += subgroups.size()) {
+                std::vector<char> message = communicator.receive(subgroups[g].first);
+                std::size_t offset = 0;
+                Matrix<Scalar> P = message_get_matrix<Scalar>(message, offset);
+                if (r + subgroups.size() < scheme.rank()) {
+                    send_task(r + subgroups.size());
+                }
+                scheme_accumulate(scheme.products[r].c, P, C_blocks, block_rows, block_cols, scheme.n);
+            }
+        }
+    }
+
+    Matrix<Scalar> C = Matrix<Scalar>::zeros(A.rows, B.cols);
+    C.block_add({0, 0}, C_blocks);
+
+    // rows and columns left out by odd dimensions
+    dynamic_peeling(A, B, C, 2, 2, 2);
+    return C;
+}
+
+// part of distributed product done by every process: rank 0 multiplies A B (operands of other ranks are
+// ignored) and returns the product, other ranks do tasks they receive until rank 0 is done and return
+// an empty matrix. If stats are given, rank 0 collects bytes sent by all processes.
+template<class Scalar>
+Matrix<Scalar> multiply_distributed(Communicator &communicator, const Matrix<Scalar> &A, const Matrix<Scalar> &B,
+                                    unsigned int dfs_steps = 0, CommunicationStats *stats = nullptr) {
+    const unsigned int rank = communicator.rank(), processes = communicator.size();
+    Matrix<Scalar> C;
+
+    DistributedGroup group = {0, processes};
+    if (rank == 0) {
+        // check dimensions
+        assert(A.cols == B.rows);
+        C = distributed_strassen(communicator, group, A, B, dfs_steps);
+    } else {
+        unsigned int parent;
+        std::tie(parent, group) = distributed_parent(rank, processes);
+
+        while (true) {
+            std::vector<char> message = communicator.receive(parent);
+            if (message[0] == distributed_stop) {
+                break;
+            }
+            std::size_t offset = 1;
+            Matrix<Scalar> left = message_get_matrix<Scalar>(message, offset);
+            Matrix<Scalar> right = message_get_matrix<Scalar>(message, offset);
+
+            std::vector<char> result;
+            message_put_matrix(result, distributed_strassen(communicator, group, left, right, 0));
+            communicator.send(parent, result);
+        }
+    }
+
+    // every leader stops processes it sends tasks to
+    for (unsigned int follower : distributed_followers(group)) {
+        communicator.send(follower, std::vector<char>(1, distributed_stop));
+    }
+
+    // counters are sent to rank 0 after all work is done, so they are complete
+    if (stats != nullptr || rank != 0) {
+        std::vector<char> counters;
+        message_put(counters, communicator.bytes_sent);
+        message_put(counters, communicator.messages_sent);
+        if (rank != 0) {
+            communicator.send(0, counters);
+        } else {
+            stats->bytes_sent.assign(1, communicator.bytes_sent);
+            stats->messages_sent.assign(1, communicator.messages_sent);
+            for (unsigned int source = 1; source < processes; ++source) {
+                std::vector<char> message = communicator.receive(source);
+                std::size_t offset = 0;
+                stats->bytes_sent.push_back(message_get<std::uint64_t>(message, offset));
+                stats->messages_sent.push_back(message_get<std::uint64_t>(message, offset));
+            }
+        }
+    }
+    return C;
+}
+
+// product A B with Strassen's algorithm on options.processes local processes connected by Unix sockets,
+// communication volume is stored in stats if they are given
+template<class Scalar>
+Matrix<Scalar> multiply_distributed(const Matrix<Scalar> &A, const Matrix<Scalar> &B,
+                                    const DistributedOptions &options = DistributedOptions(),
+                                    CommunicationStats *stats = nullptr) {
+    // check dimensions
+    assert(A.cols == B.rows);
+
+    Matrix<Scalar> C;
+    run_processes(options.processes, [&](Communicator &communicator) {
+        Matrix<Scalar> product = multiply_distributed(communicator, A, B, options.dfs_steps, stats);
+        if (communicator.rank() == 0) {
+            C = std::move(product);
+        }
+    });
+    return C;
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_MULTIPLY_DISTRIBUTED_HPP
@@ -0,0 +1,254 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_MULTIPLY_FLOAT_HPP
+#define FAST_MATRIX_MULTIPLICATION_MULTIPLY_FLOAT_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include "matrix.hpp"
+#include "multiply_classic.hpp"
+#include "multiply_strassen.hpp"
+#include "scheme.hpp"
+#include "simd.hpp"
+
+// Fast multiplication of single precision matrices.
+//
+// Floats take half the memory (and memory bandwidth) of doubles, but every level of Strassen's recursion
+// makes the worst case error larger. Two modes are available:
+//  - single: everything is calculated in float, base case products use SIMD float kernel,
+//  - mixed: matrices and sums of blocks are stored as floats, but base case products are accumulated
+//    in double and rounded to float only once, which removes the largest term of the error bound.
+// Error bound for chosen recursion depth is reported by float_error_bound(), depth can also be limited,
+// so that the bound stays below given tolerance.
+//
+// Bound is Higham's bound for Strassen's algorithm (Accuracy and Stability of Numerical Algorithms, 23.2):
+//     max |C - fl(C)| <= [12^d (e0 + 5 n0) - 5 n] u max |a_ij| max |b_ij|,
+// where n is the inner dimension, d the depth of recursion, n0 = n / 2^d and u = 2^-24 unit roundoff of float.
+// Base case error e0 is n0^2 for float products and n0 (one rounding of a sum of n0 products) in mixed mode.
+
+enum class Precision {
+    single,
+    mixed
+};
+
+struct FloatOptions {
+    Precision precision = Precision::mixed;
+    // at most this many levels of Strassen's recursion
+    unsigned int max_depth = 32;
+    // if positive, recursion stops before the relative error bound would exceed tolerance
+    double tolerance = 0;
+};
+
+// depth of recursion and error bound of a product
+struct FloatErrorBound {
+    // levels of Strassen's recursion that are used
+    unsigned int depth;
+    // max |C - fl(C)| <= relative * max |a_ij| * max |b_ij|
+    double relative;
+    // relative bound multiplied by the largest entries of A and B
+    double absolute;
+};
+
+// unit roundoff of float
+const double float_unit_roundoff = 1.0 / 16777216;
+
+// coefficient of max |a_ij| max |b_ij| in the error bound, for inner dimension n and given depth
+inline double float_error_coefficient(unsigned int inner, unsigned int depth, Precision precision) {
+    double n = inner, n0 = std::floor(n / std::ldexp(1.0, depth));
+    // mixed mode rounds products of n0 terms accumulated in double once (double rounding errors are included)
+    double base = precision == Precision::single ? n0 * n0 : n0 + n0 * n0 * std::ldexp(1.0, -29);
+    return std::max(0.0, (std::pow(12.0, depth) * (base + 5 * n0) - 5 * n) * float_unit_roundoff);
+}
+
+// number of levels of Strassen's recursion used for rows x inner x cols product
+inline unsigned int float_strassen_depth(unsigned int rows, unsigned int inner, unsigned int cols,
+                                         const FloatOptions &options) {
+    unsigned int depth = 0;
+    unsigned int min_size = std::min(rows, std::min(inner, cols));
+
+    while (min_size > strassen_threshold && depth < options.max_depth) {
+        if (options.tolerance > 0 &&
+            float_error_coefficient(inner, depth + 1, options.precision) > options.tolerance) {
+            break;
+        }
+        depth++;
+        min_size /= 2;
+    }
+    return depth;
+}
+
+// depth of recursion that multiply_float() uses for A B and its error bound
+inline FloatErrorBound float_error_bound(const Matrix<float> &A, const Matrix<float> &B,
+                                         const FloatOptions &options = FloatOptions()) {
+    float max_A = 0, max_B = 0;
+    for (float a : A.data) {
+        max_A = std::max(max_A, std::abs(a));
+    }
+    for (float b : B.data) {
+        max_B = std::max(max_B, std::abs(b));
+    }
+
+    FloatErrorBound bound;
+    bound.depth = float_strassen_depth(A.rows, A.cols, B.cols, options);
+    bound.relative = float_error_coefficient(A.cols, bound.depth, options.precision);
+    bound.absolute = bound.relative * max_A * max_B;
+    return bound;
+}
+
+// mixed kernel depends on instruction sets it is compiled for (see simd.hpp)
+inline namespace FAST_MATRIX_MULTIPLICATION_ISA_NAMESPACE {
+
+#ifdef FAST_MATRIX_MULTIPLICATION_SIMD
+
+// C += A B for `rows` rows of A and 2 * width columns, A and B are floats, sums C are doubles
+template<unsigned int rows>
+void mixed_simd_tile(unsigned int inner, const float *A, unsigned int lda, const float *B, unsigned int ldb,
+                     double *C, unsigned int ldc) {
+    typedef Simd<double>::Vector Vector;
+    const unsigned int width = Simd<double>::width;
+
+    Vector sums[rows][2];
+    for (unsigned int r = 0; r < rows; ++r) {
+        sums[r][0] = Simd<double>::load(C + r * ldc);
+        sums[r][1] = Simd<double>::load(C + r * ldc + width);
+    }
+
+    for (unsigned int k = 0; k < inner; ++k) {
+        Vector B0 = Simd<double>::load_float(B + k * ldb), B1 = Simd<double>::load_float(B + k * ldb + width);
+        for (unsigned int r = 0; r < rows; ++r) {
+            Vector Ark = Simd<double>::broadcast(A[r * lda + k]);
+            sums[r][0] = Simd<double>::multiply_add(Ark, B0, sums[r][0]);
+            sums[r][1] = Simd<double>::multiply_add(Ark, B1, sums[r][1]);
+        }
+    }
+
+    for (unsigned int r = 0; r < rows; ++r) {
+        Simd<double>::store(C + r * ldc, sums[r][0]);
+        Simd<double>::store(C + r * ldc + width, sums[r][1]);
+    }
+}
+
+#endif
+
+// C += A B, where products are summed in double and rounded to float once
+// all matrices are given as pointers to row-major data and their row strides
+inline void mixed_kernel(unsigned int rows, unsigned int cols, unsigned int inner,
+                         const float *A, unsigned int lda, const float *B, unsigned int ldb,
+                         float *C, unsigned int ldc) {
+    // sums of the whole block of C, blocking over inner dimension can not round partial sums
+    std::vector<double> sums(std::size_t(rows) * cols, 0.0);
+
+    for (unsigned int k0 = 0; k0 < inner; k0 += classic_block_inner) {
+        unsigned int block_inner = std::min(classic_block_inner, inner - k0);
+        const float *block_A = A + k0, *block_B = B + k0 * ldb;
+        unsigned int full_cols = 0;
+
+#ifdef FAST_MATRIX_MULTIPLICATION_SIMD
+        const unsigned int tile_cols = 2 * Simd<double>::width;
+        full_cols = cols / tile_cols * tile_cols;
+
+        unsigned int i = 0;
+        for (; i + classic_simd_rows <= rows; i += classic_simd_rows) {
+            for (unsigned int j = 0; j < full_cols; j += tile_cols) {
+                mixed_simd_tile<classic_simd_rows>(block_inner, block_A + i * lda, lda, block_B + j, ldb,
+                                                   sums.data() + i * cols + j, cols);
+            }
+        }
+        for (; i < rows; ++i) {
+            for (unsigned int j = 0; j < full_cols; j += tile_cols) {
+                mixed_simd_tile<1>(block_inner, block_A + i * lda, lda, block_B + j, ldb,
+                                   sums.data() + i * cols + j, cols);
+            }
+        }
+#endif
+
+        // remaining columns (all columns without SIMD)
+        for (unsigned int i = 0; i < rows; ++i) {
+            double *row_sums = sums.data() + i * cols;
+            for (unsigned int k = 0; k < block_inner; ++k) {
+                const double Aik = block_A[i * lda + k];
+                const float *row_B = block_B + k * ldb;
+                for (unsigned int j = full_cols; j < cols; ++j) {
+                    row_sums[j] += Aik * row_B[j];
+                }
+            }
+        }
+    }
+
+    for (unsigned int i = 0; i < rows; ++i) {
+        for (unsigned int j = 0; j < cols; ++j) {
+            C[i * ldc + j] += float(sums[i * cols + j]);
+        }
+    }
+}
+
+} // inline namespace FAST_MATRIX_MULTIPLICATION_ISA_NAMESPACE
+
+// C += A B with kernel of chosen precision
+inline void float_kernel(unsigned int rows, unsigned int cols, unsigned int inner,
+                         const float *A, unsigned int lda, const float *B, unsigned int ldb,
+                         float *C, unsigned int ldc, Precision precision) {
+    if (precision == Precision::mixed) {
+        mixed_kernel(rows, cols, inner, A, lda, B, ldb, C, ldc);
+    } else {
+        classic_kernel(rows, cols, inner, A, lda, Op::none, B, ldb, Op::none, C, ldc);
+    }
+}
+
+// C += A B with `depth` levels of Strassen's scheme, sums of blocks are stored as floats
+inline void float_strassen(const Matrix<float> &A, const Matrix<float> &B, Matrix<float> &C,
+                           unsigned int depth, Precision precision) {
+    if (depth == 0) {
+        float_kernel(C.rows, C.cols, A.cols, A.data.data(), A.cols, B.data.data(), B.cols,
+                     C.data.data(), C.cols, precision);
+        return;
+    }
+
+    const Scheme &scheme = strassen_scheme();
+    const unsigned int block_rows = A.rows / 2, block_inner = A.cols / 2, block_cols = B.cols / 2;
+
+    std::vector<Matrix<float>> A_blocks, B_blocks;
+    for (unsigned int i = 0; i < 2; ++i) {
+        for (unsigned int j = 0; j < 2; ++j) {
+            A_blocks.push_back(A.subblock({i * block_rows, j * block_inner}, {block_rows, block_inner}));
+            B_blocks.push_back(B.subblock({i * block_inner, j * block_cols}, {block_inner, block_cols}));
+        }
+    }
+
+    Matrix<float> C_blocks = Matrix<float>::zeros(2 * block_rows, 2 * block_cols);
+    for (const SchemeProduct &product : scheme.products) {
+        Matrix<float> P = Matrix<float>::zeros(block_rows, block_cols);
+        float_strassen(scheme_combination(product.a, A_blocks), scheme_combination(product.b, B_blocks), P,
+                       depth - 1, precision);
+        scheme_accumulate(product.c, P, C_blocks, block_rows, block_cols, scheme.n);
+    }
+    C.block_add({0, 0}, C_blocks);
+
+    // dynamic peeling of rows and columns that were left out, computed directly into C
+    const unsigned int included_rows = 2 * block_rows, included_inner = 2 * block_inner,
+            included_cols = 2 * block_cols;
+
+    float_kernel(included_rows, included_cols, A.cols - included_inner,
+                 A.data.data() + included_inner, A.cols, B.data.data() + included_inner * B.cols, B.cols,
+                 C.data.data(), C.cols, precision);
+    float_kernel(C.rows, C.cols - included_cols, A.cols,
+                 A.data.data(), A.cols, B.data.data() + included_cols, B.cols,
+                 C.data.data() + included_cols, C.cols, precision);
+    float_kernel(C.rows - included_rows, included_cols, A.cols,
+                 A.data.data() + included_rows * A.cols, A.cols, B.data.data(), B.cols,
+                 C.data.data() + included_rows * C.cols, C.cols, precision);
+}
+
+// product A B of single precision matrices with Strassen's algorithm,
+// depth of recursion and its error bound are given by float_error_bound(A, B, options)
+inline Matrix<float> multiply_float(const Matrix<float> &A, const Matrix<float> &B,
+                                    const FloatOptions &options = FloatOptions()) {
+    // check dimensions
+    assert(A.cols == B.rows);
+
+    Matrix<float> C = Matrix<float>::zeros(A.rows, B.cols);
+    float_strassen(A, B, C, float_strassen_depth(A.rows, A.cols, B.cols, options), options.precision);
+    return C;
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_MULTIPLY_FLOAT_HPP
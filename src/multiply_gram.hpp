@@ -0,0 +1,119 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_MULTIPLY_GRAM_HPP
+#define FAST_MATRIX_MULTIPLICATION_MULTIPLY_GRAM_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include "algorithm.hpp"
+#include "matrix.hpp"
+#include "multiply_classic.hpp"
+#include "thread_pool.hpp"
+#include "transpose.hpp"
+
+// Gram matrix A A^T (symmetric rank-k update, SYRK in BLAS), only one triangle of it is calculated.
+//
+// Rows of A are split in two halves A1 and A2: diagonal blocks A1 A1^T and A2 A2^T are Gram matrices
+// again, and the block of the triangle outside the diagonal (A2 A1^T in the lower triangle, A1 A2^T in
+// the upper one) is a general product calculated with the chosen fast algorithm. Recursion stops when
+// the algorithm would multiply the off-diagonal block classically; the diagonal block is then calculated
+// in tiles of rows (split between threads of the pool), each tile only up to the diagonal. This needs about
+// half of the multiplications and writes of a general product, and A^T is never stored as a whole.
+
+enum class Triangle {
+    lower,
+    upper
+};
+
+// diagonal blocks are calculated in tiles of this many rows
+const unsigned int gram_tile_rows = 32;
+
+// rows r0 ... r0 + gram_tile_rows of the triangle calculated by gram_classic() (up to the diagonal),
+// AT is the transpose of rows first ... first + count of A
+template<class Scalar>
+void gram_classic_tile(const Matrix<Scalar> &A, const Matrix<Scalar> &AT, unsigned int first, unsigned int count,
+                       unsigned int r0, Matrix<Scalar> &C, Triangle triangle) {
+    const unsigned int rows = std::min(gram_tile_rows, count - r0);
+    // lower triangle: columns 0 ... r0 + rows, upper triangle: columns r0 ... count
+    const unsigned int c0 = triangle == Triangle::lower ? 0 : r0,
+            c1 = triangle == Triangle::lower ? r0 + rows : count;
+    Scalar *tile = C.data.data() + std::size_t(first + r0) * C.cols + first + c0;
+    classic_kernel(rows, c1 - c0, A.cols, A.data.data() + std::size_t(first + r0) * A.cols, A.cols, Op::none,
+                   AT.data.data() + c0, AT.cols, Op::none, tile, C.cols);
+
+    // tile overlaps diagonal, entries on the other side of it are cleared
+    for (unsigned int i = 0; i < rows; ++i) {
+        Scalar *row = C.data.data() + std::size_t(first + r0 + i) * C.cols + first;
+        if (triangle == Triangle::lower) {
+            std::fill(row + r0 + i + 1, row + r0 + rows, Scalar(0));
+        } else {
+            std::fill(row + r0, row + r0 + i, Scalar(0));
+        }
+    }
+}
+
+// triangle of Gram matrix of rows first ... first + count of A, written to the same rows and columns of C
+template<class Scalar>
+void gram_classic(const Matrix<Scalar> &A, unsigned int first, unsigned int count, Matrix<Scalar> &C,
+                  Triangle triangle) {
+    // rows of A as columns, so the kernel reads both operands without transposing them again
+    Matrix<Scalar> AT = A.subblock({first, 0}, {count, A.cols}).transposed();
+
+    // tiles are split between threads (the triangle is about half of a count x count product)
+    const unsigned int tiles = (count + gram_tile_rows - 1) / gram_tile_rows,
+            grain = (classic_parallel_rows(count, count / 2, A.cols) + gram_tile_rows - 1) / gram_tile_rows;
+    parallel_for(0, tiles, grain, [&](unsigned int first_tile, unsigned int last_tile) {
+        for (unsigned int tile = first_tile; tile < last_tile; ++tile) {
+            gram_classic_tile(A, AT, first, count, tile * gram_tile_rows, C, triangle);
+        }
+    });
+}
+
+// B1 B2^T calculated with chosen algorithm
+template<class Scalar>
+Matrix<Scalar> gram_product(const Matrix<Scalar> &B1, const Matrix<Scalar> &B2, Algorithm algorithm) {
+    switch (algorithm) {
+        case Algorithm::strassen:
+            return multiply_strassen_dynamic(B1, B2, Op::none, Op::transpose);
+        case Algorithm::laderman:
+            return multiply_laderman(B1, B2, Op::none, Op::transpose);
+        case Algorithm::rectangular:
+            return multiply_rectangular(B1, B2.transposed());
+        default:
+            return multiply_classic(B1, B2, Op::none, Op::transpose);
+    }
+}
+
+// triangle of Gram matrix of rows first ... first + count of A, written to the same rows and columns of C
+template<class Scalar>
+void gram_recursive(const Matrix<Scalar> &A, unsigned int first, unsigned int count, Matrix<Scalar> &C,
+                    Triangle triangle, Algorithm algorithm) {
+    const unsigned int half = count / 2;
+    if (algorithm_recursion_scheme(algorithm, count - half, A.cols, half) == nullptr) {
+        gram_classic(A, first, count, C, triangle);
+        return;
+    }
+
+    gram_recursive(A, first, half, C, triangle, algorithm);
+    gram_recursive(A, first + half, count - half, C, triangle, algorithm);
+
+    Matrix<Scalar> A1 = A.subblock({first, 0}, {half, A.cols}),
+            A2 = A.subblock({first + half, 0}, {count - half, A.cols});
+    if (triangle == Triangle::lower) {
+        C.block_add({first + half, first}, gram_product(A2, A1, algorithm));
+    } else {
+        C.block_add({first, first + half}, gram_product(A1, A2, algorithm));
+    }
+}
+
+// chosen triangle of A A^T (including diagonal), entries of the other triangle are zeros
+template<class Scalar>
+Matrix<Scalar> multiply_gram(const Matrix<Scalar> &A, Triangle triangle = Triangle::lower,
+                             Algorithm algorithm = Algorithm::strassen) {
+    Matrix<Scalar> C = Matrix<Scalar>::zeros(A.rows, A.rows);
+    if (A.rows > 0) {
+        gram_recursive(A, 0, A.rows, C, triangle, algorithm);
+    }
+    return C;
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_MULTIPLY_GRAM_HPP
@@ -0,0 +1,363 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_MULTIPLY_INTEGER_HPP
+#define FAST_MATRIX_MULTIPLICATION_MULTIPLY_INTEGER_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "matrix.hpp"
+#include "multiply_strassen.hpp"
+#include "scheme.hpp"
+
+#if defined(__AVX2__) || defined(__AVX512VNNI__)
+#include <immintrin.h>
+#endif
+
+// Products of low-precision integer matrices (int8, uint8 and int16 entries), as used by quantized models.
+//
+// Inputs are widened to int16 and multiplied with widening multiply-add instructions: pmaddwd multiplies
+// pairs of int16 values and adds both products into one int32 lane, so it never saturates (pmaddubsw,
+// which works directly on bytes, saturates its int16 sums and is not used). When AVX-512 VNNI is available,
+// uint8 x int8 products use vpdpbusd, which adds four byte products into an int32 lane at once.
+// Partial sums are kept in int32 lanes for as many terms as can not overflow and are then added
+// into the accumulator type (int32 or int64).
+//
+// Strassen's recursion is used on the widened int16 operands as long as sums of blocks still fit in int16
+// (every level doubles the largest possible entry), so int8 inputs get several levels and full range int16
+// inputs get none. Products are exact: if the result may not fit in the accumulator, std::overflow_error
+// is thrown before anything is computed.
+
+// Strassen is used only while all dimensions are larger than this, integer kernel is fast,
+// so recursion pays off later than for generic scalars
+const unsigned int integer_strassen_threshold = 256;
+
+// output columns processed at once by SIMD kernels (four AVX2 registers, two AVX-512 registers of int32)
+const unsigned int integer_panel_cols = 32;
+
+// largest absolute value in matrix
+template<class Integer>
+std::int64_t integer_max_abs(const Matrix<Integer> &A) {
+    std::int64_t max_abs = 0;
+    for (const Integer &value : A.data) {
+        max_abs = std::max(max_abs, value < 0 ? -std::int64_t(value) : std::int64_t(value));
+    }
+    return max_abs;
+}
+
+// number of inner terms whose products (bounded by max_a * max_b) can be summed in int32 without overflow
+inline unsigned int integer_block_inner(std::int64_t max_a, std::int64_t max_b) {
+    std::int64_t bound = std::max<std::int64_t>(1, max_a * max_b);
+    return static_cast<unsigned int>(std::min<std::int64_t>(std::numeric_limits<std::int32_t>::max() / bound,
+                                                            std::numeric_limits<unsigned int>::max()));
+}
+
+// C += A B with accumulator type arithmetic, used when even two products do not fit in int32
+template<class Accumulator>
+void integer_kernel_wide(unsigned int rows, unsigned int cols, unsigned int inner,
+                         const std::int16_t *A, unsigned int lda, const std::int16_t *B, unsigned int ldb,
+                         Accumulator *C, unsigned int ldc) {
+    for (unsigned int i = 0; i < rows; ++i) {
+        for (unsigned int k = 0; k < inner; ++k) {
+            const Accumulator Aik = A[i * lda + k];
+            for (unsigned int j = 0; j < cols; ++j) {
+                C[i * ldc + j] += Aik * Accumulator(B[k * ldb + j]);
+            }
+        }
+    }
+}
+
+// C += A B, portable version: each row is summed in int32 over block_inner terms, then added to C
+template<class Accumulator>
+void integer_kernel_scalar(unsigned int rows, unsigned int cols, unsigned int inner,
+                           const std::int16_t *A, unsigned int lda, const std::int16_t *B, unsigned int ldb,
+                           Accumulator *C, unsigned int ldc, unsigned int block_inner) {
+    std::vector<std::int32_t> row(cols);
+
+    for (unsigned int k0 = 0; k0 < inner; k0 += block_inner) {
+        unsigned int k_end = std::min(inner, k0 + block_inner);
+        for (unsigned int i = 0; i < rows; ++i) {
+            std::fill(row.begin(), row.end(), 0);
+            for (unsigned int k = k0; k < k_end; ++k) {
+                const std::int32_t Aik = A[i * lda + k];
+                const std::int16_t *iter_B = B + k * ldb;
+                for (unsigned int j = 0; j < cols; ++j) {
+                    row[j] += Aik * iter_B[j];
+                }
+            }
+            for (unsigned int j = 0; j < cols; ++j) {
+                C[i * ldc + j] += row[j];
+            }
+        }
+    }
+}
+
+#ifdef __AVX2__
+
+// C += A B with pmaddwd, block_inner has to be even
+// B is packed in panels of integer_panel_cols columns, inside a panel rows k and k + 1 are interleaved:
+// b[k][j], b[k + 1][j], b[k][j + 1], b[k + 1][j + 1], ... so one register holds pairs for 8 columns.
+// Pair a[i][k], a[i][k + 1] is broadcast to all lanes and pmaddwd gives a[i][k] b[k][j] + a[i][k + 1] b[k + 1][j].
+template<class Accumulator>
+void integer_kernel_avx2(unsigned int rows, unsigned int cols, unsigned int inner,
+                         const std::int16_t *A, unsigned int lda, const std::int16_t *B, unsigned int ldb,
+                         Accumulator *C, unsigned int ldc, unsigned int block_inner) {
+    const unsigned int panels = (cols + integer_panel_cols - 1) / integer_panel_cols;
+    std::vector<std::int16_t> packed;
+
+    for (unsigned int k0 = 0; k0 < inner; k0 += block_inner) {
+        unsigned int current_inner = std::min(block_inner, inner - k0);
+        unsigned int pairs = (current_inner + 1) / 2;
+
+        // pack rows k0 ... k0 + current_inner of B, missing columns and the odd row are zeros
+        packed.assign(std::size_t(panels) * pairs * integer_panel_cols * 2, 0);
+        for (unsigned int p = 0; p < panels; ++p) {
+            for (unsigned int k = 0; k < current_inner; ++k) {
+                const std::int16_t *row_B = B + (k0 + k) * ldb;
+                std::int16_t *row_packed = packed.data() +
+                                           (std::size_t(p) * pairs + k / 2) * integer_panel_cols * 2 + k % 2;
+                for (unsigned int j = p * integer_panel_cols; j < std::min(cols, (p + 1) * integer_panel_cols); ++j) {
+                    row_packed[2 * (j - p * integer_panel_cols)] = row_B[j];
+                }
+            }
+        }
+
+        for (unsigned int p = 0; p < panels; ++p) {
+            const std::int16_t *panel_B = packed.data() + std::size_t(p) * pairs * integer_panel_cols * 2;
+            unsigned int panel_cols = std::min(integer_panel_cols, cols - p * integer_panel_cols);
+
+            for (unsigned int i = 0; i < rows; ++i) {
+                const std::int16_t *row_A = A + i * lda + k0;
+                __m256i sum0 = _mm256_setzero_si256(), sum1 = _mm256_setzero_si256(),
+                        sum2 = _mm256_setzero_si256(), sum3 = _mm256_setzero_si256();
+
+                for (unsigned int q = 0; q < pairs; ++q) {
+                    // a[i][k] in lower and a[i][k + 1] in upper half of every lane
+                    std::uint32_t low = std::uint16_t(row_A[2 * q]);
+                    std::uint32_t high = 2 * q + 1 < current_inner ? std::uint16_t(row_A[2 * q + 1]) : 0;
+                    __m256i a = _mm256_set1_epi32(static_cast<int>(low | (high << 16)));
+
+                    const __m256i *b = reinterpret_cast<const __m256i *>(panel_B + q * integer_panel_cols * 2);
+                    sum0 = _mm256_add_epi32(sum0, _mm256_madd_epi16(a, _mm256_loadu_si256(b)));
+                    sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(a, _mm256_loadu_si256(b + 1)));
+                    sum2 = _mm256_add_epi32(sum2, _mm256_madd_epi16(a, _mm256_loadu_si256(b + 2)));
+                    sum3 = _mm256_add_epi32(sum3, _mm256_madd_epi16(a, _mm256_loadu_si256(b + 3)));
+                }
+
+                std::int32_t result[integer_panel_cols];
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(result), sum0);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(result + 8), sum1);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(result + 16), sum2);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(result + 24), sum3);
+
+                Accumulator *row_C = C + i * ldc + p * integer_panel_cols;
+                for (unsigned int j = 0; j < panel_cols; ++j) {
+                    row_C[j] += result[j];
+                }
+            }
+        }
+    }
+}
+
+#endif
+
+#ifdef __AVX512VNNI__
+
+// C += A B for uint8 A and int8 B with vpdpbusd, block_inner has to be a multiple of 4
+// B is packed in panels of integer_panel_cols columns, four consecutive rows are interleaved,
+// so every int32 lane holds b[k][j], ..., b[k + 3][j]; four bytes of a row of A are broadcast.
+template<class Accumulator>
+void integer_kernel_vnni(unsigned int rows, unsigned int cols, unsigned int inner,
+                         const std::uint8_t *A, unsigned int lda, const std::int8_t *B, unsigned int ldb,
+                         Accumulator *C, unsigned int ldc, unsigned int block_inner) {
+    const unsigned int panels = (cols + integer_panel_cols - 1) / integer_panel_cols;
+    std::vector<std::int8_t> packed;
+
+    for (unsigned int k0 = 0; k0 < inner; k0 += block_inner) {
+        unsigned int current_inner = std::min(block_inner, inner - k0);
+        unsigned int quads = (current_inner + 3) / 4;
+
+        packed.assign(std::size_t(panels) * quads * integer_panel_cols * 4, 0);
+        for (unsigned int p = 0; p < panels; ++p) {
+            for (unsigned int k = 0; k < current_inner; ++k) {
+                const std::int8_t *row_B = B + (k0 + k) * ldb;
+                std::int8_t *row_packed = packed.data() +
+                                          (std::size_t(p) * quads + k / 4) * integer_panel_cols * 4 + k % 4;
+                for (unsigned int j = p * integer_panel_cols; j < std::min(cols, (p + 1) * integer_panel_cols); ++j) {
+                    row_packed[4 * (j - p * integer_panel_cols)] = row_B[j];
+                }
+            }
+        }
+
+        for (unsigned int p = 0; p < panels; ++p) {
+            const std::int8_t *panel_B = packed.data() + std::size_t(p) * quads * integer_panel_cols * 4;
+            unsigned int panel_cols = std::min(integer_panel_cols, cols - p * integer_panel_cols);
+
+            for (unsigned int i = 0; i < rows; ++i) {
+                const std::uint8_t *row_A = A + i * lda + k0;
+                __m512i sum0 = _mm512_setzero_si512(), sum1 = _mm512_setzero_si512();
+
+                for (unsigned int q = 0; q < quads; ++q) {
+                    std::uint32_t quad = 0;
+                    for (unsigned int t = 0; t < 4 && 4 * q + t < current_inner; ++t) {
+                        quad |= std::uint32_t(row_A[4 * q + t]) << (8 * t);
+                    }
+                    __m512i a = _mm512_set1_epi32(static_cast<int>(quad));
+
+                    const std::int8_t *b = panel_B + q * integer_panel_cols * 4;
+                    sum0 = _mm512_dpbusd_epi32(sum0, a, _mm512_loadu_si512(b));
+                    sum1 = _mm512_dpbusd_epi32(sum1, a, _mm512_loadu_si512(b + 64));
+                }
+
+                std::int32_t result[integer_panel_cols];
+                _mm512_storeu_si512(result, sum0);
+                _mm512_storeu_si512(result + 16, sum1);
+
+                Accumulator *row_C = C + i * ldc + p * integer_panel_cols;
+                for (unsigned int j = 0; j < panel_cols; ++j) {
+                    row_C[j] += result[j];
+                }
+            }
+        }
+    }
+}
+
+#endif
+
+// C += A B, where entries of A and B are bounded by max_a and max_b in absolute value
+// all matrices are given as pointers to row-major data and their row strides
+template<class Accumulator>
+void integer_kernel(unsigned int rows, unsigned int cols, unsigned int inner,
+                    const std::int16_t *A, unsigned int lda, const std::int16_t *B, unsigned int ldb,
+                    Accumulator *C, unsigned int ldc, std::int64_t max_a, std::int64_t max_b) {
+    unsigned int block_inner = integer_block_inner(max_a, max_b);
+
+    // only possible for -32768 * -32768, pair of such products does not fit in int32
+    if (block_inner < 2) {
+        integer_kernel_wide(rows, cols, inner, A, lda, B, ldb, C, ldc);
+        return;
+    }
+
+#ifdef __AVX2__
+    integer_kernel_avx2(rows, cols, inner, A, lda, B, ldb, C, ldc, block_inner & ~1u);
+#else
+    integer_kernel_scalar(rows, cols, inner, A, lda, B, ldb, C, ldc, block_inner);
+#endif
+}
+
+// number of Strassen levels that keep all sums of blocks in int16 and all partial results in Accumulator
+template<class Accumulator>
+unsigned int integer_strassen_depth(unsigned int rows, unsigned int inner, unsigned int cols,
+                                    std::int64_t max_a, std::int64_t max_b) {
+    const std::int64_t max_accumulator = std::numeric_limits<Accumulator>::max();
+    unsigned int depth = 0;
+
+    while (std::min(rows, std::min(inner, cols)) > integer_strassen_threshold) {
+        // entries of sums of blocks on next level
+        std::int64_t level_a = max_a << (depth + 1), level_b = max_b << (depth + 1);
+        if (level_a > std::numeric_limits<std::int16_t>::max() || level_b > std::numeric_limits<std::int16_t>::max()) {
+            break;
+        }
+        // products of blocks have entries up to inner * level_a * level_b, and up to four of them are
+        // added together (in Strassen's C11 and C22), inner is halved on every level
+        if (double(inner / 2) * double(level_a) * double(level_b) * 4 > double(max_accumulator)) {
+            break;
+        }
+        depth++;
+        rows /= 2;
+        inner /= 2;
+        cols /= 2;
+    }
+    return depth;
+}
+
+// C += A B with `depth` levels of Strassen's scheme, entries of A and B are bounded by max_a and max_b
+template<class Accumulator>
+void integer_strassen(const Matrix<std::int16_t> &A, const Matrix<std::int16_t> &B, Matrix<Accumulator> &C,
+                      unsigned int depth, std::int64_t max_a, std::int64_t max_b) {
+    if (depth == 0) {
+        integer_kernel(C.rows, C.cols, A.cols, A.data.data(), A.cols, B.data.data(), B.cols,
+                       C.data.data(), C.cols, max_a, max_b);
+        return;
+    }
+
+    const Scheme &scheme = strassen_scheme();
+    const unsigned int block_rows = A.rows / 2, block_inner = A.cols / 2, block_cols = B.cols / 2;
+
+    std::vector<Matrix<std::int16_t>> A_blocks, B_blocks;
+    for (unsigned int i = 0; i < 2; ++i) {
+        for (unsigned int j = 0; j < 2; ++j) {
+            A_blocks.push_back(A.subblock({i * block_rows, j * block_inner}, {block_rows, block_inner}));
+            B_blocks.push_back(B.subblock({i * block_inner, j * block_cols}, {block_inner, block_cols}));
+        }
+    }
+
+    // sums of two blocks fit in int16, this was checked by integer_strassen_depth()
+    Matrix<Accumulator> C_blocks = Matrix<Accumulator>::zeros(2 * block_rows, 2 * block_cols);
+    for (const SchemeProduct &product : scheme.products) {
+        Matrix<std::int16_t> S = scheme_combination(product.a, A_blocks);
+        Matrix<std::int16_t> T = scheme_combination(product.b, B_blocks);
+        Matrix<Accumulator> P = Matrix<Accumulator>::zeros(block_rows, block_cols);
+        integer_strassen(S, T, P, depth - 1, 2 * max_a, 2 * max_b);
+        scheme_accumulate(product.c, P, C_blocks, block_rows, block_cols, scheme.n);
+    }
+    C.block_add({0, 0}, C_blocks);
+
+    // dynamic peeling of rows and columns that were left out, computed directly into C
+    const unsigned int included_rows = 2 * block_rows, included_inner = 2 * block_inner,
+            included_cols = 2 * block_cols;
+
+    integer_kernel(included_rows, included_cols, A.cols - included_inner,
+                   A.data.data() + included_inner, A.cols, B.data.data() + included_inner * B.cols, B.cols,
+                   C.data.data(), C.cols, max_a, max_b);
+    integer_kernel(C.rows, C.cols - included_cols, A.cols,
+                   A.data.data(), A.cols, B.data.data() + included_cols, B.cols,
+                   C.data.data() + included_cols, C.cols, max_a, max_b);
+    integer_kernel(C.rows - included_rows, included_cols, A.cols,
+                   A.data.data() + included_rows * A.cols, A.cols, B.data.data(), B.cols,
+                   C.data.data() + included_rows * C.cols, C.cols, max_a, max_b);
+}
+
+// exact product A B of matrices with int8, uint8 or int16 entries, accumulated in int32 or int64
+// throws std::overflow_error if entries of the product may not fit in Accumulator
+template<class Accumulator = std::int32_t, class IntegerA, class IntegerB>
+Matrix<Accumulator> multiply_integer(const Matrix<IntegerA> &A, const Matrix<IntegerB> &B) {
+    static_assert(std::is_same<Accumulator, std::int32_t>::value || std::is_same<Accumulator, std::int64_t>::value,
+                  "accumulator has to be int32_t or int64_t");
+    static_assert(std::is_integral<IntegerA>::value && sizeof(IntegerA) <= 2 &&
+                  std::is_integral<IntegerB>::value && sizeof(IntegerB) <= 2 &&
+                  (std::is_signed<IntegerA>::value || sizeof(IntegerA) == 1) &&
+                  (std::is_signed<IntegerB>::value || sizeof(IntegerB) == 1),
+                  "inputs have to be int8_t, uint8_t or int16_t matrices");
+
+    // check dimensions
+    assert(A.cols == B.rows);
+
+    Matrix<Accumulator> C = Matrix<Accumulator>::zeros(A.rows, B.cols);
+    const std::int64_t max_a = integer_max_abs(A), max_b = integer_max_abs(B);
+
+    // every entry of C is a sum of A.cols products bounded by max_a * max_b
+    if (double(A.cols) * double(max_a) * double(max_b) > double(std::numeric_limits<Accumulator>::max())) {
+        throw std::overflow_error("product of integer matrices may not fit in accumulator");
+    }
+
+    const unsigned int depth = integer_strassen_depth<Accumulator>(A.rows, A.cols, B.cols, max_a, max_b);
+
+#ifdef __AVX512VNNI__
+    // uint8 x int8 without recursion is multiplied directly, without widening
+    if (depth == 0 && std::is_same<IntegerA, std::uint8_t>::value && std::is_same<IntegerB, std::int8_t>::value) {
+        integer_kernel_vnni(C.rows, C.cols, A.cols,
+                            reinterpret_cast<const std::uint8_t *>(A.data.data()), A.cols,
+                            reinterpret_cast<const std::int8_t *>(B.data.data()), B.cols,
+                            C.data.data(), C.cols, integer_block_inner(max_a, max_b) & ~3u);
+        return C;
+    }
+#endif
+
+    integer_strassen(Matrix<std::int16_t>(A), Matrix<std::int16_t>(B), C, depth, max_a, max_b);
+    return C;
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_MULTIPLY_INTEGER_HPP
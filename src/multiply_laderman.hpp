@@ -1,33 +1,97 @@
 #ifndef FAST_MATRIX_MULTIPLICATION_MULTIPLY_LADERMAN_HPP
 #define FAST_MATRIX_MULTIPLICATION_MULTIPLY_LADERMAN_HPP
 
+#include <type_traits>
 #include "matrix.hpp"
 #include "multiply_classic.hpp"
 #include "dynamic_peeling.hpp"
+#include "scheme.hpp"
 
 // when to switch to classic matrix multiplication
 // for Laderman's algorithm, this has to be at least 2
 const unsigned int laderman_threshold = 200;
 
+// coefficients of Laderman's algorithm, same products as in multiply_laderman() below
+inline const Scheme &laderman_scheme() {
+    static const Scheme scheme = {
+            3, 3, 3, {
+            // P1 = (A11 + A12 + A13 - A21 - A22 - A32 - A33) B22, added to C12
+            {{1, 1, 1, -1, -1, 0, 0, -1, -1}, {0, 0, 0, 0, 1, 0, 0, 0, 0}, {0, 1, 0, 0, 0, 0, 0, 0, 0}},
+            // P2 = (A11 - A21) (-B12 + B22), added to C21, C22
+            {{1, 0, 0, -1, 0, 0, 0, 0, 0}, {0, -1, 0, 0, 1, 0, 0, 0, 0}, {0, 0, 0, 1, 1, 0, 0, 0, 0}},
+            // P3 = A22 (-B11 + B12 + B21 - B22 - B23 - B31 + B33), added to C21
+            {{0, 0, 0, 0, 1, 0, 0, 0, 0}, {-1, 1, 0, 1, -1, -1, -1, 0, 1}, {0, 0, 0, 1, 0, 0, 0, 0, 0}},
+            // P4 = (-A11 + A21 + A22) (B11 - B12 + B22), added to C12, C21, C22
+            {{-1, 0, 0, 1, 1, 0, 0, 0, 0}, {1, -1, 0, 0, 1, 0, 0, 0, 0}, {0, 1, 0, 1, 1, 0, 0, 0, 0}},
+            // P5 = (A21 + A22) (-B11 + B12), added to C12, C22
+            {{0, 0, 0, 1, 1, 0, 0, 0, 0}, {-1, 1, 0, 0, 0, 0, 0, 0, 0}, {0, 1, 0, 0, 1, 0, 0, 0, 0}},
+            // P6 = A11 B11, added to C11, C12, C13, C21, C22, C31, C33
+            {{1, 0, 0, 0, 0, 0, 0, 0, 0}, {1, 0, 0, 0, 0, 0, 0, 0, 0}, {1, 1, 1, 1, 1, 0, 1, 0, 1}},
+            // P7 = (-A11 + A31 + A32) (B11 - B13 + B23), added to C13, C31, C33
+            {{-1, 0, 0, 0, 0, 0, 1, 1, 0}, {1, 0, -1, 0, 0, 1, 0, 0, 0}, {0, 0, 1, 0, 0, 0, 1, 0, 1}},
+            // P8 = (-A11 + A31) (B13 - B23), added to C31, C33
+            {{-1, 0, 0, 0, 0, 0, 1, 0, 0}, {0, 0, 1, 0, 0, -1, 0, 0, 0}, {0, 0, 0, 0, 0, 0, 1, 0, 1}},
+            // P9 = (A31 + A32) (-B11 + B13), added to C13, C33
+            {{0, 0, 0, 0, 0, 0, 1, 1, 0}, {-1, 0, 1, 0, 0, 0, 0, 0, 0}, {0, 0, 1, 0, 0, 0, 0, 0, 1}},
+            // P10 = (A11 + A12 + A13 - A22 - A23 - A31 - A32) B23, added to C13
+            {{1, 1, 1, 0, -1, -1, -1, -1, 0}, {0, 0, 0, 0, 0, 1, 0, 0, 0}, {0, 0, 1, 0, 0, 0, 0, 0, 0}},
+            // P11 = A32 (-B11 + B13 + B21 - B22 - B23 - B31 + B32), added to C31
+            {{0, 0, 0, 0, 0, 0, 0, 1, 0}, {-1, 0, 1, 1, -1, -1, -1, 1, 0}, {0, 0, 0, 0, 0, 0, 1, 0, 0}},
+            // P12 = (-A13 + A32 + A33) (B22 + B31 - B32), added to C12, C31, C32
+            {{0, 0, -1, 0, 0, 0, 0, 1, 1}, {0, 0, 0, 0, 1, 0, 1, -1, 0}, {0, 1, 0, 0, 0, 0, 1, 1, 0}},
+            // P13 = (A13 - A33) (B22 - B32), added to C31, C32
+            {{0, 0, 1, 0, 0, 0, 0, 0, -1}, {0, 0, 0, 0, 1, 0, 0, -1, 0}, {0, 0, 0, 0, 0, 0, 1, 1, 0}},
+            // P14 = A13 B31, added to C11, C12, C13, C21, C23, C31, C32
+            {{0, 0, 1, 0, 0, 0, 0, 0, 0}, {0, 0, 0, 0, 0, 0, 1, 0, 0}, {1, 1, 1, 1, 0, 1, 1, 1, 0}},
+            // P15 = (A32 + A33) (-B31 + B32), added to C12, C32
+            {{0, 0, 0, 0, 0, 0, 0, 1, 1}, {0, 0, 0, 0, 0, 0, -1, 1, 0}, {0, 1, 0, 0, 0, 0, 0, 1, 0}},
+            // P16 = (-A13 + A22 + A23) (B23 + B31 - B33), added to C13, C21, C23
+            {{0, 0, -1, 0, 1, 1, 0, 0, 0}, {0, 0, 0, 0, 0, 1, 1, 0, -1}, {0, 0, 1, 1, 0, 1, 0, 0, 0}},
+            // P17 = (A13 - A23) (B23 - B33), added to C21, C23
+            {{0, 0, 1, 0, 0, -1, 0, 0, 0}, {0, 0, 0, 0, 0, 1, 0, 0, -1}, {0, 0, 0, 1, 0, 1, 0, 0, 0}},
+            // P18 = (A22 + A23) (-B31 + B33), added to C13, C23
+            {{0, 0, 0, 0, 1, 1, 0, 0, 0}, {0, 0, 0, 0, 0, 0, -1, 0, 1}, {0, 0, 1, 0, 0, 1, 0, 0, 0}},
+            // P19 = A12 B21, added to C11
+            {{0, 1, 0, 0, 0, 0, 0, 0, 0}, {0, 0, 0, 1, 0, 0, 0, 0, 0}, {1, 0, 0, 0, 0, 0, 0, 0, 0}},
+            // P20 = A23 B32, added to C22
+            {{0, 0, 0, 0, 0, 1, 0, 0, 0}, {0, 0, 0, 0, 0, 0, 0, 1, 0}, {0, 0, 0, 0, 1, 0, 0, 0, 0}},
+            // P21 = A21 B13, added to C23
+            {{0, 0, 0, 1, 0, 0, 0, 0, 0}, {0, 0, 1, 0, 0, 0, 0, 0, 0}, {0, 0, 0, 0, 0, 1, 0, 0, 0}},
+            // P22 = A31 B12, added to C32
+            {{0, 0, 0, 0, 0, 0, 1, 0, 0}, {0, 1, 0, 0, 0, 0, 0, 0, 0}, {0, 0, 0, 0, 0, 0, 0, 1, 0}},
+            // P23 = A33 B33, added to C33
+            {{0, 0, 0, 0, 0, 0, 0, 0, 1}, {0, 0, 0, 0, 0, 0, 0, 0, 1}, {0, 0, 0, 0, 0, 0, 0, 0, 1}}
+    }};
+    return scheme;
+}
+
 // Julian B. Larderman: A Noncomutative Algorithm for Multiplying 3x3 Matrices Using 23 Multiplications
 // similar to Strassen, except it works on 3x3 matrices.
 // static and dynamic versions could be implemented, but adding zeros to next power of 3
 // is not very practical, this is why only dynamic peeling version was implemented
+// calculates op(A) op(B), transposed operands are transposed while subblocks are copied
 template<typename Scalar>
-Matrix<Scalar> multiply_laderman(const Matrix<Scalar> &A, const Matrix<Scalar> &B) {
+Matrix<Scalar> multiply_laderman(const Matrix<Scalar> &A, const Matrix<Scalar> &B,
+                                 Op op_A = Op::none, Op op_B = Op::none) {
+    // dimensions of op(A) and op(B)
+    unsigned int rows_A = op_rows(A, op_A),
+            cols_A = op_cols(A, op_A),
+            rows_B = op_rows(B, op_B),
+            cols_B = op_cols(B, op_B);
+
     // dimension check
-    assert(A.cols == B.rows);
+    assert(cols_A == rows_B);
 
     // if any of the dimensions is too small, laderman's algorithm wont help
-    if (std::min(A.rows, std::min(A.cols, B.cols)) <= laderman_threshold) {
-        return multiply_classic(A, B);
+    if (std::min(rows_A, std::min(cols_A, cols_B)) <= laderman_threshold) {
+        return multiply_classic(A, B, op_A, op_B);
     }
 
     // subblock sizes
     std::pair<unsigned int, unsigned int>
-            block_A = {A.rows / 3, A.cols / 3},
-            block_B = {B.rows / 3, B.cols / 3},
-            product_block = {A.rows / 3, B.cols / 3};
+            block_A = {rows_A / 3, cols_A / 3},
+            block_B = {rows_B / 3, cols_B / 3},
+            product_block = {rows_A / 3, cols_B / 3};
     // block dimensions
     unsigned int block_rows_A = block_A.first,
             block_cols_A = block_A.second,
@@ -37,28 +101,32 @@ Matrix<Scalar> multiply_laderman(const Matrix<Scalar> &A, const Matrix<Scalar> &
             product_cols = product_block.second;
 
     // split matrices in subblocks
-    Matrix<Scalar> A11 = A.subblock({0, 0}, block_A),
-            A12 = A.subblock({0, block_cols_A}, block_A),
-            A13 = A.subblock({0, 2 * block_cols_A}, block_A),
-            A21 = A.subblock({block_rows_A, 0}, block_A),
-            A22 = A.subblock({block_rows_A, block_cols_A}, block_A),
-            A23 = A.subblock({block_rows_A, 2 * block_cols_A}, block_A),
-            A31 = A.subblock({2 * block_rows_A, 0}, block_A),
-            A32 = A.subblock({2 * block_rows_A, block_cols_A}, block_A),
-            A33 = A.subblock({2 * block_rows_A, 2 * block_cols_A}, block_A);
-
-    Matrix<Scalar> B11 = B.subblock({0, 0}, block_B),
-            B12 = B.subblock({0, block_cols_B}, block_B),
-            B13 = B.subblock({0, 2 * block_cols_B}, block_B),
-            B21 = B.subblock({block_rows_B, 0}, block_B),
-            B22 = B.subblock({block_rows_B, block_cols_B}, block_B),
-            B23 = B.subblock({block_rows_B, 2 * block_cols_B}, block_B),
-            B31 = B.subblock({2 * block_rows_B, 0}, block_B),
-            B32 = B.subblock({2 * block_rows_B, block_cols_B}, block_B),
-            B33 = B.subblock({2 * block_rows_B, 2 * block_cols_B}, block_B);
+    Matrix<Scalar> A11 = A.subblock({0, 0}, block_A, op_A),
+            A12 = A.subblock({0, block_cols_A}, block_A, op_A),
+            A13 = A.subblock({0, 2 * block_cols_A}, block_A, op_A),
+            A21 = A.subblock({block_rows_A, 0}, block_A, op_A),
+            A22 = A.subblock({block_rows_A, block_cols_A}, block_A, op_A),
+            A23 = A.subblock({block_rows_A, 2 * block_cols_A}, block_A, op_A),
+            A31 = A.subblock({2 * block_rows_A, 0}, block_A, op_A),
+            A32 = A.subblock({2 * block_rows_A, block_cols_A}, block_A, op_A),
+            A33 = A.subblock({2 * block_rows_A, 2 * block_cols_A}, block_A, op_A);
+
+    Matrix<Scalar> B11 = B.subblock({0, 0}, block_B, op_B),
+            B12 = B.subblock({0, block_cols_B}, block_B, op_B),
+            B13 = B.subblock({0, 2 * block_cols_B}, block_B, op_B),
+            B21 = B.subblock({block_rows_B, 0}, block_B, op_B),
+            B22 = B.subblock({block_rows_B, block_cols_B}, block_B, op_B),
+            B23 = B.subblock({block_rows_B, 2 * block_cols_B}, block_B, op_B),
+            B31 = B.subblock({2 * block_rows_B, 0}, block_B, op_B),
+            B32 = B.subblock({2 * block_rows_B, block_cols_B}, block_B, op_B),
+            B33 = B.subblock({2 * block_rows_B, 2 * block_cols_B}, block_B, op_B);
 
     // create larger matrix for result
-    Matrix<Scalar> C = Matrix<Scalar>::zeros(A.rows, B.cols);
+    Matrix<Scalar> C = Matrix<Scalar>::zeros(rows_A, cols_B);
+
+    // remaining rows and columns of C (if dimensions are not divisible by 3) are calculated meanwhile
+    TaskGroup peeling;
+    dynamic_peeling_start(A, B, C, 3, 3, peeling, op_A, op_B);
 
     // temporary matrix, here we will store products
     Matrix<Scalar> P;
@@ -208,11 +276,23 @@ Matrix<Scalar> multiply_laderman(const Matrix<Scalar> &A, const Matrix<Scalar> &
     // add P23 to C33
     C.block_add({2 * product_rows, 2 * product_cols}, P);
 
-    // fix remaining row and column if dimensions are odd
-    dynamic_peeling(A, B, C, 3, 3, 3);
+    // add products of remaining inner columns and rows
+    dynamic_peeling_update(A, B, C, 3, 3, 3, op_A, op_B);
+    peeling.wait();
 
     return C;
 
 }
 
+// laderman over a semiring, only semirings with subtraction are accepted (checked at compile time),
+// and of them only ordinary arithmetic, which blocks are added and multiplied with
+template<typename Scalar, typename Semiring>
+Matrix<Scalar> multiply_laderman(const Matrix<Scalar> &A, const Matrix<Scalar> &B, const Semiring &,
+                                 Op op_A = Op::none, Op op_B = Op::none) {
+    static_assert(Semiring::has_subtraction, "Laderman's algorithm needs a semiring with subtraction");
+    static_assert(std::is_same<Semiring, PlusTimes<Scalar>>::value,
+                  "Laderman's algorithm uses arithmetic of the scalar type, other rings are not supported");
+    return multiply_laderman(A, B, op_A, op_B);
+}
+
 #endif //FAST_MATRIX_MULTIPLICATION_MULTIPLY_LADERMAN_HPP
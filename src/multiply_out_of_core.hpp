@@ -0,0 +1,262 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_MULTIPLY_OUT_OF_CORE_HPP
+#define FAST_MATRIX_MULTIPLICATION_MULTIPLY_OUT_OF_CORE_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+#include "algorithm.hpp"
+#include "mapped_matrix.hpp"
+#include "matrix.hpp"
+#include "scheme.hpp"
+#include "thread_pool.hpp"
+
+// Out-of-core multiplication of matrices that do not fit in memory.
+//
+// Top levels of recursion apply Strassen's (or Laderman's) scheme directly to blocks of mapped matrices:
+// sums of blocks and products are stored in temporary files. Each level replaces 8 (27) products of
+// half (third) size with 7 (23), so fewer tiles are streamed from disk than with tiled multiplication alone.
+// When recursion stops, product is calculated tile by tile: tiles of A and B are copied into memory,
+// multiplied with the in-memory algorithm and accumulated into C. While one pair of tiles is being
+// multiplied, next pair is already read by a task of the thread pool (double buffering), so reading overlaps
+// computation.
+
+struct OutOfCoreOptions {
+    // approximate number of bytes of matrix data held in memory at once
+    // (tiles, their double buffers and temporaries of in-memory algorithm)
+    std::size_t memory_budget = std::size_t(1) << 30;
+    // algorithm used on top levels (on disk) and for in-memory products of tiles
+    Algorithm algorithm = Algorithm::strassen;
+    // at most this many top levels of recursion are done on disk
+    unsigned int max_levels = 2;
+    // where temporary files for sums of blocks and products are created
+    std::string temporary_directory = "/tmp";
+};
+
+// side of square tiles that are multiplied in memory,
+// about 12 tiles are alive at once (two pairs of input tiles, product, accumulator and algorithm's temporaries)
+template<class Scalar>
+unsigned int out_of_core_tile_size(const OutOfCoreOptions &options) {
+    double elements = double(options.memory_budget) / (12.0 * sizeof(Scalar));
+    return std::max(1u, static_cast<unsigned int>(std::sqrt(elements)));
+}
+
+// number of rows of a rows x cols matrix that are processed at once when blocks are added together
+template<class Scalar>
+unsigned int out_of_core_band_rows(unsigned int cols, const OutOfCoreOptions &options) {
+    // accumulator and one loaded block have to fit in memory
+    std::size_t row_bytes = std::max<std::size_t>(1, 2 * std::size_t(cols) * sizeof(Scalar));
+    return static_cast<unsigned int>(std::max<std::size_t>(1, options.memory_budget / row_bytes));
+}
+
+// C += A B, calculated tile by tile with double buffering
+template<class Scalar>
+void out_of_core_tiled(const MappedMatrix<Scalar> &A, const MappedMatrix<Scalar> &B, MappedMatrix<Scalar> &C,
+                       const OutOfCoreOptions &options) {
+    assert(A.cols == B.rows && A.rows == C.rows && B.cols == C.cols);
+
+    typedef std::pair<Matrix<Scalar>, Matrix<Scalar>> Tiles;
+    const unsigned int tile = out_of_core_tile_size<Scalar>(options);
+
+    if (A.cols == 0) {
+        return;
+    }
+
+    for (unsigned int i0 = 0; i0 < C.rows; i0 += tile) {
+        unsigned int tile_rows = std::min(tile, C.rows - i0);
+
+        // next band of A will be needed soon, kernel can start reading it
+        A.prefetch_rows(std::min(C.rows, i0 + tile), std::min(tile, C.rows - std::min(C.rows, i0 + tile)));
+
+        for (unsigned int j0 = 0; j0 < C.cols; j0 += tile) {
+            unsigned int tile_cols = std::min(tile, C.cols - j0);
+
+            // reads k-th pair of tiles: A(i, k) and B(k, j)
+            auto load = [&A, &B, i0, j0, tile, tile_rows, tile_cols](unsigned int k0) {
+                unsigned int tile_inner = std::min(tile, A.cols - k0);
+                return Tiles(A.load({i0, k0}, {tile_rows, tile_inner}), B.load({k0, j0}, {tile_inner, tile_cols}));
+            };
+
+            Matrix<Scalar> accumulator = Matrix<Scalar>::zeros(tile_rows, tile_cols);
+            Tiles next;
+            TaskGroup reading;
+            reading.run([&next, &load]() {
+                next = load(0u);
+            });
+
+            for (unsigned int k0 = 0; k0 < A.cols; k0 += tile) {
+                // if no worker has started reading yet, this thread reads the tiles itself
+                reading.wait();
+                Tiles current = std::move(next);
+
+                // start reading next pair of tiles while current pair is multiplied
+                if (k0 + tile < A.cols) {
+                    reading.run([&next, &load, k0, tile]() {
+                        next = load(k0 + tile);
+                    });
+                }
+
+                accumulator += multiply(current.first, current.second, options.algorithm);
+            }
+
+            C.block_add({i0, j0}, accumulator);
+        }
+    }
+}
+
+// sum coefficients[i] * blocks[i], stored in a temporary file
+// (if sum is just one of the blocks, block itself is returned and nothing is copied)
+template<class Scalar>
+MappedMatrix<Scalar> out_of_core_combination(const std::vector<int> &coefficients,
+                                             const std::vector<MappedMatrix<Scalar>> &blocks,
+                                             const OutOfCoreOptions &options) {
+    assert(coefficients.size() == blocks.size());
+
+    unsigned int used = 0, last = 0;
+    for (unsigned int i = 0; i < coefficients.size(); ++i) {
+        if (coefficients[i] != 0) {
+            used++;
+            last = i;
+        }
+    }
+    if (used == 1 && coefficients[last] == 1) {
+        return blocks[last];
+    }
+
+    const unsigned int rows = blocks[0].rows, cols = blocks[0].cols;
+    MappedMatrix<Scalar> sum = MappedMatrix<Scalar>::temporary(rows, cols, options.temporary_directory);
+    const unsigned int band = out_of_core_band_rows<Scalar>(cols, options);
+
+    // stream band by band, so only one band of the sum is in memory
+    for (unsigned int r0 = 0; r0 < rows; r0 += band) {
+        unsigned int band_rows = std::min(band, rows - r0);
+        for (unsigned int i = 0; i < coefficients.size(); ++i) {
+            if (coefficients[i] != 0) {
+                sum.block_add({r0, 0}, blocks[i].load({r0, 0}, {band_rows, cols}), coefficients[i]);
+            }
+        }
+    }
+    return sum;
+}
+
+// C += coefficient * P, band by band
+template<class Scalar>
+void out_of_core_add(MappedMatrix<Scalar> &C, const MappedMatrix<Scalar> &P, int coefficient,
+                     const OutOfCoreOptions &options) {
+    assert(C.rows == P.rows && C.cols == P.cols);
+
+    const unsigned int band = out_of_core_band_rows<Scalar>(C.cols, options);
+    for (unsigned int r0 = 0; r0 < C.rows; r0 += band) {
+        unsigned int band_rows = std::min(band, C.rows - r0);
+        C.block_add({r0, 0}, P.load({r0, 0}, {band_rows, C.cols}), coefficient);
+    }
+}
+
+// C += A B, top levels use scheme of chosen algorithm on disk, lower levels are tiled
+template<class Scalar>
+void out_of_core_multiply_add(const MappedMatrix<Scalar> &A, const MappedMatrix<Scalar> &B, MappedMatrix<Scalar> &C,
+                              const OutOfCoreOptions &options, unsigned int level) {
+    assert(A.cols == B.rows && A.rows == C.rows && B.cols == C.cols);
+
+    const Scheme *scheme = algorithm_scheme(options.algorithm, A.rows, A.cols, B.cols);
+    const unsigned int tile = out_of_core_tile_size<Scalar>(options);
+    const std::size_t bytes = (std::size_t(A.rows) * A.cols + std::size_t(B.rows) * B.cols +
+                               std::size_t(C.rows) * C.cols) * sizeof(Scalar);
+
+    // recursion on disk pays off only while operands do not fit in memory and blocks are larger than tiles
+    if (scheme == nullptr || level >= options.max_levels || bytes <= options.memory_budget ||
+        std::min(A.rows / scheme->m, std::min(A.cols / scheme->k, B.cols / scheme->n)) < tile) {
+        out_of_core_tiled(A, B, C, options);
+        return;
+    }
+
+    // block sizes, rows and columns that are left out are handled by peeling at the end
+    const unsigned int block_rows = A.rows / scheme->m,
+            block_inner = A.cols / scheme->k,
+            block_cols = B.cols / scheme->n;
+
+    // views of blocks, numbered row by row
+    std::vector<MappedMatrix<Scalar>> A_blocks, B_blocks, C_blocks;
+    for (unsigned int i = 0; i < scheme->m; ++i) {
+        for (unsigned int j = 0; j < scheme->k; ++j) {
+            A_blocks.push_back(A.block({i * block_rows, j * block_inner}, {block_rows, block_inner}));
+        }
+    }
+    for (unsigned int i = 0; i < scheme->k; ++i) {
+        for (unsigned int j = 0; j < scheme->n; ++j) {
+            B_blocks.push_back(B.block({i * block_inner, j * block_cols}, {block_inner, block_cols}));
+        }
+    }
+    for (unsigned int i = 0; i < scheme->m; ++i) {
+        for (unsigned int j = 0; j < scheme->n; ++j) {
+            C_blocks.push_back(C.block({i * block_rows, j * block_cols}, {block_rows, block_cols}));
+        }
+    }
+
+    for (const SchemeProduct &product : scheme->products) {
+        MappedMatrix<Scalar> S = out_of_core_combination(product.a, A_blocks, options);
+        MappedMatrix<Scalar> T = out_of_core_combination(product.b, B_blocks, options);
+
+        // P = S T, temporary file is filled with zeros when created
+        MappedMatrix<Scalar> P = MappedMatrix<Scalar>::temporary(block_rows, block_cols, options.temporary_directory);
+        out_of_core_multiply_add(S, T, P, options, level + 1);
+
+        for (unsigned int l = 0; l < product.c.size(); ++l) {
+            if (product.c[l] != 0) {
+                out_of_core_add(C_blocks[l], P, product.c[l], options);
+            }
+        }
+    }
+
+    // dynamic peeling, same three blocks as in dynamic_peeling()
+    const unsigned int included_rows = block_rows * scheme->m,
+            included_inner = block_inner * scheme->k,
+            included_cols = block_cols * scheme->n;
+
+    if (A.cols > included_inner) {
+        MappedMatrix<Scalar> C_block = C.block({0, 0}, {included_rows, included_cols});
+        out_of_core_tiled(A.block({0, included_inner}, {included_rows, A.cols - included_inner}),
+                          B.block({included_inner, 0}, {B.rows - included_inner, included_cols}),
+                          C_block, options);
+    }
+    if (B.cols > included_cols) {
+        MappedMatrix<Scalar> C_block = C.block({0, included_cols}, {C.rows, C.cols - included_cols});
+        out_of_core_tiled(A, B.block({0, included_cols}, {B.rows, B.cols - included_cols}), C_block, options);
+    }
+    if (A.rows > included_rows) {
+        MappedMatrix<Scalar> C_block = C.block({included_rows, 0}, {C.rows - included_rows, included_cols});
+        out_of_core_tiled(A.block({included_rows, 0}, {A.rows - included_rows, A.cols}),
+                          B.block({0, 0}, {B.rows, included_cols}), C_block, options);
+    }
+}
+
+// C = A B for memory mapped matrices, C has to be A.rows x B.cols (its content is overwritten)
+template<class Scalar>
+void multiply_out_of_core(const MappedMatrix<Scalar> &A, const MappedMatrix<Scalar> &B, MappedMatrix<Scalar> &C,
+                          const OutOfCoreOptions &options = OutOfCoreOptions()) {
+    // dimension check
+    assert(A.cols == B.rows && A.rows == C.rows && B.cols == C.cols);
+
+    // clear C, band by band
+    const unsigned int band = out_of_core_band_rows<Scalar>(C.cols, options);
+    for (unsigned int r0 = 0; r0 < C.rows; r0 += band) {
+        C.store({r0, 0}, Matrix<Scalar>::zeros(std::min(band, C.rows - r0), C.cols));
+    }
+
+    out_of_core_multiply_add(A, B, C, options, 0);
+}
+
+// C = A B, result is written to a new file
+template<class Scalar>
+MappedMatrix<Scalar> multiply_out_of_core(const MappedMatrix<Scalar> &A, const MappedMatrix<Scalar> &B,
+                                          const std::string &path,
+                                          const OutOfCoreOptions &options = OutOfCoreOptions()) {
+    MappedMatrix<Scalar> C = MappedMatrix<Scalar>::create(path, A.rows, B.cols);
+    out_of_core_multiply_add(A, B, C, options, 0);
+    return C;
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_MULTIPLY_OUT_OF_CORE_HPP
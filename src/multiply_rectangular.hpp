@@ -0,0 +1,163 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_MULTIPLY_RECTANGULAR_HPP
+#define FAST_MATRIX_MULTIPLICATION_MULTIPLY_RECTANGULAR_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include "dynamic_peeling.hpp"
+#include "matrix.hpp"
+#include "multiply_classic.hpp"
+#include "multiply_strassen.hpp"
+#include "scheme.hpp"
+
+// Exact schemes for rectangular block products, so that strongly rectangular products (for example
+// 20000 x 2000 times 2000 x 500) are split along the dimensions that are actually large.
+//
+// All schemes are compositions of Strassen's <2, 2, 2> scheme and classic products of the remaining
+// blocks: <2, 2, 3>, <2, 3, 2> and <3, 2, 2> need 11 products instead of 12, <2, 2, 4>, <2, 4, 2> and
+// <4, 2, 2> need 14 instead of 16 (two Strassen products side by side) and <3, 2, 3> needs 17 instead of 18.
+// Every level of multiply_rectangular() picks the scheme whose blocks are closest to square.
+
+// scheme for <m, k, n> block product made of Strassen's schemes at blocks (row, inner, col) in
+// `strassen_parts` and classic schemes at blocks (row, inner, col) of shape <m, k, n> in `classic_parts`
+inline Scheme rectangular_compose(unsigned int m, unsigned int k, unsigned int n,
+                                  const std::vector<std::vector<unsigned int>> &strassen_parts,
+                                  const std::vector<std::vector<unsigned int>> &classic_parts) {
+    Scheme scheme = {m, k, n, {}};
+    for (const std::vector<unsigned int> &part : strassen_parts) {
+        scheme_embed(scheme, strassen_scheme(), part[0], part[1], part[2]);
+    }
+    for (const std::vector<unsigned int> &part : classic_parts) {
+        scheme_embed(scheme, classic_scheme(part[3], part[4], part[5]), part[0], part[1], part[2]);
+    }
+    return scheme;
+}
+
+// all rectangular schemes together with Strassen's scheme, candidates for one level of recursion
+inline const std::vector<Scheme> &rectangular_schemes() {
+    static const std::vector<Scheme> schemes = {
+            strassen_scheme(),
+            // <2, 2, 3>: Strassen on first two columns of blocks of C, classic <2, 2, 1> on the last one
+            rectangular_compose(2, 2, 3, {{0, 0, 0}}, {{0, 0, 2, 2, 2, 1}}),
+            // <2, 3, 2>: Strassen on first two blocks of the inner dimension, classic <2, 1, 2> on the last one
+            rectangular_compose(2, 3, 2, {{0, 0, 0}}, {{0, 2, 0, 2, 1, 2}}),
+            // <3, 2, 2>: Strassen on first two rows of blocks of C, classic <1, 2, 2> on the last one
+            rectangular_compose(3, 2, 2, {{0, 0, 0}}, {{2, 0, 0, 1, 2, 2}}),
+            // <2, 2, 4>, <2, 4, 2> and <4, 2, 2>: two Strassen products
+            rectangular_compose(2, 2, 4, {{0, 0, 0}, {0, 0, 2}}, {}),
+            rectangular_compose(2, 4, 2, {{0, 0, 0}, {0, 2, 0}}, {}),
+            rectangular_compose(4, 2, 2, {{0, 0, 0}, {2, 0, 0}}, {}),
+            // <3, 2, 3>: Strassen on top left 2 x 2 blocks of C, classic <2, 2, 1> and <1, 2, 3> on the rest
+            rectangular_compose(3, 2, 3, {{0, 0, 0}}, {{0, 0, 2, 2, 2, 1}, {2, 0, 0, 1, 2, 3}})
+    };
+    return schemes;
+}
+
+// scheme with given shape from rectangular_schemes(), nullptr if there is none
+inline const Scheme *rectangular_scheme(unsigned int m, unsigned int k, unsigned int n) {
+    for (const Scheme &scheme : rectangular_schemes()) {
+        if (scheme.m == m && scheme.k == k && scheme.n == n) {
+            return &scheme;
+        }
+    }
+    return nullptr;
+}
+
+// scheme for one level of product rows x inner x cols: blocks closest to square (smallest ratio of
+// largest and smallest block dimension), ties are broken by fewer products per block product
+inline const Scheme &rectangular_scheme_for(unsigned int rows, unsigned int inner, unsigned int cols) {
+    const Scheme *best = nullptr;
+    double best_ratio = 0, best_cost = 0;
+    for (const Scheme &scheme : rectangular_schemes()) {
+        double block_rows = double(rows) / scheme.m, block_inner = double(inner) / scheme.k,
+                block_cols = double(cols) / scheme.n;
+        double ratio = std::max(block_rows, std::max(block_inner, block_cols)) /
+                       std::max(1.0, std::min(block_rows, std::min(block_inner, block_cols)));
+        // exponent of the scheme, log(rank) / log(number of classic block products)
+        double cost = std::log(double(scheme.rank())) / std::log(double(scheme.m * scheme.k * scheme.n));
+        if (best == nullptr || ratio < best_ratio - 1e-9 || (ratio < best_ratio + 1e-9 && cost < best_cost)) {
+            best = &scheme;
+            best_ratio = ratio;
+            best_cost = cost;
+        }
+    }
+    return *best;
+}
+
+// scheme used by multiply_rectangular() for product rows x inner x cols, nullptr when classic algorithm
+// is used: recursion stops at the same size as Strassen's algorithm, and blocks are never smaller
+// than blocks of Strassen's algorithm at that size
+inline const Scheme *rectangular_choice(unsigned int rows, unsigned int inner, unsigned int cols) {
+    if (std::min(rows, std::min(inner, cols)) <= strassen_threshold) {
+        return nullptr;
+    }
+    const Scheme &scheme = rectangular_scheme_for(rows, inner, cols);
+    const unsigned int smallest_block = std::min(rows / scheme.m, std::min(inner / scheme.k, cols / scheme.n));
+    return smallest_block >= strassen_threshold / 2 ? &scheme : nullptr;
+}
+
+// product A B, every level uses scheme returned by choice(rows, inner, cols) (classic algorithm for nullptr),
+// rows and columns left out by the scheme are added with dynamic peeling
+template<class Scalar, class Choice>
+Matrix<Scalar> multiply_schemes(const Matrix<Scalar> &A, const Matrix<Scalar> &B, Choice choice) {
+    // check dimensions
+    assert(A.cols == B.rows);
+
+    const Scheme *scheme = choice(A.rows, A.cols, B.cols);
+    if (scheme == nullptr) {
+        return multiply_classic(A, B);
+    }
+
+    const unsigned int block_rows = A.rows / scheme->m, block_inner = A.cols / scheme->k,
+            block_cols = B.cols / scheme->n;
+
+    std::vector<Matrix<Scalar>> A_blocks, B_blocks;
+    for (unsigned int i = 0; i < scheme->m; ++i) {
+        for (unsigned int j = 0; j < scheme->k; ++j) {
+            A_blocks.push_back(A.subblock({i * block_rows, j * block_inner}, {block_rows, block_inner}));
+        }
+    }
+    for (unsigned int i = 0; i < scheme->k; ++i) {
+        for (unsigned int j = 0; j < scheme->n; ++j) {
+            B_blocks.push_back(B.subblock({i * block_inner, j * block_cols}, {block_inner, block_cols}));
+        }
+    }
+
+    // rows and columns of C left out by dimensions that are not divisible by the scheme
+    // are calculated meanwhile
+    Matrix<Scalar> C = Matrix<Scalar>::zeros(A.rows, B.cols);
+    TaskGroup peeling;
+    dynamic_peeling_start(A, B, C, scheme->m, scheme->n, peeling);
+
+    Matrix<Scalar> C_blocks = Matrix<Scalar>::zeros(scheme->m * block_rows, scheme->n * block_cols);
+    for (const SchemeProduct &product : scheme->products) {
+        Matrix<Scalar> P = multiply_schemes(scheme_combination(product.a, A_blocks),
+                                            scheme_combination(product.b, B_blocks), choice);
+        scheme_accumulate(product.c, P, C_blocks, block_rows, block_cols, scheme->n);
+    }
+
+    C.block_add({0, 0}, C_blocks);
+
+    // products of inner columns and rows left out by the scheme
+    dynamic_peeling_update(A, B, C, scheme->m, scheme->k, scheme->n);
+    peeling.wait();
+    return C;
+}
+
+// product A B with given scheme on every level, until some dimension is below Strassen's threshold
+template<class Scalar>
+Matrix<Scalar> multiply_scheme(const Matrix<Scalar> &A, const Matrix<Scalar> &B, const Scheme &scheme) {
+    return multiply_schemes(A, B, [&scheme](unsigned int rows, unsigned int inner, unsigned int cols) {
+        return std::min(rows, std::min(inner, cols)) > strassen_threshold &&
+               rows >= scheme.m && inner >= scheme.k && cols >= scheme.n ? &scheme : nullptr;
+    });
+}
+
+// product A B, every level uses the rectangular scheme that fits shape of the product best
+template<class Scalar>
+Matrix<Scalar> multiply_rectangular(const Matrix<Scalar> &A, const Matrix<Scalar> &B) {
+    return multiply_schemes(A, B, rectangular_choice);
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_MULTIPLY_RECTANGULAR_HPP
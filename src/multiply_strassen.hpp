@@ -2,53 +2,192 @@
 #define FAST_MATRIX_MULTIPLICATION_MULTIPLY_STRASSEN_HPP
 
 #include <algorithm>
+#include <type_traits>
+#include <vector>
 #include "matrix.hpp"
 #include "multiply_classic.hpp"
 #include "dynamic_peeling.hpp"
+#include "scheme.hpp"
 
 const unsigned int strassen_threshold = 200;
 
-// finds power of 2 larger (or same as) given value
-unsigned int next_power_of_2(unsigned int value) {
-    unsigned int power = 1;
-    unsigned int n = 2;
+// coefficients of Strassen's algorithm, same products as in strassen() below
+inline const Scheme &strassen_scheme() {
+    static const Scheme scheme = {
+            2, 2, 2, {
+            // P1 = (A11 + A22) (B11 + B22), added to C11, C22
+            {{1, 0, 0, 1}, {1, 0, 0, 1}, {1, 0, 0, 1}},
+            // P2 = (A21 + A22) B11, added to C21, subtracted from C22
+            {{0, 0, 1, 1}, {1, 0, 0, 0}, {0, 0, 1, -1}},
+            // P3 = A11 (B12 - B22), added to C12, C22
+            {{1, 0, 0, 0}, {0, 1, 0, -1}, {0, 1, 0, 1}},
+            // P4 = A22 (-B11 + B21), added to C11, C21
+            {{0, 0, 0, 1}, {-1, 0, 1, 0}, {1, 0, 1, 0}},
+            // P5 = (A11 + A12) B22, subtracted from C11, added to C12
+            {{1, 1, 0, 0}, {0, 0, 0, 1}, {-1, 1, 0, 0}},
+            // P6 = (-A11 + A21) (B11 + B12), added to C22
+            {{-1, 0, 1, 0}, {1, 1, 0, 0}, {0, 0, 0, 1}},
+            // P7 = (A12 - A22) (B21 + B22), added to C11
+            {{0, 1, 0, -1}, {0, 0, 1, 1}, {1, 0, 0, 0}}
+    }};
+    return scheme;
+}
 
-    while (n < value) {
-        power++;
-        n *= 2;
+// matrix of (virtual) size rows x cols, where only top left block `stored` can be nonzero,
+// padding around it is never allocated
+template<class Scalar>
+struct PaddedMatrix {
+    Matrix<Scalar> stored;
+    unsigned int rows, cols;
+
+    // block_size block of this matrix at top_left, only part of it that overlaps stored block is copied
+    PaddedMatrix block(std::pair<unsigned int, unsigned int> top_left,
+                       std::pair<unsigned int, unsigned int> block_size) const {
+        unsigned int stored_rows = top_left.first < stored.rows ?
+                                   std::min(block_size.first, stored.rows - top_left.first) : 0;
+        unsigned int stored_cols = top_left.second < stored.cols ?
+                                   std::min(block_size.second, stored.cols - top_left.second) : 0;
+
+        PaddedMatrix result = {Matrix<Scalar>(), block_size.first, block_size.second};
+        if (stored_rows > 0 && stored_cols > 0) {
+            result.stored = stored.subblock(top_left, {stored_rows, stored_cols});
+        }
+        return result;
+    }
 
-        // otherwise we have too large matrices,
-        // using integers for sizes is not sufficient
-        assert(power < 32);
+    // true if all entries are padding
+    bool is_padding() const {
+        return stored.rows == 0 || stored.cols == 0;
     }
+};
 
-    return n;
+// C[top_left + (i, j)] += coefficient * P[i][j] for the part of P that lies inside C,
+// (parts outside are rows or columns of padding of the product, their total contribution is zero)
+template<class Scalar>
+void padded_accumulate(Matrix<Scalar> &C, std::pair<unsigned int, unsigned int> top_left, const Matrix<Scalar> &P,
+                       int coefficient) {
+    if (top_left.first >= C.rows || top_left.second >= C.cols) {
+        return;
+    }
+    unsigned int rows = std::min(P.rows, C.rows - top_left.first), cols = std::min(P.cols, C.cols - top_left.second);
+    for (unsigned int i = 0; i < rows; ++i) {
+        Scalar *row_C = C.data.data() + std::size_t(top_left.first + i) * C.cols + top_left.second;
+        const Scalar *row_P = P.data.data() + std::size_t(i) * P.cols;
+        for (unsigned int j = 0; j < cols; ++j) {
+            if (coefficient == 1) {
+                row_C[j] += row_P[j];
+            } else if (coefficient == -1) {
+                row_C[j] -= row_P[j];
+            } else {
+                row_C[j] += Scalar(coefficient) * row_P[j];
+            }
+        }
+    }
 }
 
-// strassen multiply using static padding:
-// resize matrices A and B to the next power of 2
+// sum coefficients[i] * blocks[i], stored block of the sum is the smallest block that contains all used ones
 template<class Scalar>
-Matrix<Scalar> multiply_strassen_static(const Matrix<Scalar> &A, const Matrix<Scalar> &B) {
-    // dimension check
-    assert(A.cols == B.rows);
+PaddedMatrix<Scalar> padded_combination(const std::vector<int> &coefficients,
+                                        const std::vector<PaddedMatrix<Scalar>> &blocks) {
+    unsigned int stored_rows = 0, stored_cols = 0;
+    for (unsigned int i = 0; i < coefficients.size(); ++i) {
+        if (coefficients[i] != 0 && !blocks[i].is_padding()) {
+            stored_rows = std::max(stored_rows, blocks[i].stored.rows);
+            stored_cols = std::max(stored_cols, blocks[i].stored.cols);
+        }
+    }
+
+    PaddedMatrix<Scalar> sum = {Matrix<Scalar>::zeros(stored_rows, stored_cols), blocks[0].rows, blocks[0].cols};
+    for (unsigned int i = 0; i < coefficients.size(); ++i) {
+        if (coefficients[i] != 0 && !blocks[i].is_padding()) {
+            padded_accumulate(sum.stored, {0, 0}, blocks[i].stored, coefficients[i]);
+        }
+    }
+    return sum;
+}
+
+// product of padded matrices with `depth` levels of Strassen's algorithm,
+// all dimensions are divisible by 2^depth, products with a block that is only padding are skipped
+template<class Scalar>
+PaddedMatrix<Scalar> padded_strassen(const PaddedMatrix<Scalar> &A, const PaddedMatrix<Scalar> &B,
+                                     unsigned int depth) {
+    PaddedMatrix<Scalar> C = {Matrix<Scalar>(), A.rows, B.cols};
+    if (A.is_padding() || B.is_padding()) {
+        return C;
+    }
+    C.stored = Matrix<Scalar>::zeros(A.stored.rows, B.stored.cols);
+
+    if (depth == 0) {
+        // entries of A after its stored columns and of B after its stored rows are zeros
+        unsigned int inner = std::min(A.stored.cols, B.stored.rows);
+        classic_kernel(C.stored.rows, C.stored.cols, inner, A.stored.data.data(), A.stored.cols, Op::none,
+                       B.stored.data.data(), B.stored.cols, Op::none, C.stored.data.data(), C.stored.cols);
+        return C;
+    }
+
+    const Scheme &scheme = strassen_scheme();
+    const unsigned int block_rows = A.rows / 2, block_inner = A.cols / 2, block_cols = B.cols / 2;
+
+    std::vector<PaddedMatrix<Scalar>> A_blocks, B_blocks;
+    for (unsigned int i = 0; i < 2; ++i) {
+        for (unsigned int j = 0; j < 2; ++j) {
+            A_blocks.push_back(A.block({i * block_rows, j * block_inner}, {block_rows, block_inner}));
+            B_blocks.push_back(B.block({i * block_inner, j * block_cols}, {block_inner, block_cols}));
+        }
+    }
 
-    // fill matrices A and B to both be squares with sizes powers of 2.
-    unsigned int n = next_power_of_2(std::max(A.rows, std::max(B.cols, B.rows)));
+    for (const SchemeProduct &product : scheme.products) {
+        PaddedMatrix<Scalar> left = padded_combination(product.a, A_blocks);
+        PaddedMatrix<Scalar> right = padded_combination(product.b, B_blocks);
+        if (left.is_padding() || right.is_padding()) {
+            continue;
+        }
+
+        PaddedMatrix<Scalar> P = padded_strassen(left, right, depth - 1);
+        for (unsigned int l = 0; l < product.c.size(); ++l) {
+            if (product.c[l] != 0 && !P.is_padding()) {
+                padded_accumulate(C.stored, {(l / 2) * block_rows, (l % 2) * block_cols}, P.stored, product.c[l]);
+            }
+        }
+    }
+    return C;
+}
 
-    // create new large enough matrices
-    Matrix<Scalar> new_A = Matrix<Scalar>::zeros(n, n);
-    Matrix<Scalar> new_B = Matrix<Scalar>::zeros(n, n);
+// strassen multiply using static padding, calculates op(A) op(B):
+// recursion has fixed depth (same as dynamic peeling would use for the smallest dimension), every dimension
+// is padded to a multiple of 2^depth, so leaf blocks are at most as large as with dynamic peeling
+// padding is virtual, blocks and sums of blocks only store their part inside the matrix
+template<class Scalar>
+Matrix<Scalar> multiply_strassen_static(const Matrix<Scalar> &A, const Matrix<Scalar> &B,
+                                        Op op_A = Op::none, Op op_B = Op::none) {
+    // dimensions of op(A) and op(B)
+    unsigned int rows_A = op_rows(A, op_A),
+            cols_A = op_cols(A, op_A),
+            rows_B = op_rows(B, op_B),
+            cols_B = op_cols(B, op_B);
+
+    // dimension check
+    assert(cols_A == rows_B);
+
+    unsigned int depth = 0;
+    for (unsigned int min_size = std::min(rows_A, std::min(cols_A, cols_B)); min_size > strassen_threshold;
+         min_size /= 2) {
+        depth++;
+    }
 
-    // fill new matrix with values from A
-    new_A.block_add({0, 0}, A);
-    // fill new matrix with values from B
-    new_B.block_add({0, 0}, B);
+    // virtual dimensions are rounded up to a multiple of 2^depth
+    auto padded = [depth](unsigned int size) {
+        return ((size + (1u << depth) - 1) >> depth) << depth;
+    };
 
-    // actual multiplication
-    Matrix<Scalar> product = strassen(new_A, new_B);
+    PaddedMatrix<Scalar> padded_A = {A.subblock({0, 0}, {rows_A, cols_A}, op_A), padded(rows_A), padded(cols_A)};
+    PaddedMatrix<Scalar> padded_B = {B.subblock({0, 0}, {rows_B, cols_B}, op_B), padded(rows_B), padded(cols_B)};
 
-    // return correct subblock (crop zeros)
-    return product.subblock({0, 0}, {A.rows, B.cols});
+    PaddedMatrix<Scalar> product = padded_strassen(padded_A, padded_B, depth);
+    if (product.is_padding()) {
+        return Matrix<Scalar>::zeros(rows_A, cols_B);
+    }
+    return product.stored;
 }
 
 // actual strassen multiplication
@@ -129,15 +268,23 @@ Matrix<Scalar> strassen(const Matrix<Scalar> &A, const Matrix<Scalar> &B) {
     return C;
 }
 
-// strassen using dynamic peeling
+// strassen using dynamic peeling, calculates op(A) op(B)
+// (transposed operands are transposed while subblocks are copied, recursive calls work on plain blocks)
 template<class Scalar>
-Matrix<Scalar> multiply_strassen_dynamic(const Matrix<Scalar> &A, const Matrix<Scalar> &B) {
+Matrix<Scalar> multiply_strassen_dynamic(const Matrix<Scalar> &A, const Matrix<Scalar> &B,
+                                         Op op_A = Op::none, Op op_B = Op::none) {
+    // dimensions of op(A) and op(B)
+    unsigned int rows_A = op_rows(A, op_A),
+            cols_A = op_cols(A, op_A),
+            rows_B = op_rows(B, op_B),
+            cols_B = op_cols(B, op_B);
+
     // dimension check
-    assert(A.cols == B.rows);
+    assert(cols_A == rows_B);
 
     // if any of the dimensions is too small, strassen's algorithm wont help
-    if (std::min(A.rows, std::min(A.cols, B.cols)) <= strassen_threshold) {
-        return multiply_classic(A, B);
+    if (std::min(rows_A, std::min(cols_A, cols_B)) <= strassen_threshold) {
+        return multiply_classic(A, B, op_A, op_B);
     }
 
     // split into subblocks:
@@ -145,22 +292,26 @@ Matrix<Scalar> multiply_strassen_dynamic(const Matrix<Scalar> &A, const Matrix<S
     // if dimensions are odd, round matrix size down, do a normal strassen algorithm for smaller matrix and perform
     // dynamic peeling after this step finishes
     std::pair<unsigned int, unsigned int>
-            block_A = {A.rows / 2, A.cols / 2},
-            block_B = {B.rows / 2, B.cols / 2},
-            product_block = {A.rows / 2, B.cols / 2};
+            block_A = {rows_A / 2, cols_A / 2},
+            block_B = {rows_B / 2, cols_B / 2},
+            product_block = {rows_A / 2, cols_B / 2};
 
-    Matrix<Scalar> A11 = A.subblock({0, 0}, block_A),
-            A12 = A.subblock({0, A.cols / 2}, block_A),
-            A21 = A.subblock({A.rows / 2, 0}, block_A),
-            A22 = A.subblock({A.rows / 2, A.cols / 2}, block_A);
+    Matrix<Scalar> A11 = A.subblock({0, 0}, block_A, op_A),
+            A12 = A.subblock({0, cols_A / 2}, block_A, op_A),
+            A21 = A.subblock({rows_A / 2, 0}, block_A, op_A),
+            A22 = A.subblock({rows_A / 2, cols_A / 2}, block_A, op_A);
 
-    Matrix<Scalar> B11 = B.subblock({0, 0}, block_B),
-            B12 = B.subblock({0, B.cols / 2}, block_B),
-            B21 = B.subblock({B.rows / 2, 0}, block_B),
-            B22 = B.subblock({B.rows / 2, B.cols / 2}, block_B);
+    Matrix<Scalar> B11 = B.subblock({0, 0}, block_B, op_B),
+            B12 = B.subblock({0, cols_B / 2}, block_B, op_B),
+            B21 = B.subblock({rows_B / 2, 0}, block_B, op_B),
+            B22 = B.subblock({rows_B / 2, cols_B / 2}, block_B, op_B);
 
     // create larger matrix for result
-    Matrix<Scalar> C = Matrix<Scalar>::zeros(A.rows, B.cols);
+    Matrix<Scalar> C = Matrix<Scalar>::zeros(rows_A, cols_B);
+
+    // remaining rows and columns of C (if dimensions are odd) are calculated meanwhile
+    TaskGroup peeling;
+    dynamic_peeling_start(A, B, C, 2, 2, peeling, op_A, op_B);
 
     // temporary matrix, here we will store products
     Matrix<Scalar> P;
@@ -205,12 +356,35 @@ Matrix<Scalar> multiply_strassen_dynamic(const Matrix<Scalar> &A, const Matrix<S
     // add P7 to C11
     C.block_add({0, 0}, P);
 
-    // fix remaining row and column if dimensions are odd
-    dynamic_peeling(A, B, C, 2, 2, 2);
+    // add products of remaining inner column and row if dimensions are odd
+    dynamic_peeling_update(A, B, C, 2, 2, 2, op_A, op_B);
+    peeling.wait();
 
     return C;
 
 }
 
 
+// strassen over a semiring, Strassen's algorithm subtracts products, so semirings without subtraction
+// (like MinPlus) are rejected at compile time; blocks are added and multiplied with operations of the scalar
+// type itself, so the only ring accepted is ordinary arithmetic
+template<class Scalar, class Semiring>
+Matrix<Scalar> multiply_strassen_dynamic(const Matrix<Scalar> &A, const Matrix<Scalar> &B, const Semiring &,
+                                         Op op_A = Op::none, Op op_B = Op::none) {
+    static_assert(Semiring::has_subtraction, "Strassen's algorithm needs a semiring with subtraction");
+    static_assert(std::is_same<Semiring, PlusTimes<Scalar>>::value,
+                  "Strassen's algorithm uses arithmetic of the scalar type, other rings are not supported");
+    return multiply_strassen_dynamic(A, B, op_A, op_B);
+}
+
+// same as above, for static padding
+template<class Scalar, class Semiring>
+Matrix<Scalar> multiply_strassen_static(const Matrix<Scalar> &A, const Matrix<Scalar> &B, const Semiring &,
+                                        Op op_A = Op::none, Op op_B = Op::none) {
+    static_assert(Semiring::has_subtraction, "Strassen's algorithm needs a semiring with subtraction");
+    static_assert(std::is_same<Semiring, PlusTimes<Scalar>>::value,
+                  "Strassen's algorithm uses arithmetic of the scalar type, other rings are not supported");
+    return multiply_strassen_static(A, B, op_A, op_B);
+}
+
 #endif //FAST_MATRIX_MULTIPLICATION_MULTIPLY_STRASSEN_HPP
@@ -0,0 +1,389 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_NUMA_HPP
+#define FAST_MATRIX_MULTIPLICATION_NUMA_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "dynamic_peeling.hpp"
+#include "matrix.hpp"
+#include "multiply_strassen.hpp"
+#include "scheme.hpp"
+#include "thread_pool.hpp"
+
+// NUMA-aware placement of matrices and threads.
+//
+// On machines with several memory nodes, memory is placed on the node of the thread that first touches it,
+// and every access from another node is slower. Topology (CPUs of each node) is read from
+// /sys/devices/system/node, threads are bound to CPUs with pthread_setaffinity_np() and memory policies
+// are set with mbind() and set_mempolicy() system calls, so no external library is needed.
+// On machines without NUMA (or where these calls are not allowed) everything still works, only without
+// placement.
+//
+// multiply_strassen_numa() makes top levels of Strassen's algorithm in parallel: workers are ordered node
+// by node, every product gets a contiguous range of workers (so usually workers of one node), and the thread
+// that multiplies it first builds its sums of blocks itself. Operands and temporaries of each product are
+// therefore first touched, and placed, on the node that uses them, only sums of blocks read remote memory.
+// Workers are threads of their own (not of the shared ThreadPool), because every one of them is bound to its
+// CPU and has its own memory policy; algorithms they call use a pool with one worker, so the leaves of
+// the recursion run in the worker itself instead of on unpinned threads of the shared pool.
+
+// memory policies of Linux (linux/mempolicy.h)
+const int numa_policy_default = 0;
+const int numa_policy_bind = 2;
+const int numa_policy_interleave = 3;
+// mbind() flag that moves pages that are already allocated
+const unsigned int numa_move_pages = 1u << 1;
+
+// CPU numbers in format of /sys (and taskset), for example "0-3,8,10-11"
+inline std::vector<unsigned int> parse_cpu_list(const std::string &list) {
+    std::vector<unsigned int> cpus;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.find_first_of("0123456789") == std::string::npos) {
+            continue;
+        }
+        std::size_t dash = range.find('-');
+        unsigned int first = std::stoul(range.substr(0, dash));
+        unsigned int last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+        for (unsigned int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// memory nodes and their CPUs (only CPUs this process may run on)
+struct NumaTopology {
+    // node numbers used by the kernel
+    std::vector<unsigned int> nodes;
+    // cpus[i] are CPUs of nodes[i]
+    std::vector<std::vector<unsigned int>> cpus;
+
+    // total number of CPUs
+    unsigned int cpu_count() const {
+        unsigned int count = 0;
+        for (const std::vector<unsigned int> &node_cpus : cpus) {
+            count += node_cpus.size();
+        }
+        return count;
+    }
+
+    // CPUs ordered node by node, with the node (index into nodes) of every CPU
+    std::vector<std::pair<unsigned int, unsigned int>> ordered_cpus() const {
+        std::vector<std::pair<unsigned int, unsigned int>> ordered;
+        for (unsigned int i = 0; i < nodes.size(); ++i) {
+            for (unsigned int cpu : cpus[i]) {
+                ordered.push_back({cpu, i});
+            }
+        }
+        return ordered;
+    }
+
+    // topology from given directory (in format of /sys/devices/system/node), if there are no nodes,
+    // all CPUs of this process are in one node 0
+    static NumaTopology detect(const std::string &directory = "/sys/devices/system/node") {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        bool restricted = ::sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+        auto usable = [&](unsigned int cpu) {
+            return !restricted || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed));
+        };
+
+        NumaTopology topology;
+        std::vector<unsigned int> online;
+        std::ifstream online_file(directory + "/online");
+        std::string line;
+        if (online_file && std::getline(online_file, line)) {
+            online = parse_cpu_list(line);
+        }
+        for (unsigned int node : online) {
+            std::ifstream cpu_file(directory + "/node" + std::to_string(node) + "/cpulist");
+            std::vector<unsigned int> node_cpus;
+            if (cpu_file && std::getline(cpu_file, line)) {
+                for (unsigned int cpu : parse_cpu_list(line)) {
+                    if (usable(cpu)) {
+                        node_cpus.push_back(cpu);
+                    }
+                }
+            }
+            // nodes with memory only have no CPUs to run workers on
+            if (!node_cpus.empty()) {
+                topology.nodes.push_back(node);
+                topology.cpus.push_back(node_cpus);
+            }
+        }
+
+        if (topology.nodes.empty()) {
+            std::vector<unsigned int> all_cpus;
+            unsigned int count = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned int cpu = 0; all_cpus.size() < count && cpu < CPU_SETSIZE; ++cpu) {
+                if (usable(cpu)) {
+                    all_cpus.push_back(cpu);
+                }
+            }
+            topology.nodes.push_back(0);
+            topology.cpus.push_back(all_cpus);
+        }
+        return topology;
+    }
+};
+
+// binds calling thread to given CPUs, returns false if that is not possible
+inline bool numa_pin_thread(const std::vector<unsigned int> &cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (unsigned int cpu : cpus) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+}
+
+// bit mask of given nodes, in format of mbind() and set_mempolicy()
+inline std::vector<unsigned long> numa_node_mask(const std::vector<unsigned int> &nodes) {
+    const unsigned int bits = 8 * sizeof(unsigned long);
+    unsigned int max_node = nodes.empty() ? 0 : *std::max_element(nodes.begin(), nodes.end());
+    std::vector<unsigned long> mask(max_node / bits + 1, 0);
+    for (unsigned int node : nodes) {
+        mask[node / bits] |= 1ul << (node % bits);
+    }
+    return mask;
+}
+
+// sets memory policy of pages from begin to end (only whole pages inside this range are affected),
+// pages that were already allocated are moved, returns false if policy can not be set
+inline bool numa_bind_memory(const void *begin, const void *end, int policy, const std::vector<unsigned int> &nodes) {
+    const std::uintptr_t page = ::sysconf(_SC_PAGESIZE);
+    std::uintptr_t first = (reinterpret_cast<std::uintptr_t>(begin) + page - 1) / page * page;
+    std::uintptr_t last = reinterpret_cast<std::uintptr_t>(end) / page * page;
+    if (first >= last) {
+        return true;
+    }
+
+    std::vector<unsigned long> mask = numa_node_mask(nodes);
+    // kernel reads max_node - 1 bits
+    unsigned long max_node = 8 * sizeof(unsigned long) * mask.size() + 1;
+    return ::syscall(SYS_mbind, first, last - first, policy, mask.data(), max_node, numa_move_pages) == 0;
+}
+
+// memory policy of pages that calling thread allocates later
+inline bool numa_thread_policy(int policy, const std::vector<unsigned int> &nodes) {
+    if (policy == numa_policy_default) {
+        return ::syscall(SYS_set_mempolicy, policy, nullptr, 0) == 0;
+    }
+    std::vector<unsigned long> mask = numa_node_mask(nodes);
+    unsigned long max_node = 8 * sizeof(unsigned long) * mask.size() + 1;
+    return ::syscall(SYS_set_mempolicy, policy, mask.data(), max_node) == 0;
+}
+
+// how memory of matrices (and temporaries of parallel products) is placed on nodes
+enum class NumaPlacement {
+    // pages are on the node of the thread that uses them (matrices: bands of rows, one band per node)
+    local,
+    // pages are spread over all nodes round-robin
+    interleaved
+};
+
+// Memory policy set by mbind() stays on the address range, also after the memory is freed. Smaller
+// allocations of malloc() come from the heap (or an arena) and their addresses are reused by unrelated
+// allocations later, so only buffers malloc() always maps separately (at least its largest mmap threshold,
+// 32 MB on 64-bit glibc) are placed, and their range is unmapped when they are freed.
+const std::size_t numa_min_placed_bytes = std::size_t(4 * 1024 * 1024) * sizeof(long);
+
+// places pages of rows x cols row-major matrix at `begin`: rows are split into one band per node,
+// or pages are interleaved over all nodes, returns false if placement is not supported
+// or the matrix is smaller than numa_min_placed_bytes (it stays where it was first touched)
+template<class Scalar>
+bool numa_place_rows(const Scalar *begin, unsigned int rows, unsigned int cols, const NumaTopology &topology,
+                     NumaPlacement placement) {
+    if (std::size_t(rows) * cols * sizeof(Scalar) < numa_min_placed_bytes) {
+        return false;
+    }
+
+    if (placement == NumaPlacement::interleaved) {
+        return numa_bind_memory(begin, begin + std::size_t(rows) * cols, numa_policy_interleave, topology.nodes);
+    }
+
+    const unsigned int nodes = topology.nodes.size();
+    bool placed = true;
+    for (unsigned int i = 0; i < nodes; ++i) {
+        std::size_t first_row = std::size_t(rows) * i / nodes, last_row = std::size_t(rows) * (i + 1) / nodes;
+        placed &= numa_bind_memory(begin + first_row * cols, begin + last_row * cols, numa_policy_bind,
+                                   {topology.nodes[i]});
+    }
+    return placed;
+}
+
+// moves pages of existing matrix
+template<class Scalar>
+bool numa_place(Matrix<Scalar> &A, const NumaTopology &topology, NumaPlacement placement) {
+    return numa_place_rows(A.data.data(), A.rows, A.cols, topology, placement);
+}
+
+// rows x cols zero matrix whose memory is placed before it is filled, so every band of rows ends up
+// where it would be if a thread of its node touched it first (or pages are interleaved),
+// matrices smaller than numa_min_placed_bytes are on the node of the calling thread
+template<class Scalar>
+Matrix<Scalar> numa_zeros(unsigned int rows, unsigned int cols, const NumaTopology &topology,
+                          NumaPlacement placement = NumaPlacement::local) {
+    Matrix<Scalar> A;
+    A.rows = rows;
+    A.cols = cols;
+    // reserved memory is not touched yet
+    A.data.reserve(std::size_t(rows) * cols);
+    numa_place_rows(A.data.data(), rows, cols, topology, placement);
+    A.data.resize(std::size_t(rows) * cols, Scalar(0));
+    return A;
+}
+
+struct NumaOptions {
+    // number of worker threads, 0 means one per CPU
+    unsigned int threads = 0;
+    // where temporaries of workers are placed
+    NumaPlacement placement = NumaPlacement::local;
+    // bind every worker to its CPU
+    bool pin = true;
+};
+
+// worker threads first, ..., first + count - 1 (indices into ordered CPUs)
+typedef std::pair<unsigned int, unsigned int> NumaWorkers;
+
+// binds calling thread to CPU of a worker (cpu, index of its node) and sets policy for its allocations
+inline void numa_prepare_worker(std::pair<unsigned int, unsigned int> cpu, const NumaTopology &topology,
+                                const NumaOptions &options) {
+    if (options.pin) {
+        numa_pin_thread({cpu.first});
+    }
+    if (options.placement == NumaPlacement::interleaved) {
+        numa_thread_policy(numa_policy_interleave, topology.nodes);
+    } else {
+        // pages are allocated on the node of the thread that touches them first
+        numa_thread_policy(numa_policy_default, {});
+    }
+}
+
+// sum += coefficient * block
+template<class Scalar>
+void numa_add_block(Matrix<Scalar> &sum, int coefficient, const Matrix<Scalar> &block) {
+    if (coefficient == 1) {
+        sum += block;
+    } else if (coefficient == -1) {
+        sum -= block;
+    } else if (coefficient != 0) {
+        sum += Scalar(coefficient) * block;
+    }
+}
+
+// product A B calculated by given workers, called from the (prepared) thread of the first worker,
+// products of single workers use `leaves` (a pool with one worker, so they run in the thread of the worker)
+template<class Scalar>
+Matrix<Scalar> numa_strassen(const Matrix<Scalar> &A, const Matrix<Scalar> &B, NumaWorkers workers,
+                             const std::vector<std::pair<unsigned int, unsigned int>> &cpus,
+                             const NumaTopology &topology, const NumaOptions &options, ThreadPool &leaves) {
+    if (workers.second == 1 || std::min(A.rows, std::min(A.cols, B.cols)) <= strassen_threshold) {
+        return multiply_strassen_dynamic(A, B);
+    }
+
+    const Scheme &scheme = strassen_scheme();
+    const unsigned int block_rows = A.rows / 2, block_inner = A.cols / 2, block_cols = B.cols / 2;
+
+    // at most 7 groups of (almost) the same number of workers, product r is multiplied by group r % groups
+    const unsigned int groups = std::min(scheme.rank(), workers.second);
+    std::vector<NumaWorkers> group_workers;
+    for (unsigned int g = 0, first = workers.first; g < groups; ++g) {
+        unsigned int count = workers.second / groups + (g < workers.second % groups ? 1 : 0);
+        group_workers.push_back({first, count});
+        first += count;
+    }
+
+    // every group builds sums of blocks in its own thread, so they are placed on its node,
+    // group 0 continues in this thread
+    auto multiply_products = [&](unsigned int g) {
+        const NumaWorkers &group = group_workers[g];
+        ThreadPoolScope scope(leaves);
+        if (g != 0) {
+            numa_prepare_worker(cpus[group.first], topology, options);
+        }
+        std::vector<Matrix<Scalar>> products;
+        for (unsigned int r = g; r < scheme.rank(); r += groups) {
+            const SchemeProduct &product = scheme.products[r];
+            Matrix<Scalar> left = Matrix<Scalar>::zeros(block_rows, block_inner);
+            Matrix<Scalar> right = Matrix<Scalar>::zeros(block_inner, block_cols);
+            for (unsigned int l = 0; l < 4; ++l) {
+                std::pair<unsigned int, unsigned int> A_corner = {(l / 2) * block_rows, (l % 2) * block_inner},
+                        B_corner = {(l / 2) * block_inner, (l % 2) * block_cols};
+                // only blocks that are used are copied
+                if (product.a[l] != 0) {
+                    numa_add_block(left, product.a[l], A.subblock(A_corner, {block_rows, block_inner}));
+                }
+                if (product.b[l] != 0) {
+                    numa_add_block(right, product.b[l], B.subblock(B_corner, {block_inner, block_cols}));
+                }
+            }
+            products.push_back(numa_strassen(left, right, group, cpus, topology, options, leaves));
+        }
+        return products;
+    };
+
+    std::vector<std::future<std::vector<Matrix<Scalar>>>> futures;
+    for (unsigned int g = 1; g < groups; ++g) {
+        futures.push_back(std::async(std::launch::async, multiply_products, g));
+    }
+
+    Matrix<Scalar> C_blocks = Matrix<Scalar>::zeros(2 * block_rows, 2 * block_cols);
+    for (unsigned int g = 0; g < groups; ++g) {
+        std::vector<Matrix<Scalar>> products = g == 0 ? multiply_products(0) : futures[g - 1].get();
+        for (unsigned int r = g, i = 0; r < scheme.rank(); r += groups, ++i) {
+            scheme_accumulate(scheme.products[r].c, products[i], C_blocks, block_rows, block_cols, scheme.n);
+        }
+    }
+
+    Matrix<Scalar> C = Matrix<Scalar>::zeros(A.rows, B.cols);
+    C.block_add({0, 0}, C_blocks);
+
+    // rows and columns left out by odd dimensions
+    dynamic_peeling(A, B, C, 2, 2, 2);
+    return C;
+}
+
+// product A B with Strassen's algorithm on worker threads placed on NUMA nodes (see above),
+// workers are new threads, so binding and memory policy of calling thread do not change
+template<class Scalar>
+Matrix<Scalar> multiply_strassen_numa(const Matrix<Scalar> &A, const Matrix<Scalar> &B,
+                                      const NumaTopology &topology = NumaTopology::detect(),
+                                      const NumaOptions &options = NumaOptions()) {
+    // check dimensions
+    assert(A.cols == B.rows);
+
+    std::vector<std::pair<unsigned int, unsigned int>> cpus = topology.ordered_cpus();
+    unsigned int threads = options.threads == 0 ? cpus.size() : options.threads;
+    // more workers than CPUs share CPUs in the same order
+    while (cpus.size() < threads) {
+        cpus.push_back(cpus[cpus.size() % topology.cpu_count()]);
+    }
+
+    // classic products at the leaves run in the (pinned) threads of workers, not in unpinned workers
+    // of the default pool
+    ThreadPool leaves(1);
+    return std::async(std::launch::async, [&]() {
+        ThreadPoolScope scope(leaves);
+        numa_prepare_worker(cpus[0], topology, options);
+        return numa_strassen(A, B, {0, threads}, cpus, topology, options, leaves);
+    }).get();
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_NUMA_HPP
@@ -0,0 +1,184 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_PACKED_OPERAND_HPP
+#define FAST_MATRIX_MULTIPLICATION_PACKED_OPERAND_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+#include "algorithm.hpp"
+#include "matrix.hpp"
+#include "multiply_classic.hpp"
+#include "scheme.hpp"
+#include "thread_pool.hpp"
+
+// Right operand prepared once for many products A B with the same B (for example weights of a layer
+// multiplied by many batches of inputs).
+//
+// pack_operand() follows the recursion of the chosen algorithm for products of `rows` x B and stores,
+// for every product of every level, the linear combination of blocks of B the algorithm would calculate
+// (so B11 + B22, B12 - B22, ... of Strassen's algorithm are calculated only once), and at the leaves of
+// the recursion the combinations split into panels of classic_block_inner x classic_block_cols that are
+// stored one after another, so the classic kernel reads them contiguously. Products with packed operands
+// then only split and combine blocks of A.
+//
+// Rows of A do not have to match `rows` (it only decides the recursion plan): rows of A that do not
+// divide into blocks are padded with zeros, so the plan depends only on B. Columns and rows of B left out
+// by a scheme are stored separately and multiplied classically (as dynamic peeling does).
+// For Strassen's algorithm, a packed operand with d levels uses about (7/4)^d times memory of B.
+
+template<class Scalar>
+struct PackedOperand {
+    // dimensions of op(B)
+    unsigned int rows = 0, cols = 0;
+    // scheme of this level, nullptr at leaves of recursion
+    const Scheme *scheme = nullptr;
+    // leaves: panels of op(B), blocks of inner dimension in order, each split in blocks of columns
+    std::vector<Scalar> panels;
+    // other levels: packed combinations of blocks of B, one for every product of the scheme
+    std::vector<PackedOperand<Scalar>> products;
+    // other levels: columns of op(B) after the last full block column, and rows of op(B) after the last
+    // full block row (only in full block columns)
+    Matrix<Scalar> peeled_cols, peeled_rows;
+
+    // number of stored elements (memory used by the packed operand)
+    std::size_t size() const {
+        std::size_t total = panels.size() + peeled_cols.data.size() + peeled_rows.data.size();
+        for (const PackedOperand<Scalar> &product : products) {
+            total += product.size();
+        }
+        return total;
+    }
+};
+
+// packs B (already with op applied) for products with `rows` x B.rows matrices
+template<class Scalar>
+PackedOperand<Scalar> packed_level(const Matrix<Scalar> &B, Algorithm algorithm, unsigned int rows) {
+    PackedOperand<Scalar> packed;
+    packed.rows = B.rows;
+    packed.cols = B.cols;
+    packed.scheme = algorithm_recursion_scheme(algorithm, rows, B.rows, B.cols);
+
+    if (packed.scheme == nullptr) {
+        // panels in the order classic_kernel() visits them
+        packed.panels.reserve(std::size_t(B.rows) * B.cols);
+        for (unsigned int k0 = 0; k0 < B.rows; k0 += classic_block_inner) {
+            const unsigned int block_inner = std::min(classic_block_inner, B.rows - k0);
+            for (unsigned int j0 = 0; j0 < B.cols; j0 += classic_block_cols) {
+                const unsigned int block_cols = std::min(classic_block_cols, B.cols - j0);
+                for (unsigned int k = 0; k < block_inner; ++k) {
+                    const Scalar *row = B.data.data() + std::size_t(k0 + k) * B.cols + j0;
+                    packed.panels.insert(packed.panels.end(), row, row + block_cols);
+                }
+            }
+        }
+        return packed;
+    }
+
+    const Scheme &scheme = *packed.scheme;
+    const unsigned int block_inner = B.rows / scheme.k, block_cols = B.cols / scheme.n;
+    const unsigned int included_inner = block_inner * scheme.k, included_cols = block_cols * scheme.n;
+
+    std::vector<Matrix<Scalar>> B_blocks;
+    for (unsigned int i = 0; i < scheme.k; ++i) {
+        for (unsigned int j = 0; j < scheme.n; ++j) {
+            B_blocks.push_back(B.subblock({i * block_inner, j * block_cols}, {block_inner, block_cols}));
+        }
+    }
+
+    // blocks of A will have rows / m rows, rounded up
+    const unsigned int block_rows = (rows + scheme.m - 1) / scheme.m;
+    for (const SchemeProduct &product : scheme.products) {
+        packed.products.push_back(packed_level(scheme_combination(product.b, B_blocks), algorithm, block_rows));
+    }
+
+    packed.peeled_cols = B.subblock({0, included_cols}, {B.rows, B.cols - included_cols});
+    packed.peeled_rows = B.subblock({included_inner, 0}, {B.rows - included_inner, included_cols});
+    return packed;
+}
+
+// op(B) packed for products A op(B) with chosen algorithm, where A has about `rows` rows
+template<class Scalar>
+PackedOperand<Scalar> pack_operand(const Matrix<Scalar> &B, Algorithm algorithm, unsigned int rows,
+                                   Op op_B = Op::none) {
+    return packed_level(B.subblock({0, 0}, {op_rows(B, op_B), op_cols(B, op_B)}, op_B), algorithm, rows);
+}
+
+// product A B with packed operand B
+template<class Scalar>
+Matrix<Scalar> multiply_packed(const Matrix<Scalar> &A, const PackedOperand<Scalar> &B) {
+    // check dimensions
+    assert(A.cols == B.rows);
+
+    Matrix<Scalar> C = Matrix<Scalar>::zeros(A.rows, B.cols);
+    if (A.rows == 0) {
+        return C;
+    }
+
+    if (B.scheme == nullptr) {
+        // same loops as classic_kernel(), with panels of B read one after another,
+        // bands of rows of A are multiplied by threads of the pool (all of them share the panels)
+        const unsigned int band = classic_parallel_rows(A.rows, B.cols, B.rows);
+        parallel_for(0, A.rows, band, [&](unsigned int first, unsigned int last) {
+            const Scalar *panel = B.panels.data();
+            for (unsigned int k0 = 0; k0 < B.rows; k0 += classic_block_inner) {
+                const unsigned int block_inner = std::min(classic_block_inner, B.rows - k0);
+                for (unsigned int j0 = 0; j0 < B.cols; j0 += classic_block_cols) {
+                    const unsigned int block_cols = std::min(classic_block_cols, B.cols - j0);
+                    classic_block_kernel(last - first, block_cols, block_inner,
+                                         A.data.data() + std::size_t(first) * A.cols + k0, A.cols, panel, block_cols,
+                                         C.data.data() + std::size_t(first) * C.cols + j0, C.cols);
+                    panel += std::size_t(block_inner) * block_cols;
+                }
+            }
+        });
+        return C;
+    }
+
+    const Scheme &scheme = *B.scheme;
+    const unsigned int block_rows = (A.rows + scheme.m - 1) / scheme.m, block_inner = B.rows / scheme.k,
+            block_cols = B.cols / scheme.n;
+    const unsigned int included_inner = block_inner * scheme.k, included_cols = block_cols * scheme.n;
+
+    // blocks of A, rows after the last row of A are zeros
+    std::vector<Matrix<Scalar>> A_blocks;
+    for (unsigned int i = 0; i < scheme.m; ++i) {
+        for (unsigned int j = 0; j < scheme.k; ++j) {
+            Matrix<Scalar> block = Matrix<Scalar>::zeros(block_rows, block_inner);
+            const unsigned int first = std::min(A.rows, i * block_rows),
+                    stored_rows = std::min(A.rows, first + block_rows) - first;
+            for (unsigned int r = 0; r < stored_rows; ++r) {
+                const Scalar *row = A.data.data() + std::size_t(first + r) * A.cols + j * block_inner;
+                std::copy(row, row + block_inner, block.data.data() + std::size_t(r) * block_inner);
+            }
+            A_blocks.push_back(std::move(block));
+        }
+    }
+
+    Matrix<Scalar> C_blocks = Matrix<Scalar>::zeros(scheme.m * block_rows, scheme.n * block_cols);
+    for (unsigned int r = 0; r < scheme.rank(); ++r) {
+        const SchemeProduct &product = scheme.products[r];
+        Matrix<Scalar> P = multiply_packed(scheme_combination(product.a, A_blocks), B.products[r]);
+        scheme_accumulate(product.c, P, C_blocks, block_rows, block_cols, scheme.n);
+    }
+
+    // rows of padding are dropped
+    for (unsigned int i = 0; i < A.rows; ++i) {
+        const Scalar *row = C_blocks.data.data() + std::size_t(i) * C_blocks.cols;
+        std::copy(row, row + included_cols, C.data.data() + std::size_t(i) * C.cols);
+    }
+
+    // columns and inner rows of B left out by the scheme
+    if (B.cols > included_cols) {
+        classic_kernel_parallel(A.rows, B.cols - included_cols, A.cols, A.data.data(), A.cols, Op::none,
+                                B.peeled_cols.data.data(), B.peeled_cols.cols, Op::none,
+                                C.data.data() + included_cols, C.cols);
+    }
+    if (B.rows > included_inner && included_cols > 0) {
+        classic_kernel_parallel(A.rows, included_cols, B.rows - included_inner, A.data.data() + included_inner,
+                                A.cols, Op::none, B.peeled_rows.data.data(), B.peeled_rows.cols, Op::none,
+                                C.data.data(), C.cols);
+    }
+    return C;
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_PACKED_OPERAND_HPP
@@ -0,0 +1,145 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_SCHEME_HPP
+#define FAST_MATRIX_MULTIPLICATION_SCHEME_HPP
+
+#include <cassert>
+#include <vector>
+#include "matrix.hpp"
+
+// Fast algorithms (Strassen, Laderman, ...) are bilinear algorithms: to multiply A and B, split A in
+// m x k blocks and B in k x n blocks, multiply some linear combinations of blocks, and add
+// products to blocks of C. Scheme describes such an algorithm with tables of coefficients,
+// so the same algorithm can be reused on blocks that are not Matrix objects (for example on disk).
+
+// one block multiplication of a scheme:
+// P = (sum a[i] A_i) (sum b[j] B_j), then C_l += c[l] P
+// blocks are numbered row by row, for example A_1 is A12 and B_(k + 1) is B21
+struct SchemeProduct {
+    std::vector<int> a, b, c;
+};
+
+// bilinear algorithm for <m, k, n> block product, number of products is its rank
+struct Scheme {
+    unsigned int m, k, n;
+    std::vector<SchemeProduct> products;
+
+    unsigned int rank() const {
+        return products.size();
+    }
+};
+
+// sum coefficients[i] * blocks[i] of in-memory blocks (all blocks have the same size)
+template<class Scalar>
+Matrix<Scalar> scheme_combination(const std::vector<int> &coefficients, const std::vector<Matrix<Scalar>> &blocks) {
+    assert(coefficients.size() == blocks.size());
+
+    Matrix<Scalar> sum = Matrix<Scalar>::zeros(blocks[0].rows, blocks[0].cols);
+    for (unsigned int i = 0; i < coefficients.size(); ++i) {
+        if (coefficients[i] == 1) {
+            sum += blocks[i];
+        } else if (coefficients[i] == -1) {
+            sum -= blocks[i];
+        } else if (coefficients[i] != 0) {
+            sum += Scalar(coefficients[i]) * blocks[i];
+        }
+    }
+    return sum;
+}
+
+// C_l += coefficients[l] * P for all blocks of C, blocks of C are block_rows x block_cols
+// and there are n of them in each row
+template<class Scalar>
+void scheme_accumulate(const std::vector<int> &coefficients, const Matrix<Scalar> &P, Matrix<Scalar> &C,
+                       unsigned int block_rows, unsigned int block_cols, unsigned int n) {
+    for (unsigned int l = 0; l < coefficients.size(); ++l) {
+        std::pair<unsigned int, unsigned int> top_left = {(l / n) * block_rows, (l % n) * block_cols};
+        if (coefficients[l] == 1) {
+            C.block_add(top_left, P);
+        } else if (coefficients[l] == -1) {
+            C.block_subtract(top_left, P);
+        } else if (coefficients[l] != 0) {
+            C.block_add(top_left, Scalar(coefficients[l]) * P);
+        }
+    }
+}
+
+// classic <m, k, n> algorithm as a scheme: one product A_ip B_pj for every block of C
+inline Scheme classic_scheme(unsigned int m, unsigned int k, unsigned int n) {
+    Scheme scheme = {m, k, n, {}};
+    for (unsigned int i = 0; i < m; ++i) {
+        for (unsigned int j = 0; j < n; ++j) {
+            for (unsigned int p = 0; p < k; ++p) {
+                SchemeProduct product = {std::vector<int>(m * k, 0), std::vector<int>(k * n, 0),
+                                         std::vector<int>(m * n, 0)};
+                product.a[i * k + p] = 1;
+                product.b[p * n + j] = 1;
+                product.c[i * n + j] = 1;
+                scheme.products.push_back(product);
+            }
+        }
+    }
+    return scheme;
+}
+
+// adds products of `source` to `target`, blocks of source are blocks of target starting at block row
+// `row`, block `inner` of the inner dimension and block column `col` (used to compose larger schemes)
+inline void scheme_embed(Scheme &target, const Scheme &source, unsigned int row, unsigned int inner,
+                         unsigned int col) {
+    assert(row + source.m <= target.m && inner + source.k <= target.k && col + source.n <= target.n);
+
+    for (const SchemeProduct &product : source.products) {
+        SchemeProduct embedded = {std::vector<int>(target.m * target.k, 0),
+                                  std::vector<int>(target.k * target.n, 0),
+                                  std::vector<int>(target.m * target.n, 0)};
+        for (unsigned int i = 0; i < source.m; ++i) {
+            for (unsigned int p = 0; p < source.k; ++p) {
+                embedded.a[(row + i) * target.k + inner + p] = product.a[i * source.k + p];
+            }
+        }
+        for (unsigned int p = 0; p < source.k; ++p) {
+            for (unsigned int j = 0; j < source.n; ++j) {
+                embedded.b[(inner + p) * target.n + col + j] = product.b[p * source.n + j];
+            }
+        }
+        for (unsigned int i = 0; i < source.m; ++i) {
+            for (unsigned int j = 0; j < source.n; ++j) {
+                embedded.c[(row + i) * target.n + col + j] = product.c[i * source.n + j];
+            }
+        }
+        target.products.push_back(embedded);
+    }
+}
+
+// checks that scheme calculates the exact product (Brent equations): coefficient of A_ip B_qj in C_uv,
+// summed over all products, has to be 1 if i = u, p = q and j = v, and 0 otherwise
+inline bool verify_scheme(const Scheme &scheme) {
+    const unsigned int m = scheme.m, k = scheme.k, n = scheme.n;
+    for (const SchemeProduct &product : scheme.products) {
+        if (product.a.size() != m * k || product.b.size() != k * n || product.c.size() != m * n) {
+            return false;
+        }
+    }
+
+    for (unsigned int i = 0; i < m; ++i) {
+        for (unsigned int p = 0; p < k; ++p) {
+            for (unsigned int q = 0; q < k; ++q) {
+                for (unsigned int j = 0; j < n; ++j) {
+                    for (unsigned int u = 0; u < m; ++u) {
+                        for (unsigned int v = 0; v < n; ++v) {
+                            long long sum = 0;
+                            for (const SchemeProduct &product : scheme.products) {
+                                sum += static_cast<long long>(product.a[i * k + p]) * product.b[q * n + j] *
+                                       product.c[u * n + v];
+                            }
+                            if (sum != (i == u && p == q && j == v ? 1 : 0)) {
+                                return false;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_SCHEME_HPP
@@ -0,0 +1,71 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_SEMIRING_HPP
+#define FAST_MATRIX_MULTIPLICATION_SEMIRING_HPP
+
+#include <algorithm>
+#include <limits>
+
+// Semirings in which matrix products can be calculated. A product over semiring is
+//     c_ij = a_i1 * b_1j + a_i2 * b_2j + ... + a_ik * b_kj,
+// where + is add() and * is multiply() of the semiring, and empty sum is zero().
+// Semirings are passed to products as policy objects, for example multiply_classic(A, B, MinPlus<double>()).
+// Fast algorithms (Strassen, Laderman, ...) also subtract, so they can only be used with semirings
+// that have subtraction (rings), this is checked at compile time with has_subtraction. They calculate
+// with operators of the scalar type, so of the rings they accept only ordinary arithmetic (PlusTimes).
+
+// ordinary arithmetic
+template<class Scalar>
+struct PlusTimes {
+    static const bool has_subtraction = true;
+
+    static Scalar zero() { return Scalar(0); }
+
+    static Scalar add(const Scalar &a, const Scalar &b) { return a + b; }
+
+    static Scalar multiply(const Scalar &a, const Scalar &b) { return a * b; }
+};
+
+// infinity of a semiring with min or max as addition, floating point types have a true infinity,
+// integer types use their largest (lowest) value, which is kept by multiplication (see tropical_multiply())
+template<class Scalar>
+Scalar tropical_infinity() {
+    return std::numeric_limits<Scalar>::has_infinity ? std::numeric_limits<Scalar>::infinity()
+                                                     : std::numeric_limits<Scalar>::max();
+}
+
+// a + b where infinite (zero of semiring) operand gives zero, so integers do not overflow
+template<class Scalar>
+Scalar tropical_multiply(const Scalar &a, const Scalar &b, const Scalar &zero) {
+    if (!std::numeric_limits<Scalar>::has_infinity && (a == zero || b == zero)) {
+        return zero;
+    }
+    return a + b;
+}
+
+// tropical (min, +) semiring: c_ij = min_k (a_ik + b_kj), for example shortest paths
+template<class Scalar>
+struct MinPlus {
+    static const bool has_subtraction = false;
+
+    static Scalar zero() { return tropical_infinity<Scalar>(); }
+
+    static Scalar add(const Scalar &a, const Scalar &b) { return std::min(a, b); }
+
+    static Scalar multiply(const Scalar &a, const Scalar &b) { return tropical_multiply(a, b, zero()); }
+};
+
+// (max, +) semiring: c_ij = max_k (a_ik + b_kj), for example longest paths and scheduling
+template<class Scalar>
+struct MaxPlus {
+    static const bool has_subtraction = false;
+
+    static Scalar zero() {
+        return std::numeric_limits<Scalar>::has_infinity ? -std::numeric_limits<Scalar>::infinity()
+                                                         : std::numeric_limits<Scalar>::lowest();
+    }
+
+    static Scalar add(const Scalar &a, const Scalar &b) { return std::max(a, b); }
+
+    static Scalar multiply(const Scalar &a, const Scalar &b) { return tropical_multiply(a, b, zero()); }
+};
+
+#endif //FAST_MATRIX_MULTIPLICATION_SEMIRING_HPP
@@ -0,0 +1,209 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_SIMD_HPP
+#define FAST_MATRIX_MULTIPLICATION_SIMD_HPP
+
+// Thin wrappers around SIMD registers of floats and doubles, so kernels can be written once for both types.
+// Widest instruction set enabled at compile time is used (AVX-512, AVX with FMA, AVX or SSE2).
+// FAST_MATRIX_MULTIPLICATION_SIMD is defined if any of them is available.
+//
+// Simd and kernels written with it are compiled differently for every instruction set, so they are declared
+// in an inline namespace named after it (FAST_MATRIX_MULTIPLICATION_ISA_NAMESPACE). Translation units built
+// with different flags (like kernels of the compiled library, see kernels.cpp) then never share and mix up
+// their instantiations, and code that uses them does not need to name the namespace.
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FAST_MATRIX_MULTIPLICATION_SIMD
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define FAST_MATRIX_MULTIPLICATION_SIMD
+#endif
+
+#if defined(__AVX512F__)
+#define FAST_MATRIX_MULTIPLICATION_ISA_NAMESPACE isa_avx512
+#elif defined(__AVX2__) && defined(__FMA__)
+#define FAST_MATRIX_MULTIPLICATION_ISA_NAMESPACE isa_avx2
+#elif defined(__AVX__)
+#define FAST_MATRIX_MULTIPLICATION_ISA_NAMESPACE isa_avx
+#elif defined(__SSE2__)
+#define FAST_MATRIX_MULTIPLICATION_ISA_NAMESPACE isa_sse2
+#else
+#define FAST_MATRIX_MULTIPLICATION_ISA_NAMESPACE isa_generic
+#endif
+
+#ifdef FAST_MATRIX_MULTIPLICATION_SIMD
+
+inline namespace FAST_MATRIX_MULTIPLICATION_ISA_NAMESPACE {
+
+template<class Scalar>
+struct Simd;
+
+#if defined(__AVX512F__)
+
+template<>
+struct Simd<float> {
+    typedef __m512 Vector;
+    static const unsigned int width = 16;
+
+    static Vector zero() { return _mm512_setzero_ps(); }
+
+    static Vector broadcast(float a) { return _mm512_set1_ps(a); }
+
+    static Vector load(const float *p) { return _mm512_loadu_ps(p); }
+
+    static void store(float *p, Vector a) { _mm512_storeu_ps(p, a); }
+
+    static Vector add(Vector a, Vector b) { return _mm512_add_ps(a, b); }
+
+    static Vector min(Vector a, Vector b) { return _mm512_min_ps(a, b); }
+
+    static Vector max(Vector a, Vector b) { return _mm512_max_ps(a, b); }
+
+    // a b + c
+    static Vector multiply_add(Vector a, Vector b, Vector c) { return _mm512_fmadd_ps(a, b, c); }
+};
+
+template<>
+struct Simd<double> {
+    typedef __m512d Vector;
+    static const unsigned int width = 8;
+
+    static Vector zero() { return _mm512_setzero_pd(); }
+
+    static Vector broadcast(double a) { return _mm512_set1_pd(a); }
+
+    static Vector load(const double *p) { return _mm512_loadu_pd(p); }
+
+    static void store(double *p, Vector a) { _mm512_storeu_pd(p, a); }
+
+    static Vector add(Vector a, Vector b) { return _mm512_add_pd(a, b); }
+
+    static Vector min(Vector a, Vector b) { return _mm512_min_pd(a, b); }
+
+    static Vector max(Vector a, Vector b) { return _mm512_max_pd(a, b); }
+
+    static Vector multiply_add(Vector a, Vector b, Vector c) { return _mm512_fmadd_pd(a, b, c); }
+
+    // eight floats converted to doubles
+    static Vector load_float(const float *p) { return _mm512_cvtps_pd(_mm256_loadu_ps(p)); }
+};
+
+#elif defined(__AVX__)
+
+template<>
+struct Simd<float> {
+    typedef __m256 Vector;
+    static const unsigned int width = 8;
+
+    static Vector zero() { return _mm256_setzero_ps(); }
+
+    static Vector broadcast(float a) { return _mm256_set1_ps(a); }
+
+    static Vector load(const float *p) { return _mm256_loadu_ps(p); }
+
+    static void store(float *p, Vector a) { _mm256_storeu_ps(p, a); }
+
+    static Vector add(Vector a, Vector b) { return _mm256_add_ps(a, b); }
+
+    static Vector min(Vector a, Vector b) { return _mm256_min_ps(a, b); }
+
+    static Vector max(Vector a, Vector b) { return _mm256_max_ps(a, b); }
+
+    // a b + c
+    static Vector multiply_add(Vector a, Vector b, Vector c) {
+#ifdef __FMA__
+        return _mm256_fmadd_ps(a, b, c);
+#else
+        return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+    }
+};
+
+template<>
+struct Simd<double> {
+    typedef __m256d Vector;
+    static const unsigned int width = 4;
+
+    static Vector zero() { return _mm256_setzero_pd(); }
+
+    static Vector broadcast(double a) { return _mm256_set1_pd(a); }
+
+    static Vector load(const double *p) { return _mm256_loadu_pd(p); }
+
+    static void store(double *p, Vector a) { _mm256_storeu_pd(p, a); }
+
+    static Vector add(Vector a, Vector b) { return _mm256_add_pd(a, b); }
+
+    static Vector min(Vector a, Vector b) { return _mm256_min_pd(a, b); }
+
+    static Vector max(Vector a, Vector b) { return _mm256_max_pd(a, b); }
+
+    static Vector multiply_add(Vector a, Vector b, Vector c) {
+#ifdef __FMA__
+        return _mm256_fmadd_pd(a, b, c);
+#else
+        return _mm256_add_pd(_mm256_mul_pd(a, b), c);
+#endif
+    }
+
+    // four floats converted to doubles
+    static Vector load_float(const float *p) { return _mm256_cvtps_pd(_mm_loadu_ps(p)); }
+};
+
+#else
+
+template<>
+struct Simd<float> {
+    typedef __m128 Vector;
+    static const unsigned int width = 4;
+
+    static Vector zero() { return _mm_setzero_ps(); }
+
+    static Vector broadcast(float a) { return _mm_set1_ps(a); }
+
+    static Vector load(const float *p) { return _mm_loadu_ps(p); }
+
+    static void store(float *p, Vector a) { _mm_storeu_ps(p, a); }
+
+    static Vector add(Vector a, Vector b) { return _mm_add_ps(a, b); }
+
+    static Vector min(Vector a, Vector b) { return _mm_min_ps(a, b); }
+
+    static Vector max(Vector a, Vector b) { return _mm_max_ps(a, b); }
+
+    static Vector multiply_add(Vector a, Vector b, Vector c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+};
+
+template<>
+struct Simd<double> {
+    typedef __m128d Vector;
+    static const unsigned int width = 2;
+
+    static Vector zero() { return _mm_setzero_pd(); }
+
+    static Vector broadcast(double a) { return _mm_set1_pd(a); }
+
+    static Vector load(const double *p) { return _mm_loadu_pd(p); }
+
+    static void store(double *p, Vector a) { _mm_storeu_pd(p, a); }
+
+    static Vector add(Vector a, Vector b) { return _mm_add_pd(a, b); }
+
+    static Vector min(Vector a, Vector b) { return _mm_min_pd(a, b); }
+
+    static Vector max(Vector a, Vector b) { return _mm_max_pd(a, b); }
+
+    static Vector multiply_add(Vector a, Vector b, Vector c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+
+    // two floats converted to doubles
+    static Vector load_float(const float *p) {
+        return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p))));
+    }
+};
+
+#endif
+
+} // inline namespace FAST_MATRIX_MULTIPLICATION_ISA_NAMESPACE
+
+#endif
+
+#endif //FAST_MATRIX_MULTIPLICATION_SIMD_HPP
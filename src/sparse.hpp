@@ -0,0 +1,397 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_SPARSE_HPP
+#define FAST_MATRIX_MULTIPLICATION_SPARSE_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+#include "matrix.hpp"
+#include "dynamic_peeling.hpp"
+#include "multiply_classic.hpp"
+#include "multiply_strassen.hpp"
+#include "scheme.hpp"
+
+// Products of matrices with many zeros.
+//
+// CsrMatrix stores only nonzero entries, row by row (compressed sparse rows). Sparse times dense product
+// (SpMM) adds a multiple of a row of B for every nonzero of A, sparse times sparse product (SpGEMM) uses
+// Gustavson's algorithm with one dense accumulator row. BlockSparseMatrix keeps dense square blocks and
+// leaves out blocks that are zero, its product multiplies only pairs of nonzero blocks.
+//
+// multiply_sparse_aware() works on ordinary matrices: it measures density of both operands and uses
+// a sparse kernel when one of them is sparse enough, otherwise it makes one step of Strassen's algorithm
+// and decides again for every product of blocks. Products with a zero block are skipped.
+
+// operands with at most this fraction of nonzero entries are multiplied by sparse kernels
+// (sparse times dense kernel is faster than Strassen on 1000 x 1000 doubles up to density of about 0.4)
+const double sparse_density_threshold = 0.25;
+
+// number of nonzero entries
+template<class Scalar>
+std::size_t matrix_nonzeros(const Matrix<Scalar> &A) {
+    std::size_t count = 0;
+    for (const Scalar &value : A.data) {
+        if (value != Scalar(0)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// fraction of nonzero entries (empty matrix has density 0)
+template<class Scalar>
+double matrix_density(const Matrix<Scalar> &A) {
+    return A.data.empty() ? 0.0 : double(matrix_nonzeros(A)) / A.data.size();
+}
+
+template<class Scalar>
+class CsrMatrix {
+public:
+    // number of rows in this matrix
+    unsigned int rows;
+    // number of columns in this matrix
+    unsigned int cols;
+
+    // entries of i-th row are at positions row_start[i] to row_start[i + 1] - 1 (rows + 1 values)
+    std::vector<unsigned int> row_start;
+    // column of every stored entry, increasing within each row
+    std::vector<unsigned int> col_index;
+    // value of every stored entry
+    std::vector<Scalar> values;
+
+    // default constructor is empty matrix
+    CsrMatrix() : rows(0), cols(0), row_start(1, 0) {}
+
+    // rows x cols matrix without nonzero entries
+    CsrMatrix(unsigned int _rows, unsigned int _cols) : rows(_rows), cols(_cols), row_start(_rows + 1, 0) {}
+
+    // nonzero entries of dense matrix
+    static CsrMatrix from_matrix(const Matrix<Scalar> &A) {
+        CsrMatrix sparse(A.rows, A.cols);
+        for (unsigned int i = 0; i < A.rows; ++i) {
+            for (unsigned int j = 0; j < A.cols; ++j) {
+                const Scalar &value = A.data[std::size_t(i) * A.cols + j];
+                if (value != Scalar(0)) {
+                    sparse.col_index.push_back(j);
+                    sparse.values.push_back(value);
+                }
+            }
+            sparse.row_start[i + 1] = sparse.values.size();
+        }
+        return sparse;
+    }
+
+    // dense matrix with the same entries
+    Matrix<Scalar> to_matrix() const {
+        Matrix<Scalar> A = Matrix<Scalar>::zeros(rows, cols);
+        for (unsigned int i = 0; i < rows; ++i) {
+            for (unsigned int e = row_start[i]; e < row_start[i + 1]; ++e) {
+                A.data[std::size_t(i) * cols + col_index[e]] = values[e];
+            }
+        }
+        return A;
+    }
+
+    // number of stored entries
+    std::size_t nonzeros() const {
+        return values.size();
+    }
+
+    // fraction of stored entries
+    double density() const {
+        return rows == 0 || cols == 0 ? 0.0 : double(values.size()) / (double(rows) * cols);
+    }
+};
+
+// C += A B, where A is sparse and B, C are row-major with given strides, B has `cols` columns
+template<class Scalar>
+void sparse_dense_kernel(const CsrMatrix<Scalar> &A, unsigned int cols, const Scalar *B, unsigned int ldb,
+                         Scalar *C, unsigned int ldc) {
+    for (unsigned int i = 0; i < A.rows; ++i) {
+        Scalar *row_C = C + std::size_t(i) * ldc;
+        for (unsigned int e = A.row_start[i]; e < A.row_start[i + 1]; ++e) {
+            const Scalar a = A.values[e];
+            const Scalar *row_B = B + std::size_t(A.col_index[e]) * ldb;
+            for (unsigned int j = 0; j < cols; ++j) {
+                row_C[j] += a * row_B[j];
+            }
+        }
+    }
+}
+
+// C += A B, where B is sparse and A, C are row-major with given strides, A has A_rows rows
+template<class Scalar>
+void dense_sparse_kernel(unsigned int A_rows, const Scalar *A, unsigned int lda, const CsrMatrix<Scalar> &B,
+                         Scalar *C, unsigned int ldc) {
+    for (unsigned int i = 0; i < A_rows; ++i) {
+        Scalar *row_C = C + std::size_t(i) * ldc;
+        for (unsigned int k = 0; k < B.rows; ++k) {
+            const Scalar a = A[std::size_t(i) * lda + k];
+            if (a == Scalar(0)) {
+                continue;
+            }
+            for (unsigned int e = B.row_start[k]; e < B.row_start[k + 1]; ++e) {
+                row_C[B.col_index[e]] += a * B.values[e];
+            }
+        }
+    }
+}
+
+// product of sparse A and dense B
+template<class Scalar>
+Matrix<Scalar> multiply_sparse_dense(const CsrMatrix<Scalar> &A, const Matrix<Scalar> &B) {
+    // check dimensions
+    assert(A.cols == B.rows);
+
+    Matrix<Scalar> C = Matrix<Scalar>::zeros(A.rows, B.cols);
+    sparse_dense_kernel(A, B.cols, B.data.data(), B.cols, C.data.data(), C.cols);
+    return C;
+}
+
+// product of dense A and sparse B
+template<class Scalar>
+Matrix<Scalar> multiply_dense_sparse(const Matrix<Scalar> &A, const CsrMatrix<Scalar> &B) {
+    // check dimensions
+    assert(A.cols == B.rows);
+
+    Matrix<Scalar> C = Matrix<Scalar>::zeros(A.rows, B.cols);
+    dense_sparse_kernel(A.rows, A.data.data(), A.cols, B, C.data.data(), C.cols);
+    return C;
+}
+
+// product of two sparse matrices with Gustavson's algorithm: row i of C is the sum of rows k of B
+// multiplied by a_ik, collected in a dense row, entries that cancel out are not stored
+template<class Scalar>
+CsrMatrix<Scalar> multiply_sparse(const CsrMatrix<Scalar> &A, const CsrMatrix<Scalar> &B) {
+    // check dimensions
+    assert(A.cols == B.rows);
+
+    CsrMatrix<Scalar> C(A.rows, B.cols);
+    std::vector<Scalar> accumulator(B.cols, Scalar(0));
+    // occupied[j] is set if column j of current row was reached, those columns are listed in `columns`
+    std::vector<char> occupied(B.cols, 0);
+    std::vector<unsigned int> columns;
+
+    for (unsigned int i = 0; i < A.rows; ++i) {
+        for (unsigned int e = A.row_start[i]; e < A.row_start[i + 1]; ++e) {
+            const Scalar a = A.values[e];
+            const unsigned int k = A.col_index[e];
+            for (unsigned int f = B.row_start[k]; f < B.row_start[k + 1]; ++f) {
+                const unsigned int j = B.col_index[f];
+                if (!occupied[j]) {
+                    occupied[j] = 1;
+                    columns.push_back(j);
+                }
+                accumulator[j] += a * B.values[f];
+            }
+        }
+
+        // columns of every row are stored in increasing order
+        std::sort(columns.begin(), columns.end());
+        for (unsigned int j : columns) {
+            if (accumulator[j] != Scalar(0)) {
+                C.col_index.push_back(j);
+                C.values.push_back(accumulator[j]);
+            }
+            accumulator[j] = Scalar(0);
+            occupied[j] = 0;
+        }
+        columns.clear();
+        C.row_start[i + 1] = C.values.size();
+    }
+    return C;
+}
+
+// matrix split into square blocks (blocks in last row and column may be smaller),
+// only blocks with a nonzero entry are stored
+template<class Scalar>
+class BlockSparseMatrix {
+public:
+    // number of rows in this matrix
+    unsigned int rows;
+    // number of columns in this matrix
+    unsigned int cols;
+    // rows and columns of full blocks
+    unsigned int block_size;
+
+    BlockSparseMatrix(unsigned int _rows, unsigned int _cols, unsigned int _block_size)
+            : rows(_rows), cols(_cols), block_size(_block_size),
+              blocks(std::size_t(block_count(_rows, _block_size)) * block_count(_cols, _block_size)) {
+        assert(block_size > 0);
+    }
+
+    // blocks of dense matrix, zero blocks are left out
+    static BlockSparseMatrix from_matrix(const Matrix<Scalar> &A, unsigned int block_size) {
+        BlockSparseMatrix sparse(A.rows, A.cols, block_size);
+        for (unsigned int i = 0; i < sparse.block_rows(); ++i) {
+            for (unsigned int j = 0; j < sparse.block_cols(); ++j) {
+                Matrix<Scalar> block = A.subblock({i * block_size, j * block_size},
+                                                  {sparse.block_height(i), sparse.block_width(j)});
+                if (!block.is_zero()) {
+                    sparse.blocks[std::size_t(i) * sparse.block_cols() + j] = std::move(block);
+                }
+            }
+        }
+        return sparse;
+    }
+
+    // dense matrix with the same entries
+    Matrix<Scalar> to_matrix() const {
+        Matrix<Scalar> A = Matrix<Scalar>::zeros(rows, cols);
+        for (unsigned int i = 0; i < block_rows(); ++i) {
+            for (unsigned int j = 0; j < block_cols(); ++j) {
+                if (has_block(i, j)) {
+                    A.block_add({i * block_size, j * block_size}, block(i, j));
+                }
+            }
+        }
+        return A;
+    }
+
+    // number of blocks in each column and row
+    unsigned int block_rows() const {
+        return block_count(rows, block_size);
+    }
+
+    unsigned int block_cols() const {
+        return block_count(cols, block_size);
+    }
+
+    // rows of i-th row of blocks and columns of j-th column of blocks
+    unsigned int block_height(unsigned int i) const {
+        return std::min(block_size, rows - i * block_size);
+    }
+
+    unsigned int block_width(unsigned int j) const {
+        return std::min(block_size, cols - j * block_size);
+    }
+
+    // false if block (i, j) is zero and not stored
+    bool has_block(unsigned int i, unsigned int j) const {
+        return !blocks[std::size_t(i) * block_cols() + j].data.empty();
+    }
+
+    const Matrix<Scalar> &block(unsigned int i, unsigned int j) const {
+        assert(has_block(i, j));
+        return blocks[std::size_t(i) * block_cols() + j];
+    }
+
+    // block (i, j), zero block is allocated if it was not stored
+    Matrix<Scalar> &block(unsigned int i, unsigned int j) {
+        Matrix<Scalar> &stored = blocks[std::size_t(i) * block_cols() + j];
+        if (stored.data.empty()) {
+            stored = Matrix<Scalar>::zeros(block_height(i), block_width(j));
+        }
+        return stored;
+    }
+
+    // number of stored blocks
+    std::size_t nonzero_blocks() const {
+        return std::count_if(blocks.begin(), blocks.end(),
+                             [](const Matrix<Scalar> &stored) { return !stored.data.empty(); });
+    }
+
+private:
+    // blocks row by row, zero blocks are empty matrices
+    std::vector<Matrix<Scalar>> blocks;
+
+    static unsigned int block_count(unsigned int size, unsigned int block_size) {
+        return (size + block_size - 1) / block_size;
+    }
+};
+
+// product of block sparse matrices with the same block size, only pairs of nonzero blocks are multiplied
+template<class Scalar>
+BlockSparseMatrix<Scalar> multiply_block_sparse(const BlockSparseMatrix<Scalar> &A,
+                                                const BlockSparseMatrix<Scalar> &B) {
+    // check dimensions
+    assert(A.cols == B.rows && A.block_size == B.block_size);
+
+    BlockSparseMatrix<Scalar> C(A.rows, B.cols, A.block_size);
+    for (unsigned int i = 0; i < A.block_rows(); ++i) {
+        for (unsigned int k = 0; k < A.block_cols(); ++k) {
+            if (!A.has_block(i, k)) {
+                continue;
+            }
+            const Matrix<Scalar> &A_ik = A.block(i, k);
+            for (unsigned int j = 0; j < B.block_cols(); ++j) {
+                if (!B.has_block(k, j)) {
+                    continue;
+                }
+                const Matrix<Scalar> &B_kj = B.block(k, j);
+                Matrix<Scalar> &C_ij = C.block(i, j);
+                classic_kernel(C_ij.rows, C_ij.cols, A_ik.cols, A_ik.data.data(), A_ik.cols, Op::none,
+                               B_kj.data.data(), B_kj.cols, Op::none, C_ij.data.data(), C_ij.cols);
+            }
+        }
+    }
+    return C;
+}
+
+// C += A B, sparse operands go to sparse kernels, dense operands make one step of Strassen's algorithm
+// and every product of blocks is routed again, products with a zero block are skipped
+template<class Scalar>
+void sparse_aware_multiply(const Matrix<Scalar> &A, const Matrix<Scalar> &B, Matrix<Scalar> &C) {
+    const double density_A = matrix_density(A), density_B = matrix_density(B);
+
+    if (density_A == 0 || density_B == 0) {
+        return;
+    }
+    if (std::min(density_A, density_B) <= sparse_density_threshold) {
+        // sparser operand is compressed, so fewer products are made
+        if (density_A <= density_B) {
+            sparse_dense_kernel(CsrMatrix<Scalar>::from_matrix(A), B.cols, B.data.data(), B.cols,
+                                C.data.data(), C.cols);
+        } else {
+            dense_sparse_kernel(A.rows, A.data.data(), A.cols, CsrMatrix<Scalar>::from_matrix(B),
+                                C.data.data(), C.cols);
+        }
+        return;
+    }
+    if (std::min(A.rows, std::min(A.cols, B.cols)) <= strassen_threshold) {
+        classic_kernel(C.rows, C.cols, A.cols, A.data.data(), A.cols, Op::none, B.data.data(), B.cols, Op::none,
+                       C.data.data(), C.cols);
+        return;
+    }
+
+    const Scheme &scheme = strassen_scheme();
+    const unsigned int block_rows = A.rows / 2, block_inner = A.cols / 2, block_cols = B.cols / 2;
+
+    std::vector<Matrix<Scalar>> A_blocks, B_blocks;
+    for (unsigned int i = 0; i < 2; ++i) {
+        for (unsigned int j = 0; j < 2; ++j) {
+            A_blocks.push_back(A.subblock({i * block_rows, j * block_inner}, {block_rows, block_inner}));
+            B_blocks.push_back(B.subblock({i * block_inner, j * block_cols}, {block_inner, block_cols}));
+        }
+    }
+
+    Matrix<Scalar> C_blocks = Matrix<Scalar>::zeros(2 * block_rows, 2 * block_cols);
+    for (const SchemeProduct &product : scheme.products) {
+        Matrix<Scalar> left = scheme_combination(product.a, A_blocks);
+        Matrix<Scalar> right = scheme_combination(product.b, B_blocks);
+        if (left.is_zero() || right.is_zero()) {
+            continue;
+        }
+
+        Matrix<Scalar> P = Matrix<Scalar>::zeros(block_rows, block_cols);
+        sparse_aware_multiply(left, right, P);
+        scheme_accumulate(product.c, P, C_blocks, block_rows, block_cols, scheme.n);
+    }
+    C.block_add({0, 0}, C_blocks);
+
+    // rows and columns left out by odd dimensions
+    dynamic_peeling(A, B, C, 2, 2, 2);
+}
+
+// product A B, each operand (and each product of blocks in Strassen's recursion) is multiplied by
+// a sparse kernel if at most sparse_density_threshold of its entries are nonzero
+template<class Scalar>
+Matrix<Scalar> multiply_sparse_aware(const Matrix<Scalar> &A, const Matrix<Scalar> &B) {
+    // check dimensions
+    assert(A.cols == B.rows);
+
+    Matrix<Scalar> C = Matrix<Scalar>::zeros(A.rows, B.cols);
+    sparse_aware_multiply(A, B, C);
+    return C;
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_SPARSE_HPP
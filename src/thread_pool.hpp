@@ -0,0 +1,470 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_THREAD_POOL_HPP
+#define FAST_MATRIX_MULTIPLICATION_THREAD_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool shared by all parallel algorithms of the library.
+//
+// Every worker has its own lock-free deque (Chase-Lev): the worker pushes and pops tasks at the bottom,
+// other threads steal the oldest tasks from the top. Tasks submitted from outside the pool go to a shared
+// queue. Parallel work is expressed with TaskGroup (fork-join: run() tasks, then wait() for all of them)
+// and parallel_for(). A thread that waits for a group runs other tasks of the pool meanwhile, so nested
+// recursive tasks never block workers and never need more threads.
+//
+// Algorithms use default_thread_pool(): the pool of the innermost ThreadPoolScope of the calling thread,
+// otherwise in a worker of a pool that pool (so nested work stays in it), otherwise the pool installed
+// with set_default_thread_pool(), or a pool with one worker per hardware thread.
+
+// task of a pool, deleted after it is run
+struct PoolTask {
+    std::function<void()> function;
+};
+
+// Chase-Lev deque of tasks (Le, Pop, Cohen, Zappa Nardelli: Correct and Efficient Work-Stealing for
+// Weak Memory Models), push() and pop() are called only by the owner, steal() by any thread
+class WorkStealingDeque {
+public:
+    explicit WorkStealingDeque(std::int64_t capacity = 256) {
+        arrays.push_back(std::unique_ptr<Array>(new Array(capacity)));
+        array.store(arrays.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque &) = delete;
+
+    WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+    void push(PoolTask *task) {
+        std::int64_t b = bottom.load(std::memory_order_relaxed);
+        std::int64_t t = top.load(std::memory_order_acquire);
+        Array *a = array.load(std::memory_order_relaxed);
+        if (b - t > a->capacity - 1) {
+            a = grow(a, t, b);
+        }
+        a->put(b, task);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // newest task, nullptr if deque is empty
+    PoolTask *pop() {
+        std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Array *a = array.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+
+        PoolTask *task = nullptr;
+        if (t <= b) {
+            task = a->get(b);
+            if (t == b) {
+                // last task, thieves may take it at the same time
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    task = nullptr;
+                }
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+        } else {
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return task;
+    }
+
+    // oldest task, nullptr if deque is empty or another thread took it first
+    PoolTask *steal() {
+        std::int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return nullptr;
+        }
+        PoolTask *task = array.load(std::memory_order_acquire)->get(t);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return task;
+    }
+
+    // approximate number of tasks
+    std::int64_t size() const {
+        return std::max<std::int64_t>(0, bottom.load(std::memory_order_relaxed) - top.load(std::memory_order_relaxed));
+    }
+
+private:
+    // circular array, capacity is a power of 2
+    struct Array {
+        std::int64_t capacity;
+        std::unique_ptr<std::atomic<PoolTask *>[]> items;
+
+        explicit Array(std::int64_t _capacity) : capacity(_capacity), items(new std::atomic<PoolTask *>[_capacity]) {}
+
+        PoolTask *get(std::int64_t i) const {
+            return items[i & (capacity - 1)].load(std::memory_order_relaxed);
+        }
+
+        void put(std::int64_t i, PoolTask *task) {
+            items[i & (capacity - 1)].store(task, std::memory_order_relaxed);
+        }
+    };
+
+    std::atomic<std::int64_t> top{0}, bottom{0};
+    std::atomic<Array *> array;
+    // all arrays ever used, thieves may still read old ones, so they are freed with the deque
+    std::vector<std::unique_ptr<Array>> arrays;
+
+    Array *grow(Array *old, std::int64_t t, std::int64_t b) {
+        arrays.push_back(std::unique_ptr<Array>(new Array(old->capacity * 2)));
+        Array *a = arrays.back().get();
+        for (std::int64_t i = t; i < b; ++i) {
+            a->put(i, old->get(i));
+        }
+        array.store(a, std::memory_order_release);
+        return a;
+    }
+};
+
+// counters of a pool, summed over all threads
+struct ThreadPoolStats {
+    // tasks that were submitted and tasks that were started
+    std::uint64_t tasks_submitted = 0, tasks_run = 0;
+    // tasks taken from deques of other workers (tasks taken from the shared queue are not steals)
+    std::uint64_t steals = 0;
+    // time workers spent without a task
+    std::uint64_t idle_nanoseconds = 0;
+};
+
+class ThreadPool {
+public:
+    // `threads` workers (number of hardware threads for 0)
+    explicit ThreadPool(unsigned int threads = 0) {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (unsigned int t = 0; t < threads; ++t) {
+            deques.push_back(std::unique_ptr<WorkStealingDeque>(new WorkStealingDeque()));
+        }
+        for (unsigned int t = 0; t < threads; ++t) {
+            workers.emplace_back([this, t]() {
+                work(t);
+            });
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // tasks that were already submitted are run before workers stop
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+    }
+
+    unsigned int threads() const {
+        return workers.size();
+    }
+
+    // runs function on some thread of the pool
+    void submit(std::function<void()> function) {
+        PoolTask *task = new PoolTask{std::move(function)};
+        if (current_pool() == this) {
+            deques[current_worker()]->push(task);
+        } else {
+            std::lock_guard<std::mutex> lock(shared_mutex);
+            shared_queue.push_back(task);
+        }
+        submitted.fetch_add(1, std::memory_order_relaxed);
+
+        // a sleeping worker checks `queued` after it announces that it sleeps, so either it sees
+        // the new task or this thread sees it sleeping
+        queued.fetch_add(1, std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            wake.notify_one();
+        }
+    }
+
+    // runs one task of the pool in calling thread (own tasks of a worker first, otherwise a stolen one),
+    // returns false if no task was found
+    bool run_one() {
+        const bool worker = current_pool() == this;
+        PoolTask *task = take(worker ? current_worker() : threads());
+        if (task == nullptr) {
+            return false;
+        }
+        run(task);
+        return true;
+    }
+
+    ThreadPoolStats stats() const {
+        ThreadPoolStats stats;
+        stats.tasks_submitted = submitted.load(std::memory_order_relaxed);
+        stats.tasks_run = tasks_run.load(std::memory_order_relaxed);
+        stats.steals = steals.load(std::memory_order_relaxed);
+        stats.idle_nanoseconds = idle_nanoseconds.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void reset_stats() {
+        submitted = 0;
+        tasks_run = 0;
+        steals = 0;
+        idle_nanoseconds = 0;
+    }
+
+    // pool whose worker is the calling thread, nullptr outside of workers
+    static ThreadPool *current() {
+        return current_pool();
+    }
+
+    // pool with one worker per hardware thread
+    static ThreadPool &shared() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+private:
+    std::vector<std::unique_ptr<WorkStealingDeque>> deques;
+    std::vector<std::thread> workers;
+
+    // tasks submitted from threads outside the pool
+    std::mutex shared_mutex;
+    std::deque<PoolTask *> shared_queue;
+
+    // submitted tasks that were not taken yet, workers sleep only while it is zero
+    std::atomic<std::int64_t> queued{0};
+    std::atomic<unsigned int> sleeping{0};
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    std::atomic<std::uint64_t> submitted{0}, tasks_run{0}, steals{0}, idle_nanoseconds{0};
+
+    static ThreadPool *&current_pool() {
+        static thread_local ThreadPool *pool = nullptr;
+        return pool;
+    }
+
+    static unsigned int &current_worker() {
+        static thread_local unsigned int worker = 0;
+        return worker;
+    }
+
+    // task from own deque of worker `index` (no own deque for index = threads()),
+    // then from the shared queue, then stolen from other workers
+    PoolTask *take(unsigned int index) {
+        PoolTask *task = index < deques.size() ? deques[index]->pop() : nullptr;
+        if (task == nullptr) {
+            std::lock_guard<std::mutex> lock(shared_mutex);
+            if (!shared_queue.empty()) {
+                task = shared_queue.front();
+                shared_queue.pop_front();
+            }
+        }
+        for (unsigned int i = 1; task == nullptr && i <= deques.size(); ++i) {
+            unsigned int victim = (index + i) % (deques.size() + 1);
+            if (victim < deques.size()) {
+                task = deques[victim]->steal();
+                if (task != nullptr) {
+                    steals.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+        if (task != nullptr) {
+            queued.fetch_sub(1, std::memory_order_seq_cst);
+        }
+        return task;
+    }
+
+    void run(PoolTask *task) {
+        std::unique_ptr<PoolTask> owned(task);
+        tasks_run.fetch_add(1, std::memory_order_relaxed);
+        owned->function();
+    }
+
+    void work(unsigned int index) {
+        current_pool() = this;
+        current_worker() = index;
+        while (true) {
+            PoolTask *task = take(index);
+            if (task != nullptr) {
+                run(task);
+                continue;
+            }
+
+            auto idle_start = std::chrono::steady_clock::now();
+            {
+                std::unique_lock<std::mutex> lock(sleep_mutex);
+                sleeping.fetch_add(1, std::memory_order_seq_cst);
+                // `queued` drops only when a task is taken, so a worker wakes up for every task that is
+                // submitted after it checked the predicate (see submit())
+                wake.wait(lock, [this]() {
+                    return stopping || queued.load(std::memory_order_seq_cst) > 0;
+                });
+                sleeping.fetch_sub(1, std::memory_order_seq_cst);
+                if (stopping && queued.load(std::memory_order_seq_cst) <= 0) {
+                    return;
+                }
+            }
+            idle_nanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - idle_start).count(), std::memory_order_relaxed);
+        }
+    }
+};
+
+// pool installed by set_default_thread_pool(), nullptr for the shared pool
+inline ThreadPool *&default_thread_pool_override() {
+    static ThreadPool *pool = nullptr;
+    return pool;
+}
+
+// pool installed by ThreadPoolScope for calling thread, nullptr if there is none
+inline ThreadPool *&thread_pool_scope_override() {
+    static thread_local ThreadPool *pool = nullptr;
+    return pool;
+}
+
+// pool used by algorithms of the library
+inline ThreadPool &default_thread_pool() {
+    ThreadPool *pool = thread_pool_scope_override();
+    if (pool == nullptr) {
+        pool = ThreadPool::current();
+    }
+    if (pool == nullptr) {
+        pool = default_thread_pool_override();
+    }
+    return pool != nullptr ? *pool : ThreadPool::shared();
+}
+
+// algorithms called by this thread use given pool while the scope exists, other threads are not affected
+// (for example threads pinned to CPUs that should not send work to workers of the shared pool)
+class ThreadPoolScope {
+public:
+    explicit ThreadPoolScope(ThreadPool &pool) : previous(thread_pool_scope_override()) {
+        thread_pool_scope_override() = &pool;
+    }
+
+    ThreadPoolScope(const ThreadPoolScope &) = delete;
+
+    ThreadPoolScope &operator=(const ThreadPoolScope &) = delete;
+
+    ~ThreadPoolScope() {
+        thread_pool_scope_override() = previous;
+    }
+
+private:
+    ThreadPool *previous;
+};
+
+// algorithms use given pool from now on (caller keeps it alive), nullptr restores the shared pool
+inline void set_default_thread_pool(ThreadPool *pool) {
+    default_thread_pool_override() = pool;
+}
+
+// fork-join group of tasks: run() starts tasks, wait() returns when all of them are finished
+// (and rethrows the first exception thrown by them), waiting thread runs tasks of the pool meanwhile
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool &_pool = default_thread_pool()) : pool(_pool), state(std::make_shared<State>()) {}
+
+    TaskGroup(const TaskGroup &) = delete;
+
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    // tasks may refer to local variables of the caller, so they have to finish first
+    ~TaskGroup() {
+        help();
+    }
+
+    template<class Function>
+    void run(Function function) {
+        state->pending.fetch_add(1, std::memory_order_relaxed);
+        std::shared_ptr<State> group = state;
+        pool.submit([group, function]() {
+            try {
+                function();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(group->mutex);
+                if (!group->error) {
+                    group->error = std::current_exception();
+                }
+            }
+            group->pending.fetch_sub(1, std::memory_order_acq_rel);
+        });
+    }
+
+    void wait() {
+        help();
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            std::swap(error, state->error);
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    ThreadPool &thread_pool() const {
+        return pool;
+    }
+
+private:
+    struct State {
+        std::atomic<unsigned int> pending{0};
+        std::mutex mutex;
+        std::exception_ptr error;
+    };
+
+    ThreadPool &pool;
+    std::shared_ptr<State> state;
+
+    // runs tasks of the pool until all tasks of the group are finished
+    void help() {
+        while (state->pending.load(std::memory_order_acquire) > 0) {
+            if (!pool.run_one()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
+
+// function(first, last) for consecutive ranges of [begin, end) with at most `grain` elements,
+// ranges are run in parallel on the pool
+template<class Function>
+void parallel_for(unsigned int begin, unsigned int end, unsigned int grain, Function function,
+                  ThreadPool &pool = default_thread_pool()) {
+    grain = std::max(1u, grain);
+    if (end <= begin + grain || pool.threads() == 1) {
+        if (begin < end) {
+            function(begin, end);
+        }
+        return;
+    }
+    TaskGroup group(pool);
+    for (unsigned int first = begin; first < end; first += grain) {
+        unsigned int last = end - first > grain ? first + grain : end;
+        group.run([&function, first, last]() {
+            function(first, last);
+        });
+    }
+    group.wait();
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_THREAD_POOL_HPP
@@ -0,0 +1,116 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_TRANSPOSE_HPP
+#define FAST_MATRIX_MULTIPLICATION_TRANSPOSE_HPP
+
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#endif
+
+// operation applied to an operand of a product, op(A) is either A or A^T
+// (transposition is handled when data is read, transposed matrix is never stored)
+enum class Op {
+    none,
+    transpose
+};
+
+// blocked transpose works on square tiles of this size,
+// source and destination tile of doubles (2 * 32 * 32 * 8 bytes = 16kB) both fit in L1 cache
+const unsigned int transpose_block_size = 32;
+
+// transposes one tile, dst[j][i] = src[i][j]
+// src is rows x cols matrix with row stride src_stride, dst is cols x rows matrix with row stride dst_stride
+template<class Scalar>
+void transpose_tile(const Scalar *src, unsigned int src_stride, unsigned int rows, unsigned int cols,
+                    Scalar *dst, unsigned int dst_stride) {
+    for (unsigned int i = 0; i < rows; ++i) {
+        for (unsigned int j = 0; j < cols; ++j) {
+            dst[j * dst_stride + i] = src[i * src_stride + j];
+        }
+    }
+}
+
+#ifdef __SSE2__
+
+// SSE2 version for doubles, tile is transposed in 2x2 blocks that fit in one register each
+inline void transpose_tile(const double *src, unsigned int src_stride, unsigned int rows, unsigned int cols,
+                           double *dst, unsigned int dst_stride) {
+    unsigned int even_rows = rows & ~1u, even_cols = cols & ~1u;
+
+    for (unsigned int i = 0; i < even_rows; i += 2) {
+        for (unsigned int j = 0; j < even_cols; j += 2) {
+            // | a b |    | a c |
+            // | c d | -> | b d |
+            __m128d row0 = _mm_loadu_pd(src + i * src_stride + j);
+            __m128d row1 = _mm_loadu_pd(src + (i + 1) * src_stride + j);
+            _mm_storeu_pd(dst + j * dst_stride + i, _mm_unpacklo_pd(row0, row1));
+            _mm_storeu_pd(dst + (j + 1) * dst_stride + i, _mm_unpackhi_pd(row0, row1));
+        }
+    }
+
+    // remaining column and row (if dimensions are odd)
+    for (unsigned int i = 0; i < rows; ++i) {
+        for (unsigned int j = even_cols; j < cols; ++j) {
+            dst[j * dst_stride + i] = src[i * src_stride + j];
+        }
+    }
+    for (unsigned int i = even_rows; i < rows; ++i) {
+        for (unsigned int j = 0; j < even_cols; ++j) {
+            dst[j * dst_stride + i] = src[i * src_stride + j];
+        }
+    }
+}
+
+// SSE version for floats, tile is transposed in 4x4 blocks
+inline void transpose_tile(const float *src, unsigned int src_stride, unsigned int rows, unsigned int cols,
+                           float *dst, unsigned int dst_stride) {
+    unsigned int full_rows = rows & ~3u, full_cols = cols & ~3u;
+
+    for (unsigned int i = 0; i < full_rows; i += 4) {
+        for (unsigned int j = 0; j < full_cols; j += 4) {
+            __m128 row0 = _mm_loadu_ps(src + i * src_stride + j);
+            __m128 row1 = _mm_loadu_ps(src + (i + 1) * src_stride + j);
+            __m128 row2 = _mm_loadu_ps(src + (i + 2) * src_stride + j);
+            __m128 row3 = _mm_loadu_ps(src + (i + 3) * src_stride + j);
+            _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+            _mm_storeu_ps(dst + j * dst_stride + i, row0);
+            _mm_storeu_ps(dst + (j + 1) * dst_stride + i, row1);
+            _mm_storeu_ps(dst + (j + 2) * dst_stride + i, row2);
+            _mm_storeu_ps(dst + (j + 3) * dst_stride + i, row3);
+        }
+    }
+
+    // remaining columns and rows
+    for (unsigned int i = 0; i < rows; ++i) {
+        for (unsigned int j = full_cols; j < cols; ++j) {
+            dst[j * dst_stride + i] = src[i * src_stride + j];
+        }
+    }
+    for (unsigned int i = full_rows; i < rows; ++i) {
+        for (unsigned int j = 0; j < full_cols; ++j) {
+            dst[j * dst_stride + i] = src[i * src_stride + j];
+        }
+    }
+}
+
+#endif
+
+// cache-blocked transpose, dst = src^T
+// src is rows x cols matrix with row stride src_stride, dst is cols x rows matrix with row stride dst_stride.
+// Naive transpose reads one matrix by rows and writes the other by columns, so every write touches
+// a different cache line. Here both matrices are walked tile by tile, so each tile stays in cache.
+template<class Scalar>
+void transpose_blocked(const Scalar *src, unsigned int src_stride, unsigned int rows, unsigned int cols,
+                       Scalar *dst, unsigned int dst_stride) {
+    for (unsigned int i = 0; i < rows; i += transpose_block_size) {
+        unsigned int tile_rows = std::min(transpose_block_size, rows - i);
+        for (unsigned int j = 0; j < cols; j += transpose_block_size) {
+            unsigned int tile_cols = std::min(transpose_block_size, cols - j);
+            transpose_tile(src + i * src_stride + j, src_stride, tile_rows, tile_cols,
+                           dst + j * dst_stride + i, dst_stride);
+        }
+    }
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_TRANSPOSE_HPP
@@ -6,7 +6,12 @@
 #include <string>
 #include "matrix.hpp"
 
-std::default_random_engine generator;
+// random generator shared by functions below (one for the whole program, even if this header is included
+// in several translation units)
+inline std::default_random_engine &random_generator() {
+    static std::default_random_engine generator;
+    return generator;
+}
 
 // Simple function that prints a matrix.
 template<class Scalar>
@@ -35,7 +40,7 @@ void print_differences(const Matrix<Scalar> &A, const Matrix<Scalar> &B) {
 
 // constructs matrix of size rows x cols, filled with random int values,
 // values are from 0 to max_size (inclusive)
-Matrix<int> random_int_matrix(unsigned int rows, unsigned int cols, unsigned int max_size = 10) {
+inline Matrix<int> random_int_matrix(unsigned int rows, unsigned int cols, unsigned int max_size = 10) {
     // create new random generator
     std::uniform_int_distribution<int> distribution(0, max_size);
 
@@ -43,7 +48,7 @@ Matrix<int> random_int_matrix(unsigned int rows, unsigned int cols, unsigned int
     std::vector<int> data(rows * cols);
 
     for (unsigned int i = 0; i < rows * cols; ++i) {
-        data[i] = distribution(generator);
+        data[i] = distribution(random_generator());
     }
 
     return Matrix<int>(data, rows, cols);
@@ -51,7 +56,7 @@ Matrix<int> random_int_matrix(unsigned int rows, unsigned int cols, unsigned int
 
 // constructs matrix of size rows x cols, filled with random int values,
 // values are from 0 to max_size (inclusive)
-Matrix<double> random_float_matrix(unsigned int rows, unsigned int cols, unsigned int max_size = 10) {
+inline Matrix<double> random_float_matrix(unsigned int rows, unsigned int cols, unsigned int max_size = 10) {
     // create new random generator
     std::uniform_int_distribution<int> distribution(0, max_size);
 
@@ -59,7 +64,7 @@ Matrix<double> random_float_matrix(unsigned int rows, unsigned int cols, unsigne
     std::vector<double> data(rows * cols);
 
     for (unsigned int i = 0; i < rows * cols; ++i) {
-        data[i] = distribution(generator);
+        data[i] = distribution(random_generator());
     }
 
     return Matrix<double>(data, rows, cols);
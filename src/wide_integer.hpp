@@ -0,0 +1,186 @@
+#ifndef FAST_MATRIX_MULTIPLICATION_WIDE_INTEGER_HPP
+#define FAST_MATRIX_MULTIPLICATION_WIDE_INTEGER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+// Signed integers wider than 64 bits, for exact results that do not fit in machine words.
+
+// 128-bit signed and unsigned integers (GCC and Clang extension)
+__extension__ typedef __int128 wide_int128;
+__extension__ typedef unsigned __int128 wide_uint128;
+
+// 256-bit signed integer in two's complement, arithmetic wraps around like for unsigned machine integers
+class Int256 {
+public:
+    // least significant word first
+    std::uint64_t words[4];
+
+    Int256() : words{0, 0, 0, 0} {}
+
+    // any machine integer, negative values are sign extended
+    template<class Integer, class = typename std::enable_if<std::is_integral<Integer>::value>::type>
+    Int256(Integer x) {
+        std::uint64_t extension = x < 0 ? ~std::uint64_t(0) : 0;
+        words[0] = static_cast<std::uint64_t>(x);
+        words[1] = words[2] = words[3] = extension;
+    }
+
+    Int256(wide_int128 x) {
+        std::uint64_t extension = x < 0 ? ~std::uint64_t(0) : 0;
+        words[0] = static_cast<std::uint64_t>(x);
+        words[1] = static_cast<std::uint64_t>(static_cast<wide_uint128>(x) >> 64);
+        words[2] = words[3] = extension;
+    }
+
+    bool is_negative() const {
+        return words[3] >> 63;
+    }
+
+    // lowest 64 bits, correct if value fits in int64
+    explicit operator std::int64_t() const {
+        return static_cast<std::int64_t>(words[0]);
+    }
+
+    // lowest 128 bits, correct if value fits in int128
+    explicit operator wide_int128() const {
+        return static_cast<wide_int128>((static_cast<wide_uint128>(words[1]) << 64) | words[0]);
+    }
+
+    explicit operator double() const {
+        Int256 magnitude = is_negative() ? -*this : *this;
+        double value = 0;
+        for (int i = 3; i >= 0; --i) {
+            value = value * 18446744073709551616.0 + double(magnitude.words[i]);
+        }
+        return is_negative() ? -value : value;
+    }
+
+    Int256 &operator+=(const Int256 &other) {
+        std::uint64_t carry = 0;
+        for (unsigned int i = 0; i < 4; ++i) {
+            wide_uint128 sum = wide_uint128(words[i]) + other.words[i] + carry;
+            words[i] = static_cast<std::uint64_t>(sum);
+            carry = static_cast<std::uint64_t>(sum >> 64);
+        }
+        return *this;
+    }
+
+    Int256 &operator-=(const Int256 &other) {
+        return *this += -other;
+    }
+
+    // product modulo 2^256, which is also correct signed product if it fits
+    Int256 &operator*=(const Int256 &other) {
+        std::uint64_t result[4] = {0, 0, 0, 0};
+        for (unsigned int i = 0; i < 4; ++i) {
+            std::uint64_t carry = 0;
+            for (unsigned int j = 0; i + j < 4; ++j) {
+                wide_uint128 product = wide_uint128(words[i]) * other.words[j] + result[i + j] + carry;
+                result[i + j] = static_cast<std::uint64_t>(product);
+                carry = static_cast<std::uint64_t>(product >> 64);
+            }
+        }
+        std::copy(result, result + 4, words);
+        return *this;
+    }
+
+    // this = this * factor + addend, for non-negative values (used to build numbers digit by digit)
+    Int256 &multiply_add(std::uint64_t factor, std::uint64_t addend) {
+        std::uint64_t carry = addend;
+        for (unsigned int i = 0; i < 4; ++i) {
+            wide_uint128 product = wide_uint128(words[i]) * factor + carry;
+            words[i] = static_cast<std::uint64_t>(product);
+            carry = static_cast<std::uint64_t>(product >> 64);
+        }
+        return *this;
+    }
+
+    // this = this / divisor for non-negative values, remainder is returned
+    std::uint64_t divide(std::uint64_t divisor) {
+        std::uint64_t remainder = 0;
+        for (int i = 3; i >= 0; --i) {
+            wide_uint128 current = (wide_uint128(remainder) << 64) | words[i];
+            words[i] = static_cast<std::uint64_t>(current / divisor);
+            remainder = static_cast<std::uint64_t>(current % divisor);
+        }
+        return remainder;
+    }
+
+    Int256 operator-() const {
+        Int256 result;
+        for (unsigned int i = 0; i < 4; ++i) {
+            result.words[i] = ~words[i];
+        }
+        return result += Int256(1);
+    }
+
+    bool operator==(const Int256 &other) const {
+        return std::equal(words, words + 4, other.words);
+    }
+
+    bool operator!=(const Int256 &other) const {
+        return !(*this == other);
+    }
+
+    bool operator<(const Int256 &other) const {
+        if (is_negative() != other.is_negative()) {
+            return is_negative();
+        }
+        // same sign, two's complement words compare as unsigned
+        for (int i = 3; i >= 0; --i) {
+            if (words[i] != other.words[i]) {
+                return words[i] < other.words[i];
+            }
+        }
+        return false;
+    }
+
+    bool operator>(const Int256 &other) const {
+        return other < *this;
+    }
+
+    bool operator<=(const Int256 &other) const {
+        return !(other < *this);
+    }
+
+    bool operator>=(const Int256 &other) const {
+        return !(*this < other);
+    }
+
+    // decimal representation
+    std::string to_string() const {
+        Int256 magnitude = is_negative() ? -*this : *this;
+        std::string digits;
+        do {
+            digits.push_back(char('0' + magnitude.divide(10)));
+        } while (magnitude != Int256());
+
+        if (is_negative()) {
+            digits.push_back('-');
+        }
+        std::reverse(digits.begin(), digits.end());
+        return digits;
+    }
+};
+
+inline Int256 operator+(Int256 a, const Int256 &b) {
+    return a += b;
+}
+
+inline Int256 operator-(Int256 a, const Int256 &b) {
+    return a -= b;
+}
+
+inline Int256 operator*(Int256 a, const Int256 &b) {
+    return a *= b;
+}
+
+inline std::ostream &operator<<(std::ostream &os, const Int256 &a) {
+    return os << a.to_string();
+}
+
+#endif //FAST_MATRIX_MULTIPLICATION_WIDE_INTEGER_HPP
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "helpers.hpp"
+
+#include "executor.hpp"
+#include "thread_pool.hpp"
+#include "multiply_async.hpp"
+#include "multiply_classic.hpp"
+#include "matrix.hpp"
+
+TEST(Async, Futures) {
+    ThreadPool pool(2);
+    Executor executor(64, pool);
+    Matrix<int> A = random_int_matrix(461, 403), B = random_int_matrix(403, 437);
+    Matrix<int> C = multiply_classic(A, B);
+
+    // several products in flight at once
+    std::vector<std::future<Matrix<int>>> futures;
+    for (Algorithm algorithm : {Algorithm::classic, Algorithm::strassen, Algorithm::laderman,
+                                Algorithm::rectangular}) {
+        futures.push_back(multiply_async(executor, A, B, algorithm));
+    }
+    // too small for recursion
+    futures.push_back(multiply_async(executor, A.subblock({0, 0}, {50, 40}), B.subblock({0, 0}, {40, 30})));
+
+    for (unsigned int i = 0; i < 4; ++i) {
+        ASSERT_EQ(futures[i].get(), C);
+    }
+    ASSERT_EQ(futures[4].get(), C.subblock({0, 0}, {50, 30}) - multiply_classic(
+            A.subblock({0, 40}, {50, 363}), B.subblock({40, 0}, {363, 30})));
+
+    // shared executor
+    ASSERT_EQ(multiply_async(A, B).get(), C);
+}
+
+TEST(Async, Callback) {
+    ThreadPool pool(1);
+    Executor executor(64, pool);
+    Matrix<int> A = random_int_matrix(301, 250), B = random_int_matrix(250, 205);
+
+    std::promise<Matrix<int>> result;
+    multiply_async<int>(executor, A, B, Algorithm::strassen, [&result](Matrix<int> C, std::exception_ptr error) {
+        ASSERT_FALSE(error);
+        result.set_value(std::move(C));
+    });
+    ASSERT_EQ(result.get_future().get(), multiply_classic(A, B));
+}
+
+TEST(Async, BoundedQueue) {
+    ThreadPool pool(1);
+    Executor executor(1, pool);
+    std::promise<void> started, release;
+    std::shared_future<void> gate = release.get_future().share();
+
+    executor.submit({[&started, gate]() {
+        started.set_value();
+        gate.wait();
+    }});
+    started.get_future().wait();
+
+    // worker is busy, one job fits into the queue
+    ASSERT_TRUE(executor.try_submit({[]() {}}));
+    ASSERT_FALSE(executor.try_submit({[]() {}}));
+    release.set_value();
+}
+
+TEST(Async, Fairness) {
+    // one worker, small job waits for one task of the large job, not for all of them
+    ThreadPool pool(1);
+    Executor executor(64, pool);
+    std::mutex mutex;
+    std::vector<std::string> log;
+    std::promise<void> started, release, finished;
+    std::shared_future<void> gate = release.get_future().share();
+
+    std::vector<Executor::Task> large = {[&started, gate]() {
+        started.set_value();
+        gate.wait();
+    }};
+    for (unsigned int t = 0; t < 10; ++t) {
+        large.push_back([&]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            log.push_back("large");
+        });
+    }
+    executor.submit(large);
+    started.get_future().wait();
+
+    executor.submit({[&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        log.push_back("small");
+        finished.set_value();
+    }});
+    release.set_value();
+    finished.get_future().wait();
+
+    // remaining tasks of the large job may still be running
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_LE(std::find(log.begin(), log.end(), "small") - log.begin(), 1);
+}
+
+TEST(Async, OneTaskPerRunner) {
+    // every task of the executor runs as its own task of the pool, so a runner started by a thread that
+    // waits for its group (TaskGroup runs any task of the pool meanwhile) gives the thread back after one task
+    ThreadPool pool(1);
+    std::atomic<unsigned int> count{0};
+    {
+        Executor executor(64, pool);
+        executor.submit(std::vector<Executor::Task>(10, [&count]() {
+            count++;
+        }));
+    }
+    ASSERT_EQ(count.load(), 10u);
+    ASSERT_GE(pool.stats().tasks_run, 10u);
+}
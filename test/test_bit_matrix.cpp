@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include "helpers.hpp"
+
+#include "bit_matrix.hpp"
+#include "multiply_classic.hpp"
+#include "matrix.hpp"
+
+// random Boolean matrix, about one entry in `sparsity` is true
+BitMatrix random_bit_matrix(unsigned int rows, unsigned int cols, unsigned int sparsity = 2) {
+    Matrix<int> random = random_int_matrix(rows, cols, sparsity - 1);
+    for (auto &element : random.data) {
+        element = element == 0;
+    }
+    return BitMatrix::from_matrix(random);
+}
+
+// Boolean product through integer classic multiplication
+BitMatrix boolean_reference(const BitMatrix &A, const BitMatrix &B) {
+    return BitMatrix::from_matrix(multiply_classic(A.to_matrix<int>(), B.to_matrix<int>()));
+}
+
+TEST(BitMatrix, Basic) {
+    BitMatrix A(3, 70);
+    A.set(0, 0, true);
+    A.set(1, 65, true);
+    A.set(2, 69, true);
+    A.set(2, 69, false);
+    ASSERT_TRUE(A.get(0, 0) && A.get(1, 65) && !A.get(2, 69));
+    ASSERT_EQ(A.count(), 2u);
+    ASSERT_EQ(A.words_per_row(), 2u);
+    ASSERT_EQ(BitMatrix::from_matrix(A.to_matrix()), A);
+}
+
+TEST(BitMatrix, Product) {
+    // sizes that are not multiples of words or table groups
+    BitMatrix A = random_bit_matrix(77, 131, 8);
+    BitMatrix B = random_bit_matrix(131, 2100, 16);
+    BitMatrix C = boolean_reference(A, B);
+
+    ASSERT_EQ(multiply_boolean(A, B, BooleanAlgorithm::four_russians), C);
+    ASSERT_EQ(multiply_boolean(A, B, BooleanAlgorithm::strassen), C);
+    ASSERT_EQ(multiply_boolean(A, B), C);
+}
+
+TEST(BitMatrix, GF2) {
+    BitMatrix A = random_bit_matrix(45, 100);
+    BitMatrix B = random_bit_matrix(100, 90);
+
+    Matrix<int> product = multiply_classic(A.to_matrix<int>(), B.to_matrix<int>());
+    for (auto &element : product.data) {
+        element %= 2;
+    }
+    ASSERT_EQ(multiply_gf2(A, B), BitMatrix::from_matrix(product));
+}
+
+TEST(BitMatrix, TransitiveClosure) {
+    // sparse random graph, compared with Warshall's algorithm
+    const unsigned int n = 150;
+    BitMatrix A = random_bit_matrix(n, n, 100);
+
+    Matrix<bool> reachable = A.to_matrix();
+    for (unsigned int k = 0; k < n; ++k) {
+        for (unsigned int i = 0; i < n; ++i) {
+            if (reachable.data[i * n + k]) {
+                for (unsigned int j = 0; j < n; ++j) {
+                    if (reachable.data[k * n + j]) {
+                        reachable.data[i * n + j] = true;
+                    }
+                }
+            }
+        }
+    }
+
+    BitMatrix closure = BitMatrix::from_matrix(reachable);
+    ASSERT_EQ(transitive_closure(A), closure);
+
+    closure |= BitMatrix::identity(n);
+    ASSERT_EQ(transitive_closure(A, true), closure);
+}
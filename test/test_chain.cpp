@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include "helpers.hpp"
+
+#include "multiply_chain.hpp"
+#include "multiply_classic.hpp"
+#include "thread_pool.hpp"
+#include "matrix.hpp"
+
+TEST(Chain, Order) {
+    // example from Cormen et al., Introduction to Algorithms: ((M0 (M1 M2)) ((M3 M4) M5))
+    ChainOrder order = chain_order({30, 35, 15, 5, 10, 20, 25}, Algorithm::classic);
+    ASSERT_EQ(order.cost, 15125);
+    ASSERT_EQ(order.split(0, 5), 2u);
+    ASSERT_EQ(order.split(0, 2), 0u);
+    ASSERT_EQ(order.split(3, 5), 4u);
+
+    // fast algorithms are cheaper for large products, but not for small ones
+    ASSERT_LT(chain_product_cost(Algorithm::strassen, 2000, 2000, 2000), 2000.0 * 2000 * 2000);
+    ASSERT_EQ(chain_product_cost(Algorithm::strassen, 100, 2000, 2000), 100.0 * 2000 * 2000);
+}
+
+TEST(Chain, Products) {
+    const unsigned int dimensions[] = {37, 450, 3, 410, 520, 11, 300, 1};
+    std::vector<Matrix<int>> matrices;
+    for (unsigned int i = 0; i + 1 < sizeof(dimensions) / sizeof(dimensions[0]); ++i) {
+        matrices.push_back(random_int_matrix(dimensions[i], dimensions[i + 1], 3));
+    }
+
+    Matrix<int> expected = matrices[0];
+    for (unsigned int i = 1; i < matrices.size(); ++i) {
+        expected = multiply_classic(expected, matrices[i]);
+    }
+
+    ASSERT_EQ(multiply_chain(matrices), expected);
+    ASSERT_EQ(multiply_chain(matrices, Algorithm::classic), expected);
+    ASSERT_EQ(multiply_chain(std::vector<Matrix<int>>(matrices.begin(), matrices.begin() + 1)), matrices[0]);
+}
+
+TEST(Chain, Parallel) {
+    // two independent sub-chains of large products
+    std::vector<Matrix<double>> matrices = {random_float_matrix(500, 420, 2), random_float_matrix(420, 500, 2),
+                                            random_float_matrix(500, 20, 2), random_float_matrix(20, 430, 2),
+                                            random_float_matrix(430, 450, 2), random_float_matrix(450, 400, 2)};
+    Matrix<double> expected = matrices[0];
+    for (unsigned int i = 1; i < matrices.size(); ++i) {
+        expected = multiply_classic(expected, matrices[i]);
+    }
+
+    ThreadPool pool(2);
+    set_default_thread_pool(&pool);
+    Matrix<double> C = multiply_chain(matrices);
+    set_default_thread_pool(nullptr);
+    ASSERT_EQ(C, expected);
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include "helpers.hpp"
+
+#include "multiply_classic.hpp"
+#include "multiply_coroutine.hpp"
+#include "thread_pool.hpp"
+#include "matrix.hpp"
+
+// coroutine scheduler is compiled only in C++20 builds
+#ifdef FAST_MATRIX_MULTIPLICATION_HAS_COROUTINES
+
+TEST(Coroutine, Algorithms) {
+    ThreadPool pool(3);
+    CoroutineScheduler scheduler(pool);
+    Matrix<int> A = random_int_matrix(861, 803), B = random_int_matrix(803, 837);
+    Matrix<int> C = multiply_classic(A, B);
+
+    ASSERT_EQ(multiply_coroutine(A, B, Algorithm::strassen, scheduler), C);
+    ASSERT_EQ(multiply_coroutine(A, B, Algorithm::laderman, scheduler), C);
+    ASSERT_EQ(multiply_coroutine(A, B, Algorithm::rectangular, scheduler), C);
+    ASSERT_EQ(multiply_coroutine(A, B, Algorithm::classic, scheduler), C);
+
+    // shared scheduler, too small for recursion
+    Matrix<int> D = random_int_matrix(30, 20), E = random_int_matrix(20, 10);
+    ASSERT_EQ(multiply_coroutine(D, E), multiply_classic(D, E));
+
+    // coroutines run on the pool of the scheduler, no other threads are started
+    ThreadPool single(1);
+    CoroutineScheduler single_scheduler(single);
+    ASSERT_EQ(multiply_coroutine(A, B, Algorithm::strassen, single_scheduler), C);
+    ASSERT_GT(single.stats().tasks_run, 0u);
+}
+
+TEST(Coroutine, WhenAll) {
+    ThreadPool pool(2);
+    CoroutineScheduler scheduler(pool);
+    std::vector<CoroutineTask<Matrix<int>>> tasks;
+    std::vector<Matrix<int>> expected;
+    for (unsigned int i = 0; i < 20; ++i) {
+        Matrix<int> A = random_int_matrix(250 + i, 230), B = random_int_matrix(230, 240);
+        expected.push_back(multiply_classic(A, B));
+        tasks.push_back(coroutine_multiply(scheduler, A, B, Algorithm::strassen, 2));
+    }
+
+    // waits for all tasks from another coroutine
+    auto all = [&scheduler](std::vector<CoroutineTask<Matrix<int>>> tasks) -> CoroutineTask<std::vector<Matrix<int>>> {
+        co_return co_await coroutine_when_all(scheduler, std::move(tasks));
+    };
+    std::promise<std::vector<Matrix<int>>> result;
+    std::future<std::vector<Matrix<int>>> future = result.get_future();
+    std::atomic<unsigned int> remaining{1};
+    CoroutineBranch branch = coroutine_fulfil(all(std::move(tasks)), result);
+    branch.coroutine.promise().remaining = &remaining;
+    branch.coroutine.promise().parent = std::noop_coroutine();
+    scheduler.schedule(branch.coroutine);
+
+    scheduler.wait([&remaining]() {
+        return remaining == 0;
+    });
+    ASSERT_EQ(future.get(), expected);
+    branch.coroutine.destroy();
+}
+
+#endif
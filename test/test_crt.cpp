@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+#include "helpers.hpp"
+
+#include "multiply_classic.hpp"
+#include "multiply_crt.hpp"
+#include "wide_integer.hpp"
+#include "matrix.hpp"
+
+// random matrix with entries up to 2^bits in absolute value, signs alternate
+Matrix<std::int64_t> random_wide_matrix(unsigned int rows, unsigned int cols, unsigned int bits) {
+    Matrix<int> random = random_int_matrix(rows, cols, 1 << 20);
+    Matrix<std::int64_t> A(random);
+    for (unsigned int i = 0; i < A.data.size(); ++i) {
+        std::int64_t value = (A.data[i] << (bits - 20)) + A.data[i];
+        A.data[i] = i % 2 == 0 ? value : -value;
+    }
+    return A;
+}
+
+TEST(WideInteger, Arithmetic) {
+    Int256 a = Int256(std::numeric_limits<std::int64_t>::max());
+    Int256 b = a * a * a;
+    ASSERT_EQ(b.to_string(), "784637716923335095224261902710254454442933591094742482943");
+    ASSERT_EQ((-b).to_string(), "-784637716923335095224261902710254454442933591094742482943");
+    ASSERT_EQ(b - b * Int256(2), -b);
+    ASSERT_TRUE(-b < Int256(0) && Int256(0) < b);
+    ASSERT_EQ(static_cast<std::int64_t>(Int256(-5) * Int256(7)), -35);
+}
+
+TEST(CRT, PrimeCount) {
+    // entries below 2^30 need one prime
+    ASSERT_EQ(crt_prime_count(4, 1 << 10, 1 << 10), 1u);
+    // 64-bit inputs need about 128 + log2(n) bits
+    ASSERT_EQ(crt_prime_count(1000, std::uint64_t(1) << 63, std::uint64_t(1) << 63), 5u);
+}
+
+TEST(CRT, Int64) {
+    // results fit in int64, compared with classic multiplication
+    Matrix<std::int64_t> A = random_wide_matrix(23, 31, 25);
+    Matrix<std::int64_t> B = random_wide_matrix(31, 19, 25);
+    ASSERT_EQ(multiply_crt<std::int64_t>(A, B), multiply_classic(A, B));
+}
+
+TEST(CRT, Wide) {
+    // 58-bit entries, products need about 124 bits
+    Matrix<std::int64_t> A = random_wide_matrix(17, 210, 58);
+    Matrix<std::int64_t> B = random_wide_matrix(210, 13, 58);
+
+    Matrix<Int256> reference = multiply_classic(Matrix<Int256>(A), Matrix<Int256>(B));
+    ASSERT_EQ(multiply_crt<Int256>(A, B), reference);
+    ASSERT_EQ(multiply_crt<Int256>(A, B, Algorithm::laderman), reference);
+    ASSERT_EQ(Matrix<Int256>(multiply_crt<wide_int128>(A, B)), reference);
+
+    // extreme values
+    Matrix<std::int64_t> M(3, 3, std::numeric_limits<std::int64_t>::min());
+    ASSERT_EQ(multiply_crt<Int256>(M, M), Matrix<Int256>(3, 3, Int256(3) * Int256(M.data[0]) * Int256(M.data[0])));
+}
+
+TEST(CRT, Overflow) {
+    Matrix<std::int64_t> A(2, 2, std::numeric_limits<std::int64_t>::max());
+    ASSERT_THROW(multiply_crt<std::int64_t>(A, A), std::overflow_error);
+    ASSERT_THROW(multiply_crt<wide_int128>(A, A), std::overflow_error);
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include "helpers.hpp"
+
+#include "communicator.hpp"
+#include "multiply_classic.hpp"
+#include "multiply_distributed.hpp"
+#include "thread_pool.hpp"
+#include "matrix.hpp"
+
+TEST(Distributed, Messages) {
+    // every process sends a matrix to the next one
+    run_processes(3, [](Communicator &communicator) {
+        unsigned int rank = communicator.rank(), size = communicator.size();
+        std::vector<char> message;
+        message_put_matrix(message, Matrix<int>(2, 3, int(rank)));
+        communicator.send((rank + 1) % size, message);
+
+        std::vector<char> received = communicator.receive((rank + size - 1) % size);
+        std::size_t offset = 0;
+        if (message_get_matrix<int>(received, offset) != Matrix<int>(2, 3, int((rank + size - 1) % size))) {
+            throw std::runtime_error("wrong message");
+        }
+        if (communicator.bytes_sent != 8 + 8 + 6 * sizeof(int) || communicator.messages_sent != 1) {
+            throw std::runtime_error("wrong counters");
+        }
+    });
+
+    // forked processes do not use the pool of the parent (its workers do not exist there)
+    ThreadPool pool(3);
+    set_default_thread_pool(&pool);
+    run_processes(2, [&pool](Communicator &communicator) {
+        if (communicator.rank() == 1 && (&default_thread_pool() == &pool || default_thread_pool().threads() != 1)) {
+            throw std::runtime_error("inherited pool");
+        }
+        Matrix<int> A = random_int_matrix(150, 150);
+        if (multiply_classic(A, A) != multiply_classic(A, A, PlusTimes<int>())) {
+            throw std::runtime_error("wrong product");
+        }
+    });
+    set_default_thread_pool(nullptr);
+
+    ASSERT_THROW(run_processes(2, [](Communicator &communicator) {
+        if (communicator.rank() == 1) {
+            throw std::runtime_error("failure in other process");
+        }
+    }), std::runtime_error);
+}
+
+TEST(Distributed, Subgroups) {
+    std::vector<DistributedGroup> subgroups = distributed_subgroups({0, 51});
+    ASSERT_EQ(subgroups.size(), 7u);
+    ASSERT_EQ(subgroups[0], DistributedGroup(0, 8));
+    ASSERT_EQ(subgroups[6], DistributedGroup(44, 7));
+
+    // every rank except 0 has exactly one parent, which lists it as a follower
+    for (unsigned int rank = 1; rank < 51; ++rank) {
+        auto parent = distributed_parent(rank, 51);
+        ASSERT_EQ(parent.second.first, rank);
+        DistributedGroup group = parent.first == 0 ? DistributedGroup(0, 51) : distributed_parent(parent.first, 51).second;
+        std::vector<unsigned int> followers = distributed_followers(group);
+        ASSERT_EQ(std::count(followers.begin(), followers.end(), rank), 1);
+    }
+}
+
+TEST(Distributed, Strassen) {
+    Matrix<double> A = random_float_matrix(421, 403);
+    Matrix<double> B = random_float_matrix(403, 415);
+    Matrix<double> C = multiply_classic(A, B);
+
+    // one BFS step, each of the 6 other processes gets one product
+    CommunicationStats stats;
+    ASSERT_LT(maximum_relative_difference(C, multiply_distributed(A, B, DistributedOptions(), &stats)), 1e-12);
+    ASSERT_EQ(stats.bytes_sent.size(), 7u);
+
+    // rank 0 sends 210 x 201 and 201 x 207 blocks (and a stop message) to every other process,
+    // which sends back one 210 x 207 block, every message has 8 bytes of length and 8 bytes of dimensions per matrix
+    const std::uint64_t header = 8 + 8;
+    ASSERT_EQ(stats.bytes_sent[0], 6 * (header + 1 + 8 + 8 * (210 * 201 + 201 * 207)) + 6 * (8 + 1));
+    for (unsigned int rank = 1; rank < 7; ++rank) {
+        ASSERT_EQ(stats.bytes_sent[rank], header + 8 * 210 * 207);
+    }
+    ASSERT_EQ(stats.max_bytes(), stats.bytes_sent[0]);
+
+    // fewer processes than products, and DFS step before BFS step
+    DistributedOptions options;
+    options.processes = 3;
+    options.dfs_steps = 1;
+    Matrix<double> E = random_float_matrix(830, 820);
+    ASSERT_LT(maximum_relative_difference(multiply_classic(E, E.transposed()),
+                                          multiply_distributed(E, E.transposed(), options, &stats)), 1e-12);
+    // each of 7 products of DFS step is a BFS step, where ranks 1 and 2 multiply two products each
+    ASSERT_EQ(stats.messages_sent[1], 14u);
+    ASSERT_EQ(stats.messages_sent[2], 14u);
+}
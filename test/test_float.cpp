@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "helpers.hpp"
+
+#include "multiply_classic.hpp"
+#include "multiply_float.hpp"
+#include "matrix.hpp"
+
+// random matrix with entries from -1 to 1 that are not exactly representable in few bits
+Matrix<float> random_unit_matrix(unsigned int rows, unsigned int cols) {
+    Matrix<double> random = random_float_matrix(rows, cols, 1000000);
+    Matrix<float> A = Matrix<float>::zeros(rows, cols);
+    for (unsigned int i = 0; i < A.data.size(); ++i) {
+        A.data[i] = float(std::sin(random.data[i]));
+    }
+    return A;
+}
+
+// largest absolute difference between float product and product calculated in double
+double max_error(const Matrix<float> &A, const Matrix<float> &B, const Matrix<float> &C) {
+    Matrix<double> exact = multiply_classic(Matrix<double>(A), Matrix<double>(B));
+    double error = 0;
+    for (unsigned int i = 0; i < exact.data.size(); ++i) {
+        error = std::max(error, std::abs(exact.data[i] - double(C.data[i])));
+    }
+    return error;
+}
+
+TEST(Float, SimdKernel) {
+    // sizes that leave remainders in rows and columns of SIMD tiles
+    Matrix<float> A = random_unit_matrix(23, 37);
+    Matrix<float> B = random_unit_matrix(37, 29);
+    ASSERT_LT(max_error(A, B, multiply_classic(A, B)), 1e-4);
+
+    Matrix<double> D = random_float_matrix(23, 37);
+    Matrix<double> E = random_float_matrix(29, 37);
+    ASSERT_EQ(multiply_classic(D, E, Op::none, Op::transpose),
+              multiply_classic(D, E.transposed(), Op::none, Op::none));
+}
+
+TEST(Float, ErrorBound) {
+    Matrix<float> A = random_unit_matrix(450, 430);
+    Matrix<float> B = random_unit_matrix(430, 410);
+
+    FloatOptions single;
+    single.precision = Precision::single;
+    FloatOptions mixed;
+
+    FloatErrorBound single_bound = float_error_bound(A, B, single);
+    FloatErrorBound mixed_bound = float_error_bound(A, B, mixed);
+    ASSERT_EQ(single_bound.depth, 2u);
+    ASSERT_LT(mixed_bound.relative, single_bound.relative);
+
+    double single_error = max_error(A, B, multiply_float(A, B, single));
+    double mixed_error = max_error(A, B, multiply_float(A, B, mixed));
+    ASSERT_LE(single_error, single_bound.absolute);
+    ASSERT_LE(mixed_error, mixed_bound.absolute);
+    ASSERT_LE(mixed_error, single_error);
+
+    // without recursion, mixed mode is classic multiplication in double rounded once
+    mixed.max_depth = 0;
+    ASSERT_EQ(float_error_bound(A, B, mixed).depth, 0u);
+    ASSERT_LE(max_error(A, B, multiply_float(A, B, mixed)), 2 * float_unit_roundoff * 430);
+}
+
+TEST(Float, Tolerance) {
+    // each level multiplies the bound by about 12 / 4 = 3
+    FloatOptions options;
+    options.precision = Precision::single;
+    ASSERT_EQ(float_strassen_depth(2000, 2000, 2000, options), 4u);
+
+    options.tolerance = float_error_coefficient(2000, 1, Precision::single);
+    ASSERT_EQ(float_strassen_depth(2000, 2000, 2000, options), 1u);
+
+    options.tolerance = float_error_coefficient(2000, 0, Precision::single);
+    ASSERT_EQ(float_strassen_depth(2000, 2000, 2000, options), 0u);
+}
@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+
+#include "helpers.hpp"
+
+#include "multiply_classic.hpp"
+#include "multiply_gram.hpp"
+#include "matrix.hpp"
+
+// part of C in given triangle (including diagonal), other entries are zeros
+static Matrix<int> triangle_of(const Matrix<int> &C, Triangle triangle) {
+    Matrix<int> result = C;
+    for (unsigned int i = 0; i < C.rows; ++i) {
+        for (unsigned int j = 0; j < C.cols; ++j) {
+            if (triangle == Triangle::lower ? j > i : j < i) {
+                result.data[i * C.cols + j] = 0;
+            }
+        }
+    }
+    return result;
+}
+
+TEST(Gram, Triangles) {
+    // odd number of rows, so halves have different sizes
+    Matrix<int> A = random_int_matrix(933, 517);
+    Matrix<int> full = multiply_classic(A, A, Op::none, Op::transpose);
+
+    const Algorithm algorithms[] = {Algorithm::classic, Algorithm::strassen, Algorithm::laderman,
+                                    Algorithm::rectangular};
+    for (Algorithm algorithm : algorithms) {
+        ASSERT_EQ(multiply_gram(A, Triangle::lower, algorithm), triangle_of(full, Triangle::lower));
+        ASSERT_EQ(multiply_gram(A, Triangle::upper, algorithm), triangle_of(full, Triangle::upper));
+    }
+}
+
+TEST(Gram, Shapes) {
+    // wide, tall and tiny matrices
+    const unsigned int shapes[][2] = {{70, 2000}, {1200, 30}, {1, 1}, {33, 1}, {0, 5}};
+    for (const auto &shape : shapes) {
+        Matrix<int> A = random_int_matrix(shape[0], shape[1]);
+        Matrix<int> full = multiply_classic(A, A, Op::none, Op::transpose);
+        ASSERT_EQ(multiply_gram(A), triangle_of(full, Triangle::lower));
+        ASSERT_EQ(multiply_gram(A, Triangle::upper), triangle_of(full, Triangle::upper));
+    }
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <stdexcept>
+
+#include "helpers.hpp"
+
+#include "multiply_classic.hpp"
+#include "multiply_integer.hpp"
+#include "matrix.hpp"
+
+// random matrix with entries from low to high (inclusive)
+template<class Integer>
+Matrix<Integer> random_integer_matrix(unsigned int rows, unsigned int cols, int low, int high) {
+    Matrix<int> random = random_int_matrix(rows, cols, high - low);
+    return Matrix<Integer>(random - Matrix<int>(rows, cols, -low));
+}
+
+// reference product, calculated in int64
+template<class IntegerA, class IntegerB>
+Matrix<std::int64_t> integer_reference(const Matrix<IntegerA> &A, const Matrix<IntegerB> &B) {
+    return multiply_classic(Matrix<std::int64_t>(A), Matrix<std::int64_t>(B));
+}
+
+TEST(Integer, Basic) {
+    Matrix<std::int8_t> A({1, -2, 3, 4, 5, -6}, 2, 3);
+    Matrix<std::int8_t> B({-1, 2, 3, 4, 5, -6}, 3, 2);
+
+    ASSERT_EQ(multiply_integer(A, B), Matrix<std::int32_t>({8, -24, -19, 64}, 2, 2));
+    ASSERT_EQ(multiply_integer<std::int64_t>(A, B), Matrix<std::int64_t>({8, -24, -19, 64}, 2, 2));
+}
+
+TEST(Integer, Int8) {
+    // odd sizes exercise panel and pair remainders of kernels
+    Matrix<std::int8_t> A = random_integer_matrix<std::int8_t>(37, 45, -128, 127);
+    Matrix<std::int8_t> B = random_integer_matrix<std::int8_t>(45, 51, -128, 127);
+    ASSERT_EQ(Matrix<std::int64_t>(multiply_integer(A, B)), integer_reference(A, B));
+
+    // quantized activations and weights
+    Matrix<std::uint8_t> U = random_integer_matrix<std::uint8_t>(33, 70, 0, 255);
+    Matrix<std::int8_t> W = random_integer_matrix<std::int8_t>(70, 19, -128, 127);
+    ASSERT_EQ(Matrix<std::int64_t>(multiply_integer(U, W)), integer_reference(U, W));
+}
+
+TEST(Integer, Int16) {
+    Matrix<std::int16_t> A = random_integer_matrix<std::int16_t>(21, 30, -32768, 32767);
+    Matrix<std::int16_t> B = random_integer_matrix<std::int16_t>(30, 17, -32768, 32767);
+    ASSERT_EQ(multiply_integer<std::int64_t>(A, B), integer_reference(A, B));
+
+    // two products of -32768 * -32768 do not fit in int32
+    Matrix<std::int16_t> M(3, 3, -32768);
+    ASSERT_EQ(multiply_integer<std::int64_t>(M, M), Matrix<std::int64_t>(3, 3, std::int64_t(3) << 30));
+}
+
+TEST(Integer, Strassen) {
+    // int8 operands leave room for Strassen's recursion
+    ASSERT_GT(integer_strassen_depth<std::int32_t>(600, 600, 600, 128, 128), 0u);
+    // full range int16 operands do not
+    ASSERT_EQ(integer_strassen_depth<std::int64_t>(600, 600, 600, 32768, 32768), 0u);
+
+    Matrix<std::int8_t> A = random_integer_matrix<std::int8_t>(263, 301, -128, 127);
+    Matrix<std::int8_t> B = random_integer_matrix<std::int8_t>(301, 277, -128, 127);
+    ASSERT_EQ(Matrix<std::int64_t>(multiply_integer(A, B)), integer_reference(A, B));
+}
+
+TEST(Integer, Overflow) {
+    // 3 * 32767^2 does not fit in int32
+    Matrix<std::int16_t> A(2, 3, 32767);
+    Matrix<std::int16_t> B(3, 2, 32767);
+    ASSERT_THROW(multiply_integer(A, B), std::overflow_error);
+    ASSERT_EQ(multiply_integer<std::int64_t>(A, B), Matrix<std::int64_t>(2, 2, std::int64_t(3) * 32767 * 32767));
+}
@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+#include <string>
+
+#include "helpers.hpp"
+
+#include "fast_matrix_multiplication.hpp"
+#include "matrix.hpp"
+
+TEST(Library, KernelDispatch) {
+    const std::string initial = classic_kernel_isa();
+    ASSERT_TRUE(select_classic_kernel_isa("generic"));
+    ASSERT_FALSE(select_classic_kernel_isa("unknown"));
+
+    // sizes that leave columns outside SIMD tiles of every width
+    Matrix<int> A = random_int_matrix(67, 301), B = random_int_matrix(301, 83);
+    Matrix<int> expected = multiply_classic(A, B);
+
+    const char *isas[] = {"generic", "avx2", "avx512"};
+    for (const char *isa : isas) {
+        if (!select_classic_kernel_isa(isa)) {
+            continue;
+        }
+        ASSERT_EQ(std::string(classic_kernel_isa()), isa);
+        ASSERT_EQ(multiply_classic(Matrix<double>(A), Matrix<double>(B)), Matrix<double>(expected));
+        ASSERT_EQ(multiply_classic(Matrix<float>(A), Matrix<float>(B)), Matrix<float>(expected));
+    }
+    ASSERT_TRUE(select_classic_kernel_isa(initial.c_str()));
+}
+
+TEST(Library, Instantiations) {
+    // functions compiled in the library for every scalar type
+    Matrix<int> A = random_int_matrix(230, 210, 3), B = random_int_matrix(210, 250, 3);
+    Matrix<int> expected = multiply_classic(A, B);
+
+    Matrix<long long> wide_A(A), wide_B(B);
+    ASSERT_EQ(multiply(wide_A, wide_B, Algorithm::rectangular), Matrix<long long>(expected));
+    ASSERT_EQ(multiply_packed(Matrix<float>(A), pack_operand(Matrix<float>(B), Algorithm::strassen, 230)),
+              Matrix<float>(expected));
+    ASSERT_EQ(multiply_chain(std::vector<Matrix<double>>{Matrix<double>(A), Matrix<double>(B)}),
+              Matrix<double>(expected));
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include <unistd.h>
+
+#include "helpers.hpp"
+
+#include "matrix_io.hpp"
+#include "multiply_classic.hpp"
+#include "matrix.hpp"
+
+TEST(MatrixIO, SaveLoad) {
+    std::string path = "/tmp/fast_matrix_multiplication_test_io.fmm";
+
+    Matrix<int> A = random_int_matrix(37, 53);
+    save_matrix(path, A);
+    ASSERT_EQ(load_matrix<int>(path), A);
+
+    Matrix<double> D = random_float_matrix(20, 3);
+    save_matrix(path, D, Layout::column_major);
+    ASSERT_EQ(load_matrix<double>(path), D);
+
+    MatrixFileHeader header = read_matrix_header(path);
+    ASSERT_EQ(header.rows, 20u);
+    ASSERT_EQ(header.cols, 3u);
+    ASSERT_EQ(header.layout, Layout::column_major);
+    ASSERT_EQ(header.data_offset % matrix_file_alignment, 0u);
+
+    // wrong element type
+    ASSERT_THROW(load_matrix<float>(path), std::runtime_error);
+
+    // long long and std::int64_t are stored the same way, whichever of them is long
+    Matrix<long long> L(random_int_matrix(11, 7));
+    L.data[0] = -(1ll << 62);
+    save_matrix(path, L);
+    ASSERT_EQ(load_matrix<long long>(path), L);
+    ASSERT_EQ(Matrix<long long>(load_matrix<std::int64_t>(path)), L);
+    ASSERT_EQ(read_matrix_header(path).dtype, DType::int64);
+
+    std::remove(path.c_str());
+}
+
+TEST(MatrixIO, Map) {
+    std::string path = "/tmp/fast_matrix_multiplication_test_map.fmm";
+
+    Matrix<double> A = random_float_matrix(41, 29);
+    save_matrix(path, A);
+
+    MappedMatrix<double> mapped = map_matrix<double>(path, true);
+    ASSERT_EQ(mapped.to_matrix(), A);
+    ASSERT_EQ(mapped.block({10, 5}, {7, 8}).to_matrix(), A.subblock({10, 5}, {7, 8}));
+
+    // column-major file is mapped as transpose
+    save_matrix(path, A, Layout::column_major);
+    ASSERT_EQ(map_matrix<double>(path, true).to_matrix(), A.transposed());
+
+    std::remove(path.c_str());
+}
+
+TEST(MatrixIO, StreamingWriter) {
+    std::string path = "/tmp/fast_matrix_multiplication_test_writer.fmm";
+
+    // result is written band by band with a tiny buffer, odd number of bytes per row
+    Matrix<int> A = random_int_matrix(50, 30), B = random_int_matrix(30, 7);
+    Matrix<int> C = multiply_classic(A, B);
+
+    Matrix<std::int8_t> small(C);
+    {
+        MatrixWriter<std::int8_t> writer(path, 50, 7, Layout::row_major, 64, 16);
+        for (unsigned int r0 = 0; r0 < 50; r0 += 9) {
+            writer.write(small.subblock({r0, 0}, {std::min(9u, 50 - r0), 7}));
+        }
+        writer.close();
+    }
+    ASSERT_EQ(load_matrix<std::int8_t>(path), small);
+    ASSERT_EQ(map_matrix<std::int8_t>(path, true).to_matrix(), small);
+
+    // rows shorter than a word of the checksum, each written in its own call
+    Matrix<std::int16_t> narrow(C.subblock({0, 0}, {5, 1}));
+    {
+        MatrixWriter<std::int16_t> writer(path, 5, 1);
+        for (unsigned int r = 0; r < 5; ++r) {
+            writer.write(narrow.data.data() + r, 1);
+        }
+        writer.close();
+    }
+    ASSERT_EQ(load_matrix<std::int16_t>(path), narrow);
+
+    // writer has to receive all rows
+    {
+        MatrixWriter<int> writer(path, 50, 7);
+        writer.write(C.subblock({0, 0}, {10, 7}));
+        ASSERT_THROW(writer.close(), std::runtime_error);
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST(MatrixIO, Checksum) {
+    std::string path = "/tmp/fast_matrix_multiplication_test_checksum.fmm";
+
+    save_matrix(path, random_int_matrix(10, 10));
+    MatrixFileHeader header = read_matrix_header(path);
+
+    // change one element
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(header.data_offset + 17);
+        file.put(char(123));
+    }
+
+    ASSERT_THROW(load_matrix<int>(path), std::runtime_error);
+    ASSERT_THROW(map_matrix<int>(path, true), std::runtime_error);
+    // without verification file is mapped as it is
+    ASSERT_NO_THROW(map_matrix<int>(path));
+
+    std::remove(path.c_str());
+}
+
+TEST(MatrixIO, InvalidHeader) {
+    std::string path = "/tmp/fast_matrix_multiplication_test_header.fmm";
+
+    // header with changed fields is written over a valid file
+    auto rewrite = [&path](void (*change)(MatrixFileHeader &)) {
+        save_matrix(path, random_int_matrix(10, 10));
+        MatrixFileHeader header = read_matrix_header(path);
+        change(header);
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    };
+
+    rewrite([](MatrixFileHeader &header) { header.rows = std::uint64_t(1) << 32; });
+    ASSERT_THROW(map_matrix<int>(path), std::runtime_error);
+    rewrite([](MatrixFileHeader &header) { header.data_offset = 32; });
+    ASSERT_THROW(map_matrix<int>(path), std::runtime_error);
+    rewrite([](MatrixFileHeader &header) { header.data_offset = 96; });
+    ASSERT_THROW(map_matrix<int>(path), std::runtime_error);
+    rewrite([](MatrixFileHeader &header) { header.cols = 11; });
+    ASSERT_THROW(map_matrix<int>(path), std::runtime_error);
+    ASSERT_THROW(load_matrix<int>(path), std::runtime_error);
+
+    // truncated file is not mapped
+    save_matrix(path, random_int_matrix(10, 10));
+    ASSERT_EQ(::truncate(path.c_str(), 64 + 99 * sizeof(int)), 0);
+    ASSERT_THROW(map_matrix<int>(path), std::runtime_error);
+
+    std::remove(path.c_str());
+}
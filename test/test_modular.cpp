@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "helpers.hpp"
+
+#include "modular.hpp"
+#include "multiply_classic.hpp"
+#include "multiply_laderman.hpp"
+#include "multiply_strassen.hpp"
+#include "matrix.hpp"
+
+// 30-bit, 31-bit and 61-bit primes
+typedef Mod<998244353> F30;
+typedef Mod<2147483647> F31;
+typedef Mod<2305843009213693951ull> F61;
+
+// reference product over Z/pZ, entries are reduced after every product
+template<std::uint64_t p>
+Matrix<Mod<p>> modular_reference(const Matrix<Mod<p>> &A, const Matrix<Mod<p>> &B) {
+    Matrix<Mod<p>> C = Matrix<Mod<p>>::zeros(A.rows, B.cols);
+    for (unsigned int i = 0; i < A.rows; ++i) {
+        for (unsigned int k = 0; k < A.cols; ++k) {
+            for (unsigned int j = 0; j < B.cols; ++j) {
+                C[{i, j}] += A[{i, k}] * B[{k, j}];
+            }
+        }
+    }
+    return C;
+}
+
+// random residues spread over the whole range of Z/pZ
+template<std::uint64_t p>
+Matrix<Mod<p>> random_modular_matrix(unsigned int rows, unsigned int cols) {
+    Matrix<int> random = random_int_matrix(rows, cols, 1000000);
+    Matrix<Mod<p>> A(random);
+    for (auto &element : A.data) {
+        element *= Mod<p>(p / 1000001 + 1);
+        element = -element;
+    }
+    return A;
+}
+
+TEST(Modular, Arithmetic) {
+    ASSERT_EQ(Mod<7>(10).value, 3u);
+    ASSERT_EQ(Mod<7>(-1).value, 6u);
+    ASSERT_EQ(Mod<7>(-14).value, 0u);
+    ASSERT_EQ(Mod<7>(5) + Mod<7>(4), Mod<7>(2));
+    ASSERT_EQ(Mod<7>(2) - Mod<7>(5), Mod<7>(4));
+    ASSERT_EQ(Mod<7>(3) * Mod<7>(5), Mod<7>(1));
+    ASSERT_EQ(Mod<7>(3) / Mod<7>(5), Mod<7>(2));
+
+    // sums close to 2^32 and 2^64
+    ASSERT_EQ(Mod<4294967291u>(-1) + Mod<4294967291u>(-1), Mod<4294967291u>(-2));
+    ASSERT_EQ(F61(-1) * F61(-1), F61(1));
+    ASSERT_EQ(F61(1234567) * F61(1234567).inverse(), F61(1));
+}
+
+TEST(Modular, Classic) {
+    Matrix<F30> A = random_modular_matrix<998244353>(37, 300);
+    Matrix<F30> B = random_modular_matrix<998244353>(300, 21);
+    ASSERT_EQ(multiply_classic(A, B), modular_reference(A, B));
+    ASSERT_EQ(multiply_classic(B, A, Op::transpose, Op::transpose), modular_reference(A, B).transposed());
+
+    Matrix<F31> C = random_modular_matrix<2147483647>(19, 150);
+    Matrix<F31> D = random_modular_matrix<2147483647>(150, 35);
+    ASSERT_EQ(multiply_classic(C, D), modular_reference(C, D));
+
+    Matrix<F61> E = random_modular_matrix<2305843009213693951ull>(13, 140);
+    Matrix<F61> F = random_modular_matrix<2305843009213693951ull>(140, 9);
+    ASSERT_EQ(multiply_classic(E, F), modular_reference(E, F));
+
+    // small modulus, many products are summed before reduction
+    Matrix<Mod<7>> G = Matrix<Mod<7>>(random_int_matrix(11, 200, 6));
+    Matrix<Mod<7>> H = Matrix<Mod<7>>(random_int_matrix(200, 17, 6));
+    ASSERT_EQ(multiply_classic(G, H), modular_reference(G, H));
+}
+
+TEST(Modular, FastAlgorithms) {
+    // over a finite field fast algorithms are exact
+    Matrix<F31> A = random_modular_matrix<2147483647>(211, 230);
+    Matrix<F31> B = random_modular_matrix<2147483647>(230, 205);
+    Matrix<F31> C = multiply_classic(A, B);
+
+    ASSERT_EQ(multiply_strassen_dynamic(A, B), C);
+    ASSERT_EQ(multiply_strassen_static(A, B), C);
+    ASSERT_EQ(multiply_laderman(A, B), C);
+}
@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+
+#include "helpers.hpp"
+
+#include "multiply_classic.hpp"
+#include "morton_matrix.hpp"
+#include "matrix.hpp"
+
+TEST(Morton, Layout) {
+    for (unsigned int split : {2u, 3u}) {
+        for (unsigned int levels : {0u, 1u, 2u, 3u}) {
+            Matrix<int> A = random_int_matrix(37, 52);
+            MortonMatrix<int> morton = MortonMatrix<int>::from_matrix(A, split, levels);
+            ASSERT_EQ(morton.to_matrix(), A);
+            // less than one row (column) of padding per tile
+            ASSERT_LT(morton.tiles_per_side() * morton.tile_rows - A.rows, morton.tiles_per_side());
+            ASSERT_LT(morton.tiles_per_side() * morton.tile_cols - A.cols, morton.tiles_per_side());
+        }
+    }
+
+    // every block of a level is one contiguous range: last block of 2 x 2 split is the
+    // recursive layout of the bottom right quarter with one level less
+    Matrix<int> A = random_int_matrix(64, 48);
+    MortonMatrix<int> morton = MortonMatrix<int>::from_matrix(A, 2, 3);
+    MortonMatrix<int> quarter = MortonMatrix<int>::from_matrix(A.subblock({32, 24}, {32, 24}), 2, 2);
+    ASSERT_TRUE(std::equal(quarter.data.begin(), quarter.data.end(), morton.data.begin() + 3 * morton.data.size() / 4));
+
+    // tiles of 2 x 2 blocks are in Z-order
+    ASSERT_EQ(morton.tile_index(0, 1), 1u);
+    ASSERT_EQ(morton.tile_index(1, 0), 2u);
+    ASSERT_EQ(morton.tile_index(2, 2), 12u);
+}
+
+TEST(Morton, Products) {
+    Matrix<int> A = random_int_matrix(437, 411);
+    Matrix<int> B = random_int_matrix(411, 423);
+    Matrix<int> C = multiply_classic(A, B);
+
+    ASSERT_EQ(multiply_morton(A, B), C);
+    ASSERT_EQ(multiply_morton(A, B, Algorithm::laderman), C);
+    ASSERT_EQ(multiply_morton(A, B, Algorithm::classic), C);
+
+    // products stay in recursive layout
+    MortonMatrix<int> morton_A = MortonMatrix<int>::from_matrix(A, 3, 2);
+    MortonMatrix<int> morton_B = MortonMatrix<int>::from_matrix(B, 3, 2);
+    ASSERT_EQ(multiply_morton(morton_A, morton_B, laderman_scheme()).to_matrix(), C);
+}
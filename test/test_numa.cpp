@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#include "helpers.hpp"
+
+#include "multiply_classic.hpp"
+#include "numa.hpp"
+#include "matrix.hpp"
+
+TEST(Numa, Topology) {
+    ASSERT_EQ(parse_cpu_list("0-3,8,10-11\n"), std::vector<unsigned int>({0, 1, 2, 3, 8, 10, 11}));
+    ASSERT_TRUE(parse_cpu_list("").empty());
+
+    // node 1 has no CPUs (memory only), node 2 is not online
+    char directory[] = "/tmp/fast_matrix_multiplication_numa_XXXXXX";
+    ASSERT_NE(mkdtemp(directory), nullptr);
+    std::string root = directory;
+    mkdir((root + "/node0").c_str(), 0755);
+    mkdir((root + "/node1").c_str(), 0755);
+    std::ofstream(root + "/online") << "0-1" << std::endl;
+    std::ofstream(root + "/node0/cpulist") << "0" << std::endl;
+    std::ofstream(root + "/node1/cpulist") << "" << std::endl;
+
+    NumaTopology topology = NumaTopology::detect(root);
+    ASSERT_EQ(topology.nodes, std::vector<unsigned int>({0}));
+    ASSERT_EQ(topology.cpu_count(), 1u);
+    std::system(("rm -r " + root).c_str());
+
+    // missing directory means one node with all CPUs
+    NumaTopology fallback = NumaTopology::detect("/nonexistent");
+    ASSERT_EQ(fallback.nodes.size(), 1u);
+    ASSERT_GE(fallback.cpu_count(), 1u);
+    ASSERT_GE(NumaTopology::detect().cpu_count(), 1u);
+}
+
+TEST(Numa, Placement) {
+    NumaTopology topology = NumaTopology::detect();
+    Matrix<double> A = numa_zeros<double>(300, 700, topology);
+    ASSERT_EQ(A, Matrix<double>::zeros(300, 700));
+
+    // placement is only a hint, contents do not change
+    Matrix<double> B = random_float_matrix(400, 500);
+    Matrix<double> copy = B;
+    numa_place(B, topology, NumaPlacement::interleaved);
+    numa_place(B, topology, NumaPlacement::local);
+    ASSERT_EQ(B, copy);
+
+    // memory of small matrices may be in the heap, whose addresses are reused, so it is never bound
+    ASSERT_FALSE(numa_place(B, topology, NumaPlacement::local));
+}
+
+TEST(Numa, LargePlacement) {
+    NumaTopology topology = NumaTopology::detect();
+
+    // mbind() may not be allowed (for example in containers), then nothing can be placed
+    std::vector<char> probe(numa_min_placed_bytes);
+    const bool supported = numa_bind_memory(probe.data(), probe.data() + probe.size(), numa_policy_bind,
+                                            {topology.nodes[0]});
+
+    // the smallest square matrix of doubles that is placed
+    const unsigned int n = 2048;
+    ASSERT_EQ(std::size_t(n) * n * sizeof(double), numa_min_placed_bytes);
+    Matrix<double> A = numa_zeros<double>(n, n, topology);
+    ASSERT_EQ(A, Matrix<double>::zeros(n, n));
+    if (supported) {
+        // first band of rows is bound to the first node (policy of the page at given address, MPOL_F_ADDR)
+        const unsigned long policy_of_address = 1ul << 1;
+        int policy = -1;
+        ASSERT_EQ(::syscall(SYS_get_mempolicy, &policy, nullptr, 0, A.data.data() + n, policy_of_address), 0);
+        ASSERT_EQ(policy, numa_policy_bind);
+    }
+
+    Matrix<double> B = random_float_matrix(n, n);
+    Matrix<double> copy = B;
+    ASSERT_EQ(numa_place(B, topology, NumaPlacement::interleaved), supported);
+    ASSERT_EQ(numa_place(B, topology, NumaPlacement::local), supported);
+    ASSERT_EQ(B, copy);
+}
+
+TEST(Numa, Strassen) {
+    NumaTopology topology = NumaTopology::detect();
+    Matrix<double> A = random_float_matrix(431, 415);
+    Matrix<double> B = random_float_matrix(415, 427);
+    Matrix<double> C = multiply_classic(A, B);
+
+    // more workers than products (groups with several workers) and fewer workers than products
+    for (unsigned int threads : {1u, 3u, 9u}) {
+        NumaOptions options;
+        options.threads = threads;
+        ASSERT_LT(maximum_relative_difference(C, multiply_strassen_numa(A, B, topology, options)), 1e-12);
+        options.placement = NumaPlacement::interleaved;
+        ASSERT_LT(maximum_relative_difference(C, multiply_strassen_numa(A, B, topology, options)), 1e-12);
+    }
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+
+#include "helpers.hpp"
+
+#include "mapped_matrix.hpp"
+#include "multiply_classic.hpp"
+#include "multiply_out_of_core.hpp"
+#include "matrix.hpp"
+
+TEST(MappedMatrix, Basic) {
+    std::string path = "/tmp/fast_matrix_multiplication_test_mapped.bin";
+    Matrix<int> A = random_int_matrix(37, 53);
+
+    {
+        MappedMatrix<int> mapped = MappedMatrix<int>::from_matrix(path, A);
+        ASSERT_EQ(mapped.to_matrix(), A);
+
+        // blocks are views of the same file
+        MappedMatrix<int> block = mapped.block({3, 5}, {10, 20});
+        ASSERT_EQ(block.to_matrix(), A.subblock({3, 5}, {10, 20}));
+        ASSERT_EQ(block.load({1, 2}, {4, 4}), A.subblock({4, 7}, {4, 4}));
+
+        block.block_add({0, 0}, Matrix<int>(10, 20, 1), -1);
+        mapped.flush();
+    }
+
+    // changes are written back to the file
+    A.block_subtract({3, 5}, Matrix<int>(10, 20, 1));
+    ASSERT_EQ(MappedMatrix<int>::open(path, 37, 53).to_matrix(), A);
+
+    std::remove(path.c_str());
+}
+
+TEST(OutOfCore, Tiled) {
+    // no recursion on disk, only tiles
+    OutOfCoreOptions options;
+    options.memory_budget = 12 * 16 * 16 * sizeof(int);
+    options.max_levels = 0;
+
+    Matrix<int> A = random_int_matrix(70, 45), B = random_int_matrix(45, 33);
+    MappedMatrix<int> mapped_A = MappedMatrix<int>::temporary(70, 45),
+            mapped_B = MappedMatrix<int>::temporary(45, 33),
+            mapped_C = MappedMatrix<int>::temporary(70, 33);
+    mapped_A.store({0, 0}, A);
+    mapped_B.store({0, 0}, B);
+
+    multiply_out_of_core(mapped_A, mapped_B, mapped_C, options);
+    ASSERT_EQ(mapped_C.to_matrix(), multiply_classic(A, B));
+}
+
+TEST(OutOfCore, Strassen) {
+    // small memory budget forces two levels of Strassen's algorithm on disk, odd sizes need peeling
+    OutOfCoreOptions options;
+    options.memory_budget = 12 * 20 * 20 * sizeof(int);
+    options.algorithm = Algorithm::strassen;
+
+    Matrix<int> A = random_int_matrix(131, 97), B = random_int_matrix(97, 115);
+    MappedMatrix<int> mapped_A = MappedMatrix<int>::temporary(131, 97),
+            mapped_B = MappedMatrix<int>::temporary(97, 115),
+            mapped_C = MappedMatrix<int>::temporary(131, 115);
+    mapped_A.store({0, 0}, A);
+    mapped_B.store({0, 0}, B);
+
+    multiply_out_of_core(mapped_A, mapped_B, mapped_C, options);
+    ASSERT_EQ(mapped_C.to_matrix(), multiply_classic(A, B));
+
+    // C is overwritten, not accumulated
+    multiply_out_of_core(mapped_A, mapped_B, mapped_C, options);
+    ASSERT_EQ(mapped_C.to_matrix(), multiply_classic(A, B));
+}
+
+TEST(OutOfCore, Laderman) {
+    OutOfCoreOptions options;
+    options.memory_budget = 12 * 10 * 10 * sizeof(double);
+    options.algorithm = Algorithm::laderman;
+
+    Matrix<double> A = random_float_matrix(100, 64), B = random_float_matrix(64, 71);
+    MappedMatrix<double> mapped_A = MappedMatrix<double>::temporary(100, 64),
+            mapped_B = MappedMatrix<double>::temporary(64, 71);
+    mapped_A.store({0, 0}, A);
+    mapped_B.store({0, 0}, B);
+
+    std::string path = "/tmp/fast_matrix_multiplication_test_product.bin";
+    MappedMatrix<double> mapped_C = multiply_out_of_core(mapped_A, mapped_B, path, options);
+
+    // small integers, so result is exact
+    ASSERT_EQ(mapped_C.to_matrix(), multiply_classic(A, B));
+
+    std::remove(path.c_str());
+}
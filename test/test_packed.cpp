@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+
+#include "helpers.hpp"
+
+#include "algorithm.hpp"
+#include "multiply_classic.hpp"
+#include "packed_operand.hpp"
+#include "matrix.hpp"
+
+TEST(Packed, Algorithms) {
+    // odd sizes need peeling of inner rows and columns of B
+    Matrix<int> B = random_int_matrix(613, 509);
+    const Algorithm algorithms[] = {Algorithm::classic, Algorithm::strassen, Algorithm::laderman,
+                                    Algorithm::rectangular};
+    for (Algorithm algorithm : algorithms) {
+        PackedOperand<int> packed = pack_operand(B, algorithm, 421);
+        Matrix<int> A = random_int_matrix(421, 613);
+        ASSERT_EQ(multiply_packed(A, packed), multiply_classic(A, B));
+    }
+
+    // two levels of Strassen's algorithm store 7 * 7 combinations of 1/16 of B
+    // (200 x 200 blocks are multiplied classically)
+    Matrix<int> square = random_int_matrix(800, 800);
+    PackedOperand<int> packed = pack_operand(square, Algorithm::strassen, 800);
+    ASSERT_EQ(packed.products.size(), 7u);
+    ASSERT_EQ(packed.products[0].products.size(), 7u);
+    ASSERT_EQ(packed.size(), 49u * 200 * 200);
+}
+
+TEST(Packed, DifferentRows) {
+    // recursion plan is fixed by the packed operand, rows of A are padded to fit it
+    Matrix<double> B = random_float_matrix(801, 900);
+    PackedOperand<double> packed = pack_operand(B, Algorithm::strassen, 800);
+    const unsigned int rows[] = {1, 3, 250, 801, 1203};
+    for (unsigned int r : rows) {
+        Matrix<double> A = random_float_matrix(r, 801);
+        ASSERT_EQ(multiply_packed(A, packed), multiply_classic(A, B));
+    }
+}
+
+TEST(Packed, Transposed) {
+    Matrix<int> B = random_int_matrix(530, 470), A = random_int_matrix(450, 530);
+    PackedOperand<int> packed = pack_operand(B.transposed(), Algorithm::rectangular, 450, Op::transpose);
+    ASSERT_EQ(multiply_packed(A, packed), multiply_classic(A, B));
+}
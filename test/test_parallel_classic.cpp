@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "helpers.hpp"
+
+#include "matrix_power.hpp"
+#include "modular.hpp"
+#include "multiply_chain.hpp"
+#include "multiply_classic.hpp"
+#include "multiply_gram.hpp"
+#include "packed_operand.hpp"
+#include "semiring.hpp"
+#include "thread_pool.hpp"
+#include "matrix.hpp"
+
+// op(A) op(B) calculated by serial classic kernel and by parallel kernel on given pool
+template<class Scalar, class Semiring = PlusTimes<Scalar>>
+void check_parallel_classic(const Matrix<Scalar> &A, const Matrix<Scalar> &B, Op op_A, Op op_B, ThreadPool &pool,
+                            const Semiring &semiring = Semiring()) {
+    const unsigned int rows = op_rows(A, op_A), cols = op_cols(B, op_B), inner = op_cols(A, op_A);
+    Matrix<Scalar> expected(rows, cols, semiring.zero()), C(rows, cols, semiring.zero());
+
+    classic_kernel(rows, cols, inner, A.data.data(), A.cols, op_A, B.data.data(), B.cols, op_B,
+                   expected.data.data(), expected.cols, semiring);
+    classic_kernel_parallel(rows, cols, inner, A.data.data(), A.cols, op_A, B.data.data(), B.cols, op_B,
+                            C.data.data(), C.cols, semiring, pool);
+    ASSERT_EQ(C, expected);
+}
+
+TEST(ParallelClassic, Tiles) {
+    ThreadPool pool(4);
+
+    // 2D tiles of C, with partial tiles at the bottom and on the right
+    Matrix<int> A = random_int_matrix(301, 257), B = random_int_matrix(257, 1100);
+    check_parallel_classic(A, B, Op::none, Op::none, pool);
+
+    // transposed operands are packed per task (A) and per column tile (B)
+    check_parallel_classic(A, B.transposed(), Op::none, Op::transpose, pool);
+    check_parallel_classic(A.transposed(), B, Op::transpose, Op::none, pool);
+    check_parallel_classic(A.transposed(), B.transposed(), Op::transpose, Op::transpose, pool);
+
+    // whole op(B) in a single column tile is read in place
+    B = random_int_matrix(257, 100);
+    A = random_int_matrix(2000, 257);
+    check_parallel_classic(A, B, Op::none, Op::none, pool);
+}
+
+TEST(ParallelClassic, InnerSlices) {
+    ThreadPool pool(4);
+
+    // C is too small for all threads, the inner dimension is split and slices are summed
+    Matrix<int> A = random_int_matrix(8, 40000), B = random_int_matrix(40000, 9);
+    check_parallel_classic(A, B, Op::none, Op::none, pool);
+    check_parallel_classic(A.transposed(), B.transposed(), Op::transpose, Op::transpose, pool);
+
+    // slices are summed in the semiring (zeros of partial sums are infinities)
+    Matrix<double> F = random_float_matrix(16, 5000), G = random_float_matrix(5000, 64);
+    check_parallel_classic(F, G, Op::none, Op::none, pool, MinPlus<double>());
+    check_parallel_classic(F, G, Op::none, Op::none, pool, MaxPlus<double>());
+}
+
+TEST(ParallelClassic, Modular) {
+    ThreadPool pool(3);
+
+    // tiles use kernels for Z/pZ
+    typedef Mod<998244353> F30;
+    Matrix<F30> A(random_int_matrix(150, 400, 1000000)), B(random_int_matrix(400, 130, 1000000));
+    check_parallel_classic(A, B, Op::none, Op::none, pool);
+}
+
+TEST(ParallelClassic, DefaultPool) {
+    // multiply_classic() uses the default pool
+    ThreadPool pool(4);
+    set_default_thread_pool(&pool);
+
+    Matrix<int> A = random_int_matrix(200, 300), B = random_int_matrix(300, 250);
+    Matrix<int> C = multiply_classic(A, B);
+    set_default_thread_pool(nullptr);
+
+    ASSERT_EQ(C, multiply_classic(A, B));
+    ASSERT_GT(pool.stats().tasks_run, 0);
+
+    // or pool given by the caller
+    ThreadPool other(3);
+    ASSERT_EQ(multiply_classic(A, B, Op::none, Op::none, other), C);
+    ASSERT_GT(other.stats().tasks_run, 0);
+}
+
+TEST(ParallelClassic, ClassicPaths) {
+    // products that other functions calculate classically are split between threads too
+    ThreadPool pool(4);
+    set_default_thread_pool(&pool);
+    Matrix<int> A = random_int_matrix(300, 200), B = random_int_matrix(200, 250), D = random_int_matrix(250, 150);
+
+    pool.reset_stats();
+    Matrix<int> chain = multiply_chain(std::vector<Matrix<int>>{A, B, D}, Algorithm::classic);
+    ASSERT_GT(pool.stats().tasks_run, 0);
+
+    pool.reset_stats();
+    Matrix<int> S = random_int_matrix(200, 200, 1);
+    Matrix<int> power = matrix_power(S, 3, Algorithm::classic);
+    ASSERT_GT(pool.stats().tasks_run, 0);
+
+    pool.reset_stats();
+    Matrix<int> gram = multiply_gram(A, Triangle::lower, Algorithm::classic);
+    ASSERT_GT(pool.stats().tasks_run, 0);
+
+    pool.reset_stats();
+    Matrix<int> packed = multiply_packed(A, pack_operand(B, Algorithm::classic, A.rows));
+    ASSERT_GT(pool.stats().tasks_run, 0);
+    set_default_thread_pool(nullptr);
+
+    ASSERT_EQ(chain, multiply_classic(multiply_classic(A, B), D));
+    ASSERT_EQ(power, multiply_classic(multiply_classic(S, S), S));
+    Matrix<int> full = multiply_classic(A, A, Op::none, Op::transpose);
+    for (unsigned int i = 0; i < A.rows; ++i) {
+        for (unsigned int j = i + 1; j < A.rows; ++j) {
+            full.data[std::size_t(i) * A.rows + j] = 0;
+        }
+    }
+    ASSERT_EQ(gram, full);
+    ASSERT_EQ(packed, multiply_classic(A, B));
+}
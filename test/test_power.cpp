@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+#include "helpers.hpp"
+
+#include "matrix_power.hpp"
+#include "multiply_classic.hpp"
+#include "matrix.hpp"
+
+TEST(Power, Square) {
+    // odd sizes need peeling
+    Matrix<int> A = random_int_matrix(901, 901, 3);
+    Matrix<int> expected = multiply_classic(A, A);
+    ASSERT_EQ(multiply_square(A), expected);
+    ASSERT_EQ(multiply_square(A, Algorithm::laderman), expected);
+    ASSERT_EQ(multiply_square(A, Algorithm::rectangular), expected);
+    ASSERT_EQ(multiply_square(A, Algorithm::classic), expected);
+}
+
+TEST(Power, Exponents) {
+    Matrix<int> A = random_int_matrix(230, 230, 1);
+
+    // identity and A itself
+    Matrix<int> expected = Matrix<int>::zeros(230, 230);
+    for (unsigned int i = 0; i < 230; ++i) {
+        expected.data[i * 230 + i] = 1;
+    }
+    ASSERT_EQ(matrix_power(A, 0), expected);
+
+    // integer overflow wraps around the same way in every order of products
+    for (unsigned int exponent = 1; exponent <= 13; ++exponent) {
+        expected = multiply_classic(expected, A);
+        ASSERT_EQ(matrix_power(A, exponent), expected);
+    }
+    ASSERT_EQ(matrix_power(A, 13, Algorithm::classic), expected);
+}
+
+TEST(Power, Markov) {
+    // random walk on a cycle with self loops converges to the uniform distribution
+    const unsigned int n = 401;
+    Matrix<double> P = Matrix<double>::zeros(n, n);
+    for (unsigned int i = 0; i < n; ++i) {
+        P.data[i * n + i] = 0.5;
+        P.data[i * n + (i + 1) % n] = 0.25;
+        P.data[i * n + (i + n - 1) % n] = 0.25;
+    }
+    Matrix<double> power = matrix_power(P, 1ull << 20);
+    for (double probability : power.data) {
+        ASSERT_NEAR(probability, 1.0 / n, 1e-6);
+    }
+}
+
+TEST(Power, Workspace) {
+    // steps of the same size write into the same memory of the result and of the workspace
+    Matrix<int> A = random_int_matrix(450, 450, 1), power = A, next;
+    PowerWorkspace<int> workspace;
+    auto buffers = [&]() {
+        std::vector<const int *> pointers = {power.data.data(), next.data.data()};
+        for (const PowerLevel<int> &level : workspace.levels) {
+            for (const auto *matrices : {&level.A_blocks, &level.B_blocks, &level.combinations}) {
+                for (const Matrix<int> &M : *matrices) {
+                    pointers.push_back(M.data.data());
+                }
+            }
+            pointers.push_back(level.P.data.data());
+        }
+        return pointers;
+    };
+
+    Matrix<int> expected = A;
+    std::vector<const int *> first;
+    for (unsigned int step = 0; step < 4; ++step) {
+        // power = power^2 A
+        multiply_square(power, Algorithm::strassen, next, workspace);
+        std::swap(power, next);
+        power_step(power, &A, Algorithm::strassen, next, workspace);
+        std::swap(power, next);
+        expected = multiply_classic(multiply_classic(expected, expected), A);
+        ASSERT_EQ(power, expected);
+
+        if (step == 0) {
+            first = buffers();
+        } else {
+            ASSERT_EQ(buffers(), first);
+        }
+    }
+    // 450 -> 225 -> 112 (classic)
+    ASSERT_EQ(workspace.levels.size(), 2);
+}
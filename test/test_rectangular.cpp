@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include "helpers.hpp"
+
+#include "algorithm.hpp"
+#include "multiply_classic.hpp"
+#include "multiply_laderman.hpp"
+#include "multiply_rectangular.hpp"
+#include "multiply_strassen.hpp"
+#include "scheme.hpp"
+#include "matrix.hpp"
+
+TEST(Rectangular, VerifySchemes) {
+    ASSERT_TRUE(verify_scheme(strassen_scheme()));
+    ASSERT_TRUE(verify_scheme(laderman_scheme()));
+    ASSERT_TRUE(verify_scheme(classic_scheme(2, 3, 4)));
+
+    // rank of every composed scheme
+    const unsigned int shapes[][4] = {{2, 2, 3, 11}, {2, 3, 2, 11}, {3, 2, 2, 11}, {2, 2, 4, 14},
+                                      {2, 4, 2, 14}, {4, 2, 2, 14}, {3, 2, 3, 17}};
+    for (const auto &shape : shapes) {
+        const Scheme *scheme = rectangular_scheme(shape[0], shape[1], shape[2]);
+        ASSERT_NE(scheme, nullptr);
+        ASSERT_EQ(scheme->rank(), shape[3]);
+        ASSERT_TRUE(verify_scheme(*scheme));
+    }
+    ASSERT_EQ(rectangular_scheme(5, 5, 5), nullptr);
+
+    // wrong coefficient
+    Scheme broken = strassen_scheme();
+    broken.products[3].c[2] = -1;
+    ASSERT_FALSE(verify_scheme(broken));
+
+    // product left out
+    broken = strassen_scheme();
+    broken.products.pop_back();
+    ASSERT_FALSE(verify_scheme(broken));
+}
+
+TEST(Rectangular, Choice) {
+    // blocks closest to square
+    ASSERT_EQ(&rectangular_scheme_for(1000, 1000, 1000), rectangular_scheme(2, 2, 2));
+    ASSERT_EQ(&rectangular_scheme_for(4000, 1000, 1000), rectangular_scheme(4, 2, 2));
+    ASSERT_EQ(&rectangular_scheme_for(1000, 4000, 1000), rectangular_scheme(2, 4, 2));
+    ASSERT_EQ(&rectangular_scheme_for(3000, 2000, 3000), rectangular_scheme(3, 2, 3));
+
+    // small products are multiplied classically
+    ASSERT_EQ(rectangular_choice(5000, 5000, 150), nullptr);
+    ASSERT_NE(rectangular_choice(2000, 500, 500), nullptr);
+}
+
+TEST(Rectangular, Schemes) {
+    // every scheme on every level, odd sizes need peeling
+    Matrix<int> A = random_int_matrix(613, 421), B = random_int_matrix(421, 509);
+    Matrix<int> C = multiply_classic(A, B);
+
+    for (const Scheme &scheme : rectangular_schemes()) {
+        ASSERT_EQ(multiply_scheme(A, B, scheme), C);
+    }
+    ASSERT_EQ(multiply_scheme(A, B, laderman_scheme()), C);
+}
+
+TEST(Rectangular, Random) {
+    for (unsigned int i = 0; i < 5; ++i) {
+        unsigned int rows = std::rand() % 1500 + 1;
+        unsigned int inner = std::rand() % 500 + 1;
+        unsigned int cols = std::rand() % 500 + 1;
+        Matrix<int> A = random_int_matrix(rows, inner), B = random_int_matrix(inner, cols);
+
+        ASSERT_EQ(multiply_rectangular(A, B), multiply_classic(A, B));
+    }
+
+    // tall times wide
+    Matrix<int> A = random_int_matrix(1700, 450), B = random_int_matrix(450, 230);
+    ASSERT_EQ(multiply_rectangular(A, B), multiply_classic(A, B));
+    ASSERT_EQ(multiply(A, B, Algorithm::rectangular), multiply_classic(A, B));
+}
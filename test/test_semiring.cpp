@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <limits>
+
+#include "helpers.hpp"
+
+#include "multiply_classic.hpp"
+#include "multiply_laderman.hpp"
+#include "multiply_strassen.hpp"
+#include "semiring.hpp"
+#include "matrix.hpp"
+
+// product over semiring with three nested loops
+template<class Scalar, class Semiring>
+Matrix<Scalar> semiring_reference(const Matrix<Scalar> &A, const Matrix<Scalar> &B, const Semiring &semiring) {
+    Matrix<Scalar> C(A.rows, B.cols, semiring.zero());
+    for (unsigned int i = 0; i < A.rows; ++i) {
+        for (unsigned int j = 0; j < B.cols; ++j) {
+            for (unsigned int k = 0; k < A.cols; ++k) {
+                C[{i, j}] = semiring.add(C[{i, j}], semiring.multiply(A[{i, k}], B[{k, j}]));
+            }
+        }
+    }
+    return C;
+}
+
+// fast algorithms are not available for semirings without subtraction
+static_assert(PlusTimes<double>::has_subtraction && !MinPlus<double>::has_subtraction &&
+              !MaxPlus<int>::has_subtraction, "only ordinary arithmetic has subtraction");
+
+TEST(Semiring, PlusTimes) {
+    Matrix<double> A = random_float_matrix(37, 45);
+    Matrix<double> B = random_float_matrix(45, 29);
+    ASSERT_EQ(multiply_classic(A, B, PlusTimes<double>()), multiply_classic(A, B));
+
+    Matrix<int> C = random_int_matrix(210, 205);
+    Matrix<int> D = random_int_matrix(205, 203);
+    ASSERT_EQ(multiply_strassen_dynamic(C, D, PlusTimes<int>()), multiply_classic(C, D));
+    ASSERT_EQ(multiply_laderman(C, D, PlusTimes<int>()), multiply_classic(C, D));
+}
+
+TEST(Semiring, Tropical) {
+    // sizes that leave remainders of SIMD tiles, some entries are infinite
+    Matrix<double> A = random_float_matrix(23, 150, 100);
+    Matrix<double> B = random_float_matrix(150, 35, 100);
+    A.data[5] = B.data[7] = std::numeric_limits<double>::infinity();
+
+    ASSERT_EQ(multiply_classic(A, B, MinPlus<double>()), semiring_reference(A, B, MinPlus<double>()));
+    ASSERT_EQ(multiply_classic(A, B, MaxPlus<double>()), semiring_reference(A, B, MaxPlus<double>()));
+    ASSERT_EQ(multiply_classic(B, A, MinPlus<double>(), Op::transpose, Op::transpose),
+              semiring_reference(A, B, MinPlus<double>()).transposed());
+
+    Matrix<float> F(A), G(B);
+    ASSERT_EQ(multiply_classic(F, G, MinPlus<float>()), semiring_reference(F, G, MinPlus<float>()));
+    ASSERT_EQ(multiply_classic(F, G, MaxPlus<float>()), semiring_reference(F, G, MaxPlus<float>()));
+
+    // integers use their largest value as infinity, which does not overflow
+    Matrix<int> C = random_int_matrix(19, 40, 100);
+    Matrix<int> D = random_int_matrix(40, 21, 100);
+    C.data[0] = D.data[0] = MinPlus<int>::zero();
+    ASSERT_EQ(multiply_classic(C, D, MinPlus<int>()), semiring_reference(C, D, MinPlus<int>()));
+}
+
+TEST(Semiring, ShortestPaths) {
+    // (min, +) powers of distance matrix give all shortest paths, compared with Floyd-Warshall
+    const unsigned int n = 60;
+    Matrix<double> D = random_float_matrix(n, n, 1000);
+    for (unsigned int i = 0; i < n; ++i) {
+        for (unsigned int j = 0; j < n; ++j) {
+            if (i == j) {
+                D[{i, j}] = 0;
+            } else if (int(D[{i, j}]) % 4 != 0) {
+                D[{i, j}] = MinPlus<double>::zero();
+            }
+        }
+    }
+
+    Matrix<double> floyd = D;
+    for (unsigned int k = 0; k < n; ++k) {
+        for (unsigned int i = 0; i < n; ++i) {
+            for (unsigned int j = 0; j < n; ++j) {
+                floyd[{i, j}] = std::min(floyd[{i, j}], floyd[{i, k}] + floyd[{k, j}]);
+            }
+        }
+    }
+
+    Matrix<double> paths = D;
+    for (unsigned int length = 1; length < n; length *= 2) {
+        paths = multiply_classic(paths, paths, MinPlus<double>());
+    }
+    ASSERT_EQ(paths, floyd);
+}
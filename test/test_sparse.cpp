@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "helpers.hpp"
+
+#include "multiply_classic.hpp"
+#include "multiply_strassen.hpp"
+#include "sparse.hpp"
+#include "matrix.hpp"
+
+// random matrix where given fraction of entries is nonzero
+Matrix<int> random_sparse_matrix(unsigned int rows, unsigned int cols, double density) {
+    static std::mt19937 generator(35);
+    std::uniform_real_distribution<double> chance(0, 1);
+    std::uniform_int_distribution<int> value(-9, 9);
+
+    Matrix<int> A = Matrix<int>::zeros(rows, cols);
+    for (int &element : A.data) {
+        if (chance(generator) < density) {
+            element = value(generator);
+        }
+    }
+    return A;
+}
+
+TEST(Sparse, Csr) {
+    Matrix<int> A = random_sparse_matrix(47, 53, 0.05);
+    CsrMatrix<int> sparse = CsrMatrix<int>::from_matrix(A);
+
+    ASSERT_EQ(sparse.nonzeros(), matrix_nonzeros(A));
+    ASSERT_DOUBLE_EQ(sparse.density(), matrix_density(A));
+    ASSERT_EQ(sparse.to_matrix(), A);
+    ASSERT_TRUE(Matrix<int>::zeros(3, 4).is_zero());
+    ASSERT_FALSE(A.is_zero());
+}
+
+TEST(Sparse, Products) {
+    Matrix<int> A = random_sparse_matrix(61, 70, 0.04);
+    Matrix<int> B = random_sparse_matrix(70, 45, 0.08);
+    Matrix<int> D = random_int_matrix(70, 45);
+    Matrix<int> E = random_int_matrix(38, 61);
+    CsrMatrix<int> sparse_A = CsrMatrix<int>::from_matrix(A), sparse_B = CsrMatrix<int>::from_matrix(B);
+
+    ASSERT_EQ(multiply_sparse_dense(sparse_A, D), multiply_classic(A, D));
+    ASSERT_EQ(multiply_dense_sparse(E, sparse_A), multiply_classic(E, A));
+
+    CsrMatrix<int> product = multiply_sparse(sparse_A, sparse_B);
+    ASSERT_EQ(product.to_matrix(), multiply_classic(A, B));
+    ASSERT_EQ(product.nonzeros(), matrix_nonzeros(product.to_matrix()));
+    for (unsigned int i = 0; i < product.rows; ++i) {
+        ASSERT_TRUE(std::is_sorted(product.col_index.begin() + product.row_start[i],
+                                   product.col_index.begin() + product.row_start[i + 1]));
+    }
+}
+
+TEST(Sparse, BlockSparse) {
+    // dense blocks on the diagonal and one block below it
+    Matrix<int> A = Matrix<int>::zeros(100, 90);
+    A.block_add({0, 0}, random_int_matrix(32, 32));
+    A.block_add({64, 64}, random_int_matrix(32, 26));
+    A.block_add({96, 32}, random_int_matrix(4, 32));
+    Matrix<int> B = A.transposed();
+
+    BlockSparseMatrix<int> block_A = BlockSparseMatrix<int>::from_matrix(A, 32);
+    BlockSparseMatrix<int> block_B = BlockSparseMatrix<int>::from_matrix(B, 32);
+    ASSERT_EQ(block_A.nonzero_blocks(), 3u);
+    ASSERT_EQ(block_A.to_matrix(), A);
+
+    BlockSparseMatrix<int> product = multiply_block_sparse(block_A, block_B);
+    ASSERT_EQ(product.to_matrix(), multiply_classic(A, B));
+    ASSERT_EQ(product.nonzero_blocks(), 3u);
+}
+
+TEST(Sparse, Routing) {
+    // sparse times dense, dense times sparse and dense matrices with large zero blocks
+    Matrix<int> S = random_sparse_matrix(430, 410, 0.02);
+    Matrix<int> D = random_int_matrix(410, 420);
+    ASSERT_EQ(multiply_sparse_aware(S, D), multiply_classic(S, D));
+    ASSERT_EQ(multiply_sparse_aware(D.transposed(), S.transposed()), multiply_classic(D.transposed(), S.transposed()));
+
+    Matrix<int> A = Matrix<int>::zeros(450, 430);
+    A.block_add({0, 0}, random_int_matrix(220, 215));
+    A.block_add({225, 215}, random_int_matrix(225, 215));
+    Matrix<int> B = random_int_matrix(430, 441);
+    ASSERT_EQ(multiply_sparse_aware(A, B), multiply_classic(A, B));
+    ASSERT_EQ(multiply_strassen_dynamic(A, B), multiply_classic(A, B));
+    ASSERT_EQ(multiply_strassen_static(A, B), multiply_classic(A, B));
+
+    ASSERT_TRUE(multiply_sparse_aware(Matrix<int>::zeros(300, 300), B.subblock({0, 0}, {300, 300})).is_zero());
+}
@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 
+#include <cmath>
+#include <limits>
+
 #include "helpers.hpp"
 
 #include "multiply_strassen.hpp"
@@ -83,6 +86,23 @@ TEST(StrassenStatic, Large) {
     ASSERT_EQ(multiply_classic(A, B), multiply_strassen_static(A, B));
 }
 
+TEST(StrassenStatic, VirtualPadding) {
+    // dimensions that are not multiples of 2^depth, with transposed operands
+    Matrix<int> A = random_int_matrix(413, 809);
+    Matrix<int> B = random_int_matrix(809, 427);
+    ASSERT_EQ(multiply_classic(A, B), multiply_strassen_static(A, B));
+    ASSERT_EQ(multiply_classic(A, B), multiply_strassen_static(A.transposed(), B.transposed(),
+                                                               Op::transpose, Op::transpose));
+
+    // 3 x 3 matrix padded to 8 x 8: all products except those of top left blocks are skipped
+    Matrix<int> C = random_int_matrix(3, 3);
+    PaddedMatrix<int> padded = {C, 8, 8};
+    PaddedMatrix<int> product = padded_strassen(padded, padded, 3);
+    ASSERT_EQ(product.rows, 8u);
+    ASSERT_EQ(product.stored, multiply_classic(C, C));
+    ASSERT_TRUE(padded.block({4, 0}, {4, 4}).is_padding());
+}
+
 
 TEST(StrassenDynamic, Basic) {
     // few basic tests that can be calculated by hand
@@ -160,3 +180,13 @@ TEST(StrassenDynamic, Large) {
     B = random_int_matrix(321, 21);
     ASSERT_EQ(multiply_classic(A, B), multiply_strassen_dynamic(A, B));
 }
+
+TEST(StrassenDynamic, ZeroOperand) {
+    // zero operand is multiplied like any other, so NaN in the other one propagates as in classic product
+    Matrix<double> A = Matrix<double>::zeros(4, 4), B = Matrix<double>::zeros(4, 4);
+    B.data[5] = std::numeric_limits<double>::quiet_NaN();
+    Matrix<double> C = multiply_strassen_dynamic(A, B);
+    ASSERT_TRUE(std::isnan(C.data[1]));
+    ASSERT_TRUE(std::isnan(multiply_classic(A, B).data[1]));
+    ASSERT_EQ(C.data[0], 0.0);
+}
@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "helpers.hpp"
+
+#include "dynamic_peeling.hpp"
+#include "multiply_classic.hpp"
+#include "thread_pool.hpp"
+#include "matrix.hpp"
+
+TEST(ThreadPool, Deque) {
+    WorkStealingDeque deque(4);
+    std::vector<PoolTask> tasks(10);
+    for (PoolTask &task : tasks) {
+        deque.push(&task);
+    }
+    ASSERT_EQ(deque.size(), 10);
+
+    // owner takes newest tasks, thieves oldest ones
+    ASSERT_EQ(deque.pop(), &tasks[9]);
+    ASSERT_EQ(deque.steal(), &tasks[0]);
+    ASSERT_EQ(deque.steal(), &tasks[1]);
+    for (unsigned int i = 8; i >= 2; --i) {
+        ASSERT_EQ(deque.pop(), &tasks[i]);
+    }
+    ASSERT_EQ(deque.pop(), nullptr);
+    ASSERT_EQ(deque.steal(), nullptr);
+}
+
+TEST(ThreadPool, ConcurrentSteals) {
+    // every task is taken exactly once, by its owner or by one of the thieves
+    const unsigned int count = 100000;
+    WorkStealingDeque deque;
+    std::vector<PoolTask> tasks(count);
+    std::vector<std::atomic<unsigned int>> taken(count);
+    std::atomic<bool> done{false};
+
+    auto take = [&](PoolTask *task) {
+        if (task != nullptr) {
+            taken[task - tasks.data()]++;
+        }
+    };
+    std::vector<std::thread> thieves;
+    for (unsigned int t = 0; t < 3; ++t) {
+        thieves.emplace_back([&]() {
+            while (!done) {
+                take(deque.steal());
+            }
+        });
+    }
+    for (unsigned int i = 0; i < count; ++i) {
+        deque.push(&tasks[i]);
+        if (i % 3 == 0) {
+            take(deque.pop());
+        }
+    }
+    while (deque.size() > 0) {
+        take(deque.pop());
+    }
+    done = true;
+    for (std::thread &thief : thieves) {
+        thief.join();
+    }
+    for (unsigned int i = 0; i < count; ++i) {
+        ASSERT_EQ(taken[i], 1u);
+    }
+}
+
+// sum of 0, ..., n - 1 with nested groups
+static unsigned long long nested_sum(ThreadPool &pool, unsigned int first, unsigned int last) {
+    if (last - first <= 16) {
+        unsigned long long sum = 0;
+        for (unsigned int i = first; i < last; ++i) {
+            sum += i;
+        }
+        return sum;
+    }
+    unsigned int middle = first + (last - first) / 2;
+    unsigned long long left = 0, right = 0;
+    TaskGroup group(pool);
+    group.run([&]() {
+        left = nested_sum(pool, first, middle);
+    });
+    right = nested_sum(pool, middle, last);
+    group.wait();
+    return left + right;
+}
+
+TEST(ThreadPool, NestedTasks) {
+    ThreadPool pool(3);
+    ASSERT_EQ(pool.threads(), 3u);
+    ASSERT_EQ(nested_sum(pool, 0, 10000), 10000ull * 9999 / 2);
+
+    ThreadPoolStats stats = pool.stats();
+    ASSERT_GT(stats.tasks_submitted, 0u);
+    ASSERT_EQ(stats.tasks_run, stats.tasks_submitted);
+
+    pool.reset_stats();
+    ASSERT_EQ(pool.stats().tasks_run, 0u);
+}
+
+TEST(ThreadPool, ParallelFor) {
+    ThreadPool pool(2);
+    std::vector<unsigned int> values(1000, 0);
+    parallel_for(0, 1000, 64, [&values](unsigned int first, unsigned int last) {
+        for (unsigned int i = first; i < last; ++i) {
+            values[i] = i * i;
+        }
+    }, pool);
+    for (unsigned int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(values[i], i * i);
+    }
+    ASSERT_EQ(pool.stats().tasks_run, 16u);
+}
+
+TEST(ThreadPool, Exceptions) {
+    ThreadPool pool(2);
+    TaskGroup group(pool);
+    group.run([]() {
+        throw std::runtime_error("task failed");
+    });
+    group.run([]() {});
+    ASSERT_THROW(group.wait(), std::runtime_error);
+}
+
+TEST(ThreadPool, DefaultPool) {
+    // algorithms use pool installed by the caller, peeled panels are one of its tasks
+    ThreadPool pool(2);
+    set_default_thread_pool(&pool);
+    ASSERT_EQ(&default_thread_pool(), &pool);
+
+    Matrix<int> A = random_int_matrix(3001, 1001), B = random_int_matrix(1001, 3001);
+    Matrix<int> C = Matrix<int>::zeros(3001, 3001);
+    {
+        TaskGroup group;
+        dynamic_peeling_start(A, B, C, 2, 2, group);
+        group.wait();
+    }
+    set_default_thread_pool(nullptr);
+    ASSERT_EQ(pool.stats().tasks_run, 1u);
+
+    ASSERT_EQ(C.subblock({3000, 0}, {1, 3001}), multiply_classic(A.subblock({3000, 0}, {1, 1001}), B));
+    ASSERT_EQ(C.subblock({0, 3000}, {3001, 1}), multiply_classic(A, B.subblock({0, 3000}, {1001, 1})));
+    ASSERT_TRUE(C.subblock({0, 0}, {3000, 3000}).is_zero());
+}
+
+TEST(ThreadPool, Scopes) {
+    ThreadPool installed(2), scoped(1);
+    set_default_thread_pool(&installed);
+
+    // scope affects only the calling thread, tasks of a pool use the pool they run in
+    {
+        ThreadPoolScope scope(scoped);
+        ASSERT_EQ(&default_thread_pool(), &scoped);
+
+        ThreadPool *other_thread = nullptr;
+        std::thread([&other_thread]() {
+            other_thread = &default_thread_pool();
+        }).join();
+        ASSERT_EQ(other_thread, &installed);
+
+        ThreadPool *in_task = nullptr;
+        TaskGroup group(installed);
+        group.run([&in_task]() {
+            in_task = &default_thread_pool();
+        });
+        group.wait();
+        // the task may also run in this thread while it waits for the group
+        ASSERT_TRUE(in_task == &installed || in_task == &scoped);
+    }
+    ASSERT_EQ(&default_thread_pool(), &installed);
+    set_default_thread_pool(nullptr);
+}
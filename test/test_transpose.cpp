@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include "helpers.hpp"
+
+#include "dynamic_peeling.hpp"
+#include "multiply_bini.hpp"
+#include "multiply_classic.hpp"
+#include "multiply_laderman.hpp"
+#include "multiply_strassen.hpp"
+#include "matrix.hpp"
+
+// transpose by definition, used to check blocked transpose
+template<class Scalar>
+Matrix<Scalar> naive_transpose(const Matrix<Scalar> &A) {
+    Matrix<Scalar> T = Matrix<Scalar>::zeros(A.cols, A.rows);
+    for (unsigned int i = 0; i < A.rows; ++i) {
+        for (unsigned int j = 0; j < A.cols; ++j) {
+            T[{j, i}] = A[{i, j}];
+        }
+    }
+    return T;
+}
+
+TEST(Transpose, Basic) {
+    Matrix<int> A({1, 2, 3, 4, 5, 6}, 2, 3);
+
+    ASSERT_EQ(A.transposed(), Matrix<int>({1, 4, 2, 5, 3, 6}, 3, 2));
+    ASSERT_EQ(A.transposed().transposed(), A);
+}
+
+TEST(Transpose, Blocked) {
+    // sizes around tile boundaries and odd sizes (SIMD remainders)
+    for (unsigned int rows : {1u, 2u, 3u, 31u, 32u, 33u, 67u}) {
+        for (unsigned int cols : {1u, 4u, 5u, 32u, 65u}) {
+            Matrix<int> A = random_int_matrix(rows, cols);
+            Matrix<double> D = random_float_matrix(rows, cols);
+            Matrix<float> F = Matrix<float>(D);
+
+            ASSERT_EQ(A.transposed(), naive_transpose(A));
+            ASSERT_EQ(D.transposed(), naive_transpose(D));
+            ASSERT_EQ(F.transposed(), naive_transpose(F));
+        }
+    }
+}
+
+TEST(Transpose, Subblock) {
+    Matrix<int> A = random_int_matrix(40, 50);
+
+    // block of A^T is transposed block of A
+    ASSERT_EQ(A.subblock({3, 7}, {20, 11}, Op::transpose), A.subblock({7, 3}, {11, 20}).transposed());
+
+    // block_add with transposed block
+    Matrix<int> C = Matrix<int>::zeros(50, 40), B = random_int_matrix(11, 20);
+    C.block_add({3, 7}, B, Op::transpose);
+    C.block_subtract({3, 7}, B.transposed());
+    ASSERT_EQ(C, Matrix<int>::zeros(50, 40));
+}
+
+TEST(Transpose, Classic) {
+    // all four combinations of op(A) op(B)
+    Matrix<int> A = random_int_matrix(37, 300), B = random_int_matrix(300, 530);
+    Matrix<int> correct = multiply_classic(A, B);
+    Matrix<int> At = A.transposed(), Bt = B.transposed();
+
+    ASSERT_EQ(multiply_classic(At, B, Op::transpose, Op::none), correct);
+    ASSERT_EQ(multiply_classic(A, Bt, Op::none, Op::transpose), correct);
+    ASSERT_EQ(multiply_classic(At, Bt, Op::transpose, Op::transpose), correct);
+}
+
+TEST(Transpose, FastAlgorithms) {
+    // Test a few larger matrices, A^T B and A B^T
+    Matrix<int> A, B, correct;
+
+    A = random_int_matrix(431, 417);
+    B = random_int_matrix(417, 423);
+    correct = multiply_classic(A, B);
+
+    Matrix<int> At = A.transposed(), Bt = B.transposed();
+
+    ASSERT_EQ(multiply_strassen_dynamic(At, B, Op::transpose, Op::none), correct);
+    ASSERT_EQ(multiply_strassen_dynamic(A, Bt, Op::none, Op::transpose), correct);
+    ASSERT_EQ(multiply_strassen_static(At, Bt, Op::transpose, Op::transpose), correct);
+    ASSERT_EQ(multiply_laderman(At, Bt, Op::transpose, Op::transpose), correct);
+    ASSERT_EQ(multiply_laderman(At, B, Op::transpose, Op::none), correct);
+}
+
+TEST(Transpose, Bini) {
+    // second half of Bini's algorithm runs on transposed blocks
+    Matrix<int> A = random_int_matrix(203, 201), B = random_int_matrix(201, 603);
+
+    ASSERT_EQ(multiply_bini_exact(A.transposed(), B, Op::transpose, Op::none), multiply_classic(A, B));
+
+    Matrix<double> Ad = random_float_matrix(213, 211), Bd = random_float_matrix(211, 620);
+
+    ASSERT_LE(
+            maximum_relative_difference(
+                    multiply_classic(Ad, Bd),
+                    multiply_bini(Ad, Bd.transposed(), 1e-4, Op::none, Op::transpose)),
+            0.01
+    );
+}
+
+TEST(Transpose, DynamicPeeling) {
+    // peeling adds everything except the product of included blocks, operands are read in place
+    Matrix<int> A = random_int_matrix(23, 17), B = random_int_matrix(17, 19);
+    Matrix<int> At = A.transposed(), Bt = B.transposed();
+
+    for (unsigned int split : {2u, 3u, 4u}) {
+        Matrix<int> included = multiply_classic(A.subblock({0, 0}, {23 / split * split, 17 / split * split}),
+                                                B.subblock({0, 0}, {17 / split * split, 19 / split * split}));
+        Matrix<int> C = Matrix<int>::zeros(23, 19);
+        C.block_add({0, 0}, included);
+
+        Matrix<int> C_transposed = C;
+        dynamic_peeling(A, B, C, split, split, split);
+        ASSERT_EQ(C, multiply_classic(A, B));
+
+        TaskGroup peeling;
+        dynamic_peeling_start(At, Bt, C_transposed, split, split, peeling, Op::transpose, Op::transpose);
+        dynamic_peeling_update(At, Bt, C_transposed, split, split, split, Op::transpose, Op::transpose);
+        peeling.wait();
+        ASSERT_EQ(C_transposed, multiply_classic(A, B));
+    }
+}